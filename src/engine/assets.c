@@ -102,6 +102,7 @@ ASSET_PACK* load_asset_pack(const char* fpath) {
 
     
     int assetType = -1;       
+    bool genFlipped = false;
 
     int count = 0;
     
@@ -131,6 +132,11 @@ ASSET_PACK* load_asset_pack(const char* fpath) {
                 snprintf(filePath, BUFFER_SIZE, "%s", value);
                 
             }
+            // Generate flipped bitmaps
+            else if(strcmp(param,"$flip") == 0) {
+
+                genFlipped = strtol(value, NULL, 10) != 0;
+            }
         }
         else if(wr->buffer[0] != '$') {
 
@@ -146,6 +152,11 @@ ASSET_PACK* load_asset_pack(const char* fpath) {
 
                     return NULL;
                 }
+                if(assetType == T_BITMAP && genFlipped 
+                 && bitmap_gen_flipped((_BITMAP*)p->objects[p->assetCount]) == 1) {
+
+                    return NULL;
+                }
                 p->types[p->assetCount] = assetType;
                 strcpy(p->names[p->assetCount].data, name);
                 ++ p->assetCount;
@@ -202,10 +213,10 @@ void assets_destroy(ASSET_PACK* p) {
             destroy_tilemap((TILEMAP*)obj);
             break;
         case T_SAMPLE:
-            //destroy_sample((SAMPLE*)obj);
+            destroy_sample((SAMPLE*)obj);
             break;
         case T_MUSIC:
-            //destroy_music((MUSIC*)obj);
+            destroy_music((MUSIC*)obj);
             break;
 
         default:
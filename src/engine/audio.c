@@ -4,13 +4,34 @@
 
 #include "audio.h"
 
+#include "voice.h"
+#include "mixer.h"
+
 #include <SDL2/SDL_mixer.h>
 
 #include "../include/system.h"
 
 
+// Buffer size limits
+static const int BUFFER_MIN = 64;
+static const int BUFFER_MAX = 8192;
+
+
 // Initialize audio
-int init_audio() {
+int init_audio(int bufferSize, int voices, bool softMixer) {
+
+    // Not configured
+    if(bufferSize == 0) bufferSize = AUDIO_BUFFER_DEFAULT;
+    if(voices <= 0) voices = AUDIO_VOICES_DEFAULT;
+
+    // Must be a power of two
+    if(bufferSize < BUFFER_MIN || bufferSize > BUFFER_MAX
+     || (bufferSize & (bufferSize-1)) != 0) {
+
+        printf("Invalid audio buffer size %d, using %d.\n",
+            bufferSize, AUDIO_BUFFER_DEFAULT);
+        bufferSize = AUDIO_BUFFER_DEFAULT;
+    }
 
     // Init formats
     int flags = MIX_INIT_OGG;
@@ -22,11 +43,46 @@ int init_audio() {
     }
 
     // Open audio
-    if(Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 512) == -1)  {     
+    if(Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, bufferSize) == -1)  {     
 
         error_throw("Failed to open audio!",NULL);
         return 1;
     }
 
+    // One channel per voice
+    voices_init(voices);
+    Mix_AllocateChannels(voices_count());
+
+    // The software mixer needs 16-bit stereo
+    int freq = 0;
+    int channels = 0;
+    Uint16 format = 0;
+    if(softMixer) {
+
+        if(Mix_QuerySpec(&freq, &format, &channels) != 0
+         && format == AUDIO_S16SYS && channels == 2) {
+
+            mixer_init(freq, true);
+        }
+        else {
+
+            printf("Audio format not supported by the software mixer, using SDL_mixer.\n");
+        }
+    }
+
     return 0;
 }
+
+
+// Close audio
+void destroy_audio() {
+
+    if(mixer_enabled()) {
+
+        mixer_print_stats();
+        mixer_destroy();
+    }
+
+    Mix_CloseAudio();
+    Mix_Quit();
+}
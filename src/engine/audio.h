@@ -5,7 +5,19 @@
 #ifndef __AUDIO__
 #define __AUDIO__
 
-// Initialize audio
-int init_audio();
+#include <stdbool.h>
+
+// Default audio buffer size (sample frames)
+#define AUDIO_BUFFER_DEFAULT 512
+// Default voice count
+#define AUDIO_VOICES_DEFAULT 16
+
+// Initialize audio. The buffer size is in sample
+// frames, a power of two. The software mixer plays
+// the samples if "softMixer" is set
+int init_audio(int bufferSize, int voices, bool softMixer);
+
+// Close audio
+void destroy_audio();
 
 #endif // __AUDIO__
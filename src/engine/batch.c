@@ -0,0 +1,194 @@
+// GOAT
+// Sprite batch (source)
+// (c) 2018 Jani Nykänen
+
+#include "batch.h"
+
+#include "graphics.h"
+
+#include "../include/std.h"
+
+#include <stdint.h>
+
+// Draw record
+typedef struct {
+
+    _BITMAP* bmp;
+    int sx, sy, sw, sh;
+    int dx, dy; // Translation included
+    int flip;
+    int fade; // 0 if not fading
+    Uint8 color;
+    int layer;
+    int index; // Insertion order
+}
+BATCH_RECORD;
+
+// Records
+static BATCH_RECORD* records;
+static int capacity;
+// Record count
+static int recordCount;
+
+
+// Compare records
+static int compare_records(const void* a, const void* b) {
+
+    const BATCH_RECORD* r1 = (const BATCH_RECORD*)a;
+    const BATCH_RECORD* r2 = (const BATCH_RECORD*)b;
+
+    if(r1->layer != r2->layer)
+        return r1->layer < r2->layer ? -1 : 1;
+
+    if(r1->bmp != r2->bmp)
+        return (uintptr_t)r1->bmp < (uintptr_t)r2->bmp ? -1 : 1;
+
+    return r1->index - r2->index;
+}
+
+
+// Is the record fully inside the frame
+static bool is_inside(BATCH_RECORD* r, FRAME* f) {
+
+    // Horizontally flipped regions are drawn one pixel
+    // to the right
+    int hshift = (r->flip & FLIP_H) != 0 ? 1 : 0;
+
+    return r->dx >= 0 && r->dy >= 0 
+        && r->dx + r->sw + hshift <= f->width
+        && r->dy + r->sh <= f->height
+        && r->sx >= 0 && r->sy >= 0
+        && r->sx + r->sw <= r->bmp->width
+        && r->sy + r->sh <= r->bmp->height;
+}
+
+
+// Make room for one more record. Returns 1 on error
+static int reserve() {
+
+    if(recordCount < capacity) return 0;
+
+    int cap = capacity > 0 ? capacity * 2 : BATCH_SIZE;
+    BATCH_RECORD* r = (BATCH_RECORD*)realloc(records, sizeof(BATCH_RECORD) * cap);
+    if(r == NULL) return 1;
+
+    records = r;
+    capacity = cap;
+
+    return 0;
+}
+
+
+// Add a record
+static void add_record(_BITMAP* bmp, int sx, int sy, int sw, int sh, int dx, int dy, 
+    int flip, int fade, Uint8 color, int layer) {
+
+    if(bmp == NULL || sw <= 0 || sh <= 0) return;
+
+    // Out of memory, draw what we have (the layers
+    // after this may be out of order)
+    if(reserve() == 1) {
+
+        batch_submit();
+        if(reserve() == 1) return;
+    }
+
+    _POINT tr = get_translation();
+
+    BATCH_RECORD* r = &records[recordCount];
+    r->bmp = bmp;
+    r->sx = sx;
+    r->sy = sy;
+    r->sw = sw;
+    r->sh = sh;
+    r->dx = dx + tr.x;
+    r->dy = dy + tr.y;
+    r->flip = flip;
+    r->fade = fade;
+    r->color = color;
+    r->layer = layer;
+    r->index = recordCount;
+
+    ++ recordCount;
+}
+
+
+// Begin collecting draw records
+void batch_begin() {
+
+    recordCount = 0;
+}
+
+
+// Add a _BITMAP region to the batch
+void batch_add_region(_BITMAP* bmp, int sx, int sy, int sw, int sh, int dx, int dy, int flip, int layer) {
+
+    add_record(bmp, sx, sy, sw, sh, dx, dy, flip, 0, 0, layer);
+}
+
+
+// Add a "fading" _BITMAP region to the batch
+void batch_add_region_fading(_BITMAP* bmp, int sx, int sy, int sw, int sh, int dx, int dy, int flip, 
+    int fade, Uint8 color, int layer) {
+
+    add_record(bmp, sx, sy, sw, sh, dx, dy, flip, fade, color, layer);
+}
+
+
+// Draw the collected records
+void batch_submit() {
+
+    if(recordCount == 0) return;
+
+    FRAME* f = get_global_frame();
+    _POINT oldTr = get_translation();
+    BATCH_RECORD* r;
+    int i = 0;
+
+    qsort(records, recordCount, sizeof(BATCH_RECORD), compare_records);
+
+    int hshift;
+
+    // Records are already translated
+    translate(0, 0);
+    for(; i < recordCount; ++ i) {
+
+        r = &records[i];
+
+        // Cull. Horizontally flipped regions are drawn
+        // one pixel to the right
+        hshift = (r->flip & FLIP_H) != 0 ? 1 : 0;
+        if(r->dx + r->sw + hshift <= 0 || r->dy + r->sh <= 0 
+         || r->dx + hshift >= f->width || r->dy >= f->height)
+            continue;
+
+        if(r->fade > 0) {
+
+            draw_bitmap_region_fading(r->bmp, r->sx, r->sy, r->sw, r->sh, 
+                r->dx, r->dy, r->flip, r->fade, r->color);
+        }
+        else if(is_inside(r, f)) {
+
+            draw_bitmap_region_unclipped(r->bmp, r->sx, r->sy, r->sw, r->sh, 
+                r->dx, r->dy, r->flip);
+        }
+        else {
+
+            draw_bitmap_region(r->bmp, r->sx, r->sy, r->sw, r->sh, 
+                r->dx, r->dy, r->flip);
+        }
+    }
+    translate(oldTr.x, oldTr.y);
+
+    recordCount = 0;
+}
+
+
+// Free the records
+void batch_destroy() {
+
+    free(records);
+    records = NULL;
+    capacity = 0;
+    recordCount = 0;
+}
@@ -0,0 +1,31 @@
+// GOAT
+// Sprite batch (header)
+// (c) 2018 Jani Nykänen
+
+#ifndef __BATCH__
+#define __BATCH__
+
+#include "bitmap.h"
+
+// Initial record capacity. The batch grows, so one
+// frame is always drawn with one sort
+#define BATCH_SIZE 512
+
+// Begin collecting draw records
+void batch_begin();
+
+// Add a _BITMAP region to the batch. Uses the
+// current translation
+void batch_add_region(_BITMAP* bmp, int sx, int sy, int sw, int sh, int dx, int dy, int flip, int layer);
+
+// Add a "fading" _BITMAP region to the batch
+void batch_add_region_fading(_BITMAP* bmp, int sx, int sy, int sw, int sh, int dx, int dy, int flip, 
+    int fade, Uint8 color, int layer);
+
+// Draw the collected records, sorted by layer & bitmap
+void batch_submit();
+
+// Free the records
+void batch_destroy();
+
+#endif // __BATCH__
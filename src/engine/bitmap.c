@@ -79,8 +79,52 @@ _BITMAP* bitmap_load(const char* path) {
     bmp->width = (Uint16)w;
     bmp->height = (Uint16)h;
 
+    bmp->flipped[0] = NULL;
+    bmp->flipped[1] = NULL;
+    bmp->flipped[2] = NULL;
+
     // Free data
     stbi_image_free(pdata);
 
     return bmp;
-}
\ No newline at end of file
+}
+
+
+// Generate flipped copies of a bitmap
+int bitmap_gen_flipped(_BITMAP* bmp) {
+
+    int i, x, y;
+    int w = bmp->width;
+    int h = bmp->height;
+    int flip;
+    _BITMAP* f;
+
+    for(i = 0; i < 3; ++ i) {
+
+        if(bmp->flipped[i] != NULL) continue;
+
+        f = bitmap_create(w, h);
+        if(f == NULL) return 1;
+
+        flip = i+1;
+        for(y = 0; y < h; ++ y) {
+
+            Uint8* src = bmp->data + ((flip & FLIP_V) ? h-1-y : y) * w;
+            Uint8* dst = f->data + y * w;
+
+            if(flip & FLIP_H) {
+
+                for(x = 0; x < w; ++ x)
+                    dst[x] = src[w-1-x];
+            }
+            else {
+
+                memcpy(dst, src, w);
+            }
+        }
+
+        bmp->flipped[i] = f;
+    }
+
+    return 0;
+}
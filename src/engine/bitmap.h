@@ -13,6 +13,10 @@ typedef FRAME _BITMAP;
 // Load a bitmap
 _BITMAP* bitmap_load(const char* path);
 
+// Generate flipped copies of a bitmap, so flipped
+// regions can be drawn with the forward path
+int bitmap_gen_flipped(_BITMAP* bmp);
+
 // Destroy bitmap
 #define bitmap_destroy(b) frame_destroy((FRAME*)b)
 
@@ -93,6 +93,42 @@ int config_read(CONFIG* c, const char* path) {
 
                 c->sampleVol = (int)strtol(value,NULL,10);
             }
+            else if(strcmp(key,"$audio_buffer") == 0) {
+
+                c->audioBuffer = (int)strtol(value,NULL,10);
+            }
+            else if(strcmp(key,"$audio_voices") == 0) {
+
+                c->audioVoices = (int)strtol(value,NULL,10);
+            }
+            else if(strcmp(key,"$software_mixer") == 0) {
+
+                c->softwareMixer = (int)strtol(value,NULL,10);
+            }
+            else if(strcmp(key,"$software_present") == 0) {
+
+                c->softwarePresent = (int)strtol(value,NULL,10);
+            }
+            else if(strcmp(key,"$present_filter") == 0) {
+
+                c->presentFilter = (int)strtol(value,NULL,10);
+            }
+            else if(strcmp(key,"$present_threads") == 0) {
+
+                c->presentThreads = (int)strtol(value,NULL,10);
+            }
+            else if(strcmp(key,"$leaderboard_address") == 0) {
+
+                snprintf(c->lbAddress, ADDRESS_SIZE, "%s", value);
+            }
+            else if(strcmp(key,"$leaderboard_backend") == 0) {
+
+                c->lbOffline = strcmp(value, "offline") == 0;
+            }
+            else if(strcmp(key,"$autoplay") == 0) {
+
+                c->autoplay = (int)strtol(value,NULL,10);
+            }
 
         }
         // Store the current value to the key
@@ -17,6 +17,9 @@
 // Asset path buffer size
 #define ASSET_PATH_SIZE 128
 
+// Address buffer size
+#define ADDRESS_SIZE 128
+
 // Configuration type
 typedef struct {
 
@@ -27,6 +30,15 @@ typedef struct {
     int frameRate;
     int musicVol;
     int sampleVol;
+    int audioBuffer;
+    int audioVoices;
+    bool softwareMixer;
+    bool softwarePresent;
+    int presentFilter;
+    int presentThreads;
+    bool autoplay;
+    char lbAddress[ADDRESS_SIZE];
+    bool lbOffline;
     char caption[CAPTION_STRING_SIZE];
     char assetPath[ASSET_PATH_SIZE];
     char keyconfPath[ASSET_PATH_SIZE];
@@ -7,11 +7,13 @@
 #include "error.h"
 #include "scene.h"
 #include "input.h"
+#include "present.h"
 
 #include <SDL2/SDL.h>
 
 #include "../include/std.h"
 #include "../include/renderer.h"
+#include "../include/utility.h"
 #include "../include/audio.h"
 
 // Max scenes
@@ -46,6 +48,10 @@ static _POINT canvasPos;
 static _POINT canvasSize;
 // Canvas
 static FRAME* canvas;
+// Canvas scale (software present)
+static int canvasScale;
+// Clear the window surface before the next present
+static bool clearSurface;
 
 // Scenes
 static SCENE scenes[MAX_SCENES];
@@ -63,6 +69,23 @@ static SDL_Joystick* joy;
 // Calculate canvas properties
 static void calculate_canvas_prop(int winWidth, int winHeight) {
 
+    // Software present uses integer scaling only
+    if(conf.softwarePresent) {
+
+        canvasScale = min_2(winWidth / canvas->width, winHeight / canvas->height);
+        if(canvasScale < 1)
+            canvasScale = 1;
+
+        canvasSize.x = canvas->width * canvasScale;
+        canvasSize.y = canvas->height * canvasScale;
+
+        canvasPos.x = winWidth/2 - canvasSize.x/2;
+        canvasPos.y = winHeight/2 - canvasSize.y/2;
+
+        clearSurface = true;
+
+        return;
+    }
  
     // If aspect ratio is bigger or equal to the ratio of the canvas
     if((float)winWidth/(float)winHeight >= (float)canvas->width/ (float)canvas->height) {
@@ -93,6 +116,26 @@ static void core_show_error(const char* msg) {
 }
 
 
+// Create the renderer
+static int core_create_renderer() {
+
+    int flag = conf.vsync ? (SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC) : SDL_RENDERER_ACCELERATED;
+    rend = SDL_CreateRenderer(window,-1,flag);
+    if(rend == NULL) {
+
+        error_throw("Failed to create a renderer!", NULL);
+        return 1;
+    }
+
+    // Clear
+    SDL_SetRenderDrawColor(rend, 0,0,0, 255);
+    SDL_RenderClear(rend);
+    SDL_RenderPresent(rend);
+
+    return 0;
+}
+
+
 // Initialize SDL
 static int core_init_SDL()
 {   
@@ -120,19 +163,25 @@ static int core_init_SDL()
     if(conf.fullscreen)
         core_toggle_fullscreen();
 
+    // Use the window surface instead of a renderer,
+    // if supported. The surface is not created here, a
+    // window with one cannot have a renderer
+    if(conf.softwarePresent 
+    && !present_supports_format(SDL_GetWindowPixelFormat(window))) {
+
+        printf("Window surface format not supported, using the renderer.\n");
+        conf.softwarePresent = false;
+    }
+
     // Create renderer
-    int flag = conf.vsync ? (SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC) : SDL_RENDERER_ACCELERATED;
-    rend = SDL_CreateRenderer(window,-1,flag);
-    if(rend == NULL) {
+    if(conf.softwarePresent) {
 
-        error_throw("Failed to create a renderer!", NULL);
-        return 1;
+        clearSurface = true;
     }
+    else if(core_create_renderer() == 1) {
 
-    // Clear
-    SDL_SetRenderDrawColor(rend, 0,0,0, 255);
-    SDL_RenderClear(rend);
-    SDL_RenderPresent(rend);
+        return 1;
+    }
 
     // Hide mouse cursor
     SDL_ShowCursor(0);
@@ -141,12 +190,16 @@ static int core_init_SDL()
     frameWait = 1000 / conf.frameRate;
 
     // Initialize audio
-    if(init_audio() == 1) {
+    if(init_audio(conf.audioBuffer, conf.audioVoices,
+        conf.softwareMixer) == 1) {
 
         return 1;
     }
     init_samples();
-    init_music();
+    if(init_music() == 1) {
+
+        return 1;
+    }
 
     // Get joystick, if any
     joy = SDL_JoystickOpen(0);
@@ -183,8 +236,14 @@ static int core_init() {
         return 1;
     }
 
-    // Pass canvas to the renderer
-    if(create_canvas_texture(canvas) == 1) {
+    // Pass canvas to the renderer, or prepare the software
+    // present
+    if(conf.softwarePresent) {
+
+        if(present_init(conf.canvasSize, conf.presentThreads) == 1)
+            return 1;
+    }
+    else if(create_canvas_texture(canvas) == 1) {
 
         return 1;
     }
@@ -432,6 +491,23 @@ static void core_draw_to_canvas() {
 // Draw
 static void core_draw() {
 
+    // Software present
+    if(conf.softwarePresent) {
+
+        SDL_Surface* surf = SDL_GetWindowSurface(window);
+        if(surf == NULL || !present_supports_format(surf->format->format)) return;
+
+        // Clear the borders
+        if(clearSurface) {
+
+            SDL_FillRect(surf, NULL, 0);
+            clearSurface = false;
+        }
+
+        present_to_surface(surf, canvasPos, canvasScale, conf.presentFilter);
+        return;
+    }
+
     // Clear
     SDL_SetRenderDrawColor(rend, 0,0,0, 255);
     SDL_RenderClear(rend);
@@ -442,6 +518,16 @@ static void core_draw() {
 }
 
 
+// Show the current frame
+static void core_present() {
+
+    if(conf.softwarePresent)
+        SDL_UpdateWindowSurface(window);
+    else
+        SDL_RenderPresent(rend);
+}
+
+
 // Destroy
 static void core_destroy() {
 
@@ -458,12 +544,23 @@ static void core_destroy() {
         }
     }
 
+    // Free cached text & draw records
+    text_cache_clear();
+    batch_destroy();
+
+    // Close audio
+    quit_music();
+    destroy_audio();
+
     // Close joystick
     //if(joy != NULL)
     //   SDL_JoystickClose(joy);
         
     // Destroy content
-    SDL_DestroyRenderer(rend);
+    if(conf.softwarePresent)
+        present_destroy();
+    else
+        SDL_DestroyRenderer(rend);
     SDL_DestroyWindow(window);
 }
 
@@ -486,7 +583,7 @@ static int core_loop_no_vsync() {
         core_draw();
 
         // Render current frame
-        SDL_RenderPresent(rend);
+        core_present();
 
         // Check errors
         if(has_error()) {
@@ -543,7 +640,7 @@ static int core_loop_vsync() {
 
         // Render current frame
         core_draw();
-        SDL_RenderPresent(rend);
+        core_present();
     }
 
     return 0;
@@ -554,7 +651,8 @@ static int core_loop_vsync() {
 static int core_loop() {
 
     // Loop
-    int (*fun)(void) = conf.vsync ? core_loop_vsync : core_loop_no_vsync;
+    // (Window surfaces have no vsync)
+    int (*fun)(void) = (conf.vsync && !conf.softwarePresent) ? core_loop_vsync : core_loop_no_vsync;
     if(fun() == 1) {
 
         return 1;
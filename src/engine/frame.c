@@ -39,6 +39,10 @@ FRAME* frame_create(Uint16 w, Uint16 h) {
     f->width = w;
     f->height = h;
 
+    f->flipped[0] = NULL;
+    f->flipped[1] = NULL;
+    f->flipped[2] = NULL;
+
     return f;
 }
 
@@ -48,6 +52,12 @@ void frame_destroy(FRAME* f) {
 
     if(f == NULL) return;
 
+    int i = 0;
+    for(; i < 3; ++ i) {
+
+        frame_destroy(f->flipped[i]);
+    }
+
     if(f->data != NULL)
         free(f->data);
         
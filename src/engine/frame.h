@@ -8,12 +8,16 @@
 #include <SDL2/SDL.h>
 
 // Frame type
-typedef struct {
+typedef struct _FRAME {
 
     Uint8* data;
     Uint16 width;
     Uint16 height;
 
+    // Pre-flipped copies (horizontal, vertical, both),
+    // NULL if not generated
+    struct _FRAME* flipped[3];
+
 }
 FRAME;
 
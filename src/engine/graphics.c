@@ -9,6 +9,11 @@
 
 #include "../include/std.h"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define USE_AVX2_GATHER
+#endif
+
 // Darkness palette size
 #define DARKNESS_PALATTE_SIZE 7
 
@@ -30,6 +35,23 @@ static _POINT tr;
 // Darkness palette
 static Uint8 dpalette[DARKNESS_PALATTE_SIZE] [256];
 
+// Output palette (RGB332 to ARGB8888)
+static Uint32 outPalette[256];
+// Present lookup table. The first half is used for pixels
+// with an even x+y, the second half for the odd ones
+// (dithered darkness)
+static Uint32 presentLut[512];
+// Palette darkness & tint for the current frame
+static int palDark;
+static Uint32 palTint;
+static Uint8 palTintAmount;
+// Values the lookup table was built with
+static int lutDark = -1;
+static Uint32 lutTint;
+static Uint8 lutTintAmount;
+// Use the AVX2 expansion routine
+static bool useAVX2;
+
 // Used texture
 static _BITMAP* gtex;
 // UV coordinates
@@ -150,6 +172,128 @@ static void gen_darkness_palettes() {
 }
 
 
+// Generate the output palette
+static void gen_output_palette() {
+
+    // Same bit expansion SDL uses for RGB332
+    const Uint8 EXPAND3[] = {0, 36, 72, 109, 145, 182, 218, 255};
+    const Uint8 EXPAND2[] = {0, 85, 170, 255};
+
+    int i = 0;
+    for(; i < 256; ++ i) {
+
+        outPalette[i] = 0xFF000000
+            | (EXPAND3[i >> 5] << 16)
+            | (EXPAND3[(i >> 2) & 7] << 8)
+            | EXPAND2[i & 3];
+    }
+}
+
+
+// Apply tint to an output color
+static Uint32 tint_color(Uint32 c, Uint32 tint, int amount) {
+
+    int shift = 0;
+    int a, b;
+    Uint32 out = 0xFF000000;
+    for(; shift <= 16; shift += 8) {
+
+        a = (c >> shift) & 0xFF;
+        b = (tint >> shift) & 0xFF;
+        out |= (Uint32)(a + (b-a) * amount / 255) << shift;
+    }
+
+    return out;
+}
+
+
+// Rebuild the present lookup table, if the
+// palette effects have changed
+static void update_present_lut() {
+
+    if(palDark == lutDark && palTint == lutTint && palTintAmount == lutTintAmount)
+        return;
+
+    int i = 0;
+    int even = palDark / 2;
+    int odd = palDark % 2 == 0 ? even : even +1;
+    for(; i < 256; ++ i) {
+
+        presentLut[i] = outPalette[dpalette[even][i]];
+        presentLut[256 + i] = outPalette[dpalette[odd][i]];
+
+        if(palTintAmount > 0) {
+
+            presentLut[i] = tint_color(presentLut[i], palTint, palTintAmount);
+            presentLut[256 + i] = tint_color(presentLut[256 + i], palTint, palTintAmount);
+        }
+    }
+
+    lutDark = palDark;
+    lutTint = palTint;
+    lutTintAmount = palTintAmount;
+}
+
+
+// Expand a row of 8-bit pixels to ARGB8888. Parity is 0
+// if the first pixel has an even x+y
+static void expand_row(Uint32* dst, const Uint8* src, int w, int parity) {
+
+    const Uint32* l0 = presentLut + (parity ? 256 : 0);
+    const Uint32* l1 = presentLut + (parity ? 0 : 256);
+
+    int x = 0;
+    for(; x < w-1; x += 2) {
+
+        dst[x] = l0[src[x]];
+        dst[x+1] = l1[src[x+1]];
+    }
+    if(x < w)
+        dst[x] = l0[src[x]];
+}
+
+
+#ifdef USE_AVX2_GATHER
+// Expand a row of 8-bit pixels to ARGB8888, AVX2 gather
+__attribute__((target("avx2")))
+static void expand_row_avx2(Uint32* dst, const Uint8* src, int w, int parity) {
+
+    // Odd pixels (x+y) use the second half of the table
+    const __m256i offset = parity 
+        ? _mm256_setr_epi32(256,0,256,0,256,0,256,0)
+        : _mm256_setr_epi32(0,256,0,256,0,256,0,256);
+
+    __m256i idx;
+    int x = 0;
+    for(; x + 8 <= w; x += 8) {
+
+        idx = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(src + x)));
+        idx = _mm256_add_epi32(idx, offset);
+        _mm256_storeu_si256((__m256i*)(dst + x), 
+            _mm256_i32gather_epi32((const int*)presentLut, idx, 4));
+    }
+
+    // The rest
+    if(x < w)
+        expand_row(dst + x, src + x, w - x, parity);
+}
+#endif
+
+
+// Expand a canvas row with the present lookup table
+static void present_row(Uint32* dst, const Uint8* src, int w, int parity) {
+
+#ifdef USE_AVX2_GATHER
+    if(useAVX2) {
+
+        expand_row_avx2(dst, src, w, parity);
+        return;
+    }
+#endif
+    expand_row(dst, src, w, parity);
+}
+
+
 // Get texture color
 static Uint8 get_color_dark(int dvalue, int x, int y, Uint8 col) {
 
@@ -217,6 +361,31 @@ static bool clip(_BITMAP* bmp, int* dx, int* dy, int* sx, int* sy, int* sw, int*
 }
 
 
+// Use a pre-flipped copy of the bitmap, if one exists. The
+// source region is mirrored and the flip flags cleared
+static _BITMAP* use_flipped(_BITMAP* bmp, int* sx, int* sy, int sw, int sh, int* dx, int* flip) {
+
+    if(*flip == FLIP_NONE || bmp->flipped[*flip -1] == NULL)
+        return bmp;
+
+    if((*flip & FLIP_H) != 0) {
+
+        *sx = bmp->width - *sx - sw;
+        // Flipped draws are one pixel to the right
+        ++ *dx;
+    }
+    if((*flip & FLIP_V) != 0) {
+
+        *sy = bmp->height - *sy - sh;
+    }
+
+    bmp = bmp->flipped[*flip -1];
+    *flip = FLIP_NONE;
+
+    return bmp;
+}
+
+
 // Initialize
 void graphics_init(SDL_Renderer* rend) {
 
@@ -224,6 +393,17 @@ void graphics_init(SDL_Renderer* rend) {
     tr = point(0, 0);
 
     gen_darkness_palettes();
+    gen_output_palette();
+
+    palDark = 0;
+    palTintAmount = 0;
+    update_present_lut();
+
+#ifdef USE_AVX2_GATHER
+    useAVX2 = SDL_HasAVX2() == SDL_TRUE;
+#else
+    useAVX2 = false;
+#endif
 }
 
 
@@ -259,9 +439,10 @@ Uint8 get_alpha() {
 // Use frame to create a canvas texture
 int create_canvas_texture(FRAME* f) {
 
-    // Create canvas
+    // Create canvas. The 8-bit canvas is expanded to 32 bits
+    // by us, so the driver does not have to convert it
     texCanvas = SDL_CreateTexture(grend, 
-        SDL_PIXELFORMAT_RGB332, SDL_TEXTUREACCESS_STREAMING, 
+        SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, 
         f->width, f->height);
     
     if(texCanvas == NULL) {
@@ -278,8 +459,31 @@ void update_canvas_texture() {
 
     gframe = usedFrame;
 
+    // No texture if the software present is used
+    if(texCanvas == NULL)
+        return;
+
+    // Palette effects
+    update_present_lut();
+
     // Update texture
-    SDL_UpdateTexture(texCanvas, NULL, gframe->data, gframe->width);
+    void* pixels;
+    int pitch;
+    if(SDL_LockTexture(texCanvas, NULL, &pixels, &pitch) != 0)
+        return;
+
+    int y = 0;
+    for(; y < gframe->height; ++ y) {
+
+        present_row((Uint32*)((Uint8*)pixels + y*pitch), 
+            gframe->data + y*gframe->width, gframe->width, y % 2);
+    }
+
+    SDL_UnlockTexture(texCanvas);
+
+    // Palette effects last one frame
+    palDark = 0;
+    palTintAmount = 0;
 }
 
 
@@ -292,6 +496,30 @@ void draw_canvas_texture(_POINT pos, _POINT size) {
 }
 
 
+// Prepare the canvas for the software present
+void canvas_present_begin() {
+
+    update_present_lut();
+}
+
+
+// Expand a canvas row to ARGB8888
+void canvas_present_row(Uint32* dst, int y) {
+
+    FRAME* f = usedFrame;
+    present_row(dst, f->data + y*f->width, f->width, y % 2);
+}
+
+
+// Finish the software present
+void canvas_present_end() {
+
+    // Palette effects last one frame
+    palDark = 0;
+    palTintAmount = 0;
+}
+
+
 // Fill rectangle
 void fill_rect(int x, int y, int w, int h, Uint8 color) {
 
@@ -346,6 +574,8 @@ void draw_bitmap_region(_BITMAP* bmp, int sx, int sy, int sw, int sh,
 
     if(bmp == NULL) return;
 
+    bmp = use_flipped(bmp, &sx, &sy, sw, sh, &dx, &flip);
+
     dx += tr.x;
     dy += tr.y;
 
@@ -412,6 +642,54 @@ void draw_bitmap_region(_BITMAP* bmp, int sx, int sy, int sw, int sh,
 }
 
 
+// Draw a _BITMAP region that is known to be inside
+// the frame, no clipping or bound checks
+void draw_bitmap_region_unclipped(_BITMAP* bmp, int sx, int sy, int sw, int sh, 
+    int dx, int dy, int flip) {
+
+    bmp = use_flipped(bmp, &sx, &sy, sw, sh, &dx, &flip);
+
+    dx += tr.x;
+    dy += tr.y;
+
+    bool hflip = (flip & FLIP_H) != 0;
+    bool vflip = (flip & FLIP_V) != 0;
+
+    // Horizontally flipped regions are drawn one pixel to
+    // the right, like in draw_bitmap_region
+    int step = vflip ? -gframe->width : gframe->width;
+    Uint8* dst = gframe->data + (vflip ? dy+sh-1 : dy) * gframe->width + dx;
+    const Uint8* src = bmp->data + sy * bmp->width + sx;
+
+    Uint8 col;
+    int x,y;
+    for(y=0; y < sh; ++ y) {
+
+        if(hflip) {
+
+            for(x=0; x < sw; ++ x) {
+
+                col = src[x];
+                if(col != alpha)
+                    dst[sw-x] = col;
+            }
+        }
+        else {
+
+            for(x=0; x < sw; ++ x) {
+
+                col = src[x];
+                if(col != alpha)
+                    dst[x] = col;
+            }
+        }
+
+        src += bmp->width;
+        dst += step;
+    }
+}
+
+
 // Draw a "fading" _BITMAP
 // (For performance reasons I don't add one "super method" for
 //  both this and normal region drawing)
@@ -421,6 +699,8 @@ void draw_bitmap_region_fading(_BITMAP* bmp, int sx, int sy, int sw, int sh,
 
     if(bmp == NULL) return;
 
+    bmp = use_flipped(bmp, &sx, &sy, sw, sh, &dx, &flip);
+
     dx += tr.x;
     dy += tr.y;
 
@@ -527,27 +807,75 @@ void draw_bitmap_region_fast(_BITMAP* bmp,
 }
 
 
+// Draw a glyph without clipping (the caller has
+// already checked that the whole string fits the frame)
+static void draw_glyph_unclipped(_BITMAP* font, int sx, int sy, int cw, int ch, int dx, int dy) {
+
+    Uint8* src = font->data + sy * font->width + sx;
+    Uint8* dst = gframe->data + dy * gframe->width + dx;
+
+    Uint8 col;
+    int x, y;
+    for(y = 0; y < ch; ++ y) {
+
+        for(x = 0; x < cw; ++ x) {
+
+            col = src[x];
+            if(col != alpha)
+                dst[x] = col;
+        }
+
+        src += font->width;
+        dst += gframe->width;
+    }
+}
+
+
 // Draw text with a _BITMAP font
 void draw_text(_BITMAP* font, const char* text, 
     int dx, int dy, int xoff, int yoff, bool center) {
 
-    int len = strlen((const char*)text);
-
-    int x = dx;
-    int y = dy;
     int cw = font->width / 16;
     int ch = cw;
-    int i=0;
+    int i = 0;
     unsigned char c;
-    int sx;
-    int sy;
+
+    // Measure the string (length, lines and the longest line)
+    // in one pass
+    int len = 0;
+    int lines = 1;
+    int lineLen = 0;
+    int maxLine = 0;
+    for(; text[len] != '\0'; ++ len) {
+
+        if(text[len] == '\n') {
+
+            ++ lines;
+            lineLen = 0;
+            continue;
+        }
+        if(++ lineLen > maxLine)
+            maxLine = lineLen;
+    }
 
     if(center) {
 
-        dx -= (int) ( ((float)len+1)/2.0f * (float)(cw+xoff) );
-        x = dx;
+        dx -= (len+1) * (cw+xoff) / 2;
     }
 
+    int x = dx;
+    int y = dy;
+
+    // If the whole string is inside the frame, clip once
+    // and skip the per-glyph clipping
+    int left = dx + tr.x;
+    int top = dy + tr.y;
+    int right = left + (maxLine > 0 ? (maxLine-1) * (cw+xoff) + cw : 0);
+    int bottom = top + (lines-1) * (ch+yoff) + ch;
+    bool inside = cw+xoff >= 0 && ch+yoff >= 0 
+        && left >= 0 && top >= 0 
+        && right <= gframe->width && bottom <= gframe->height;
+
     for(; i < len;  ++ i) {
 
         c = text[i];
@@ -558,10 +886,15 @@ void draw_text(_BITMAP* font, const char* text,
             continue;
         }
 
-        sx = c % 16;
-        sy = c / 16;
+        if(inside) {
 
-        draw_bitmap_region(font,sx*cw,sy*ch,cw,ch,x,y, FLIP_NONE);
+            // Glyphs outside the font _BITMAP are skipped, like in
+            // the clipped path
+            if((c / 16)*ch + ch <= font->height)
+                draw_glyph_unclipped(font, (c % 16)*cw, (c / 16)*ch, cw, ch, x + tr.x, y + tr.y);
+        }
+        else
+            draw_bitmap_region(font,(c % 16)*cw,(c / 16)*ch,cw,ch,x,y, FLIP_NONE);
 
         x += cw + xoff;
     }
@@ -794,6 +1127,13 @@ void translate(int x, int y) {
 }
 
 
+// Get translation
+_POINT get_translation() {
+
+    return tr;
+}
+
+
 // Set the render target
 void set_render_target(_BITMAP* target) {
 
@@ -822,6 +1162,25 @@ void darken(int d) {
     }
 }
 
+
+// Darken the screen on output (palette swap)
+void set_palette_darkness(int d) {
+
+    if(d < 0) d = 0;
+    if(d > 12) d = 12;
+
+    palDark = d;
+}
+
+
+// Tint the screen on output (palette swap)
+void set_palette_tint(Uint8 r, Uint8 g, Uint8 b, Uint8 amount) {
+
+    palTint = 0xFF000000 | (r << 16) | (g << 8) | b;
+    palTintAmount = amount;
+}
+
+
 // Set uv coordinates
 void set_uv_coords(float u1, float v1, float u2, float v2, float u3, float v3) {
 
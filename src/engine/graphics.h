@@ -47,6 +47,15 @@ void update_canvas_texture();
 // Draw canvas texture
 void draw_canvas_texture(_POINT pos, _POINT size);
 
+// Prepare the canvas for the software present
+void canvas_present_begin();
+
+// Expand a canvas row to ARGB8888 (with palette effects)
+void canvas_present_row(Uint32* dst, int y);
+
+// Finish the software present
+void canvas_present_end();
+
 // Fill rectangle
 void fill_rect(int x, int y, int w, int h, Uint8 color);
 
@@ -56,6 +65,10 @@ void draw_bitmap(_BITMAP* bmp, int x, int y, int flip);
 // Draw a _BITMAP region
 void draw_bitmap_region(_BITMAP* bmp, int sx, int sy, int sw, int sh, int dx, int dy, int flip);
 
+// Draw a _BITMAP region that is known to be inside
+// the frame, no clipping or bound checks
+void draw_bitmap_region_unclipped(_BITMAP* bmp, int sx, int sy, int sw, int sh, int dx, int dy, int flip);
+
 // Draw a "fading" _BITMAP
 void draw_bitmap_region_fading(_BITMAP* bmp, int sx, int sy, int sw, int sh, int dx, int dy, int flip, int fade, Uint8 color);
 
@@ -83,12 +96,23 @@ FRAME* get_global_frame();
 // Translate
 void translate(int x, int y);
 
+// Get translation
+_POINT get_translation();
+
 // Set the render target
 void set_render_target(_BITMAP* target);
 
 // Darken the whole screen
 void darken(int d);
 
+// Darken the screen on output (palette swap). Lasts
+// until the canvas texture is updated
+void set_palette_darkness(int d);
+
+// Tint the screen on output (palette swap), amount 0-255. 
+// Lasts until the canvas texture is updated
+void set_palette_tint(Uint8 r, Uint8 g, Uint8 b, Uint8 amount);
+
 // Set uv coordinates
 void set_uv_coords(float u1, float v1, float u2, float v2, float u3, float v3);
 
@@ -4,6 +4,11 @@
 
 #include "mathext.h"
 
+#include <math.h>
+
+// Sine table, one extra entry for interpolation
+static float sineTable[SINE_TABLE_SIZE +1];
+
 
 // Minimum (out of 3)
 int min_3(int a, int b, int c) {
@@ -114,4 +119,27 @@ bool inside_triangle(int px, int py, int x1, int y1, int x2, int y2, int x3, int
     if( ((x3-x2)*(py-y2)-(y3-y2)*(px-x2) > 0) != s_ab) return false;
  
     return true;
-}
\ No newline at end of file
+}
+
+
+// Compute the sine table
+void init_sine_table() {
+
+    int i = 0;
+    for(; i <= SINE_TABLE_SIZE; ++ i) {
+
+        sineTable[i] = sinf((float)i / SINE_TABLE_SIZE * 2.0f * M_PI);
+    }
+}
+
+
+// Sine from the table
+float table_sin(float angle) {
+
+    float p = angle * (SINE_TABLE_SIZE / (2.0f * M_PI));
+    float f = floorf(p);
+    float t = p - f;
+    int i = (int)((long)f & (SINE_TABLE_SIZE-1));
+
+    return sineTable[i] + (sineTable[i+1] - sineTable[i]) * t;
+}
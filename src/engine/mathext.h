@@ -12,6 +12,9 @@
 #define M_PI 3.14159265359f
 #endif 
 
+// Sine table size (power of two)
+#define SINE_TABLE_SIZE 1024
+
 // Minimum (out of 3)
 int min_3(int a, int b, int c);
 
@@ -39,6 +42,12 @@ float max_2f(float a, float b);
 // Order three points, compare y axis
 void order_points_y_3(_POINT* a, _POINT* b, _POINT* c);
 
+// Compute the sine table
+void init_sine_table();
+
+// Sine from the table, linearly interpolated
+float table_sin(float angle);
+
 // Is inside triangle
 bool inside_triangle(int px, int py, int x1, int y1, int x2, int y2, int x3, int y3);
 
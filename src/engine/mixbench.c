@@ -0,0 +1,229 @@
+// GOAT
+// Software mixer bench (source)
+// (c) 2018 Jani Nykänen
+
+#include "mixbench.h"
+
+#include "mixer.h"
+
+#include "../include/std.h"
+#include "../include/system.h"
+
+// Output frequency
+#define FREQUENCY 44100
+// Frames per buffer
+#define BUFFER_FRAMES 512
+// Synthetic sounds
+#define SOUND_COUNT 4
+
+// Defaults for the command line
+static const int DEFAULT_VOICES = 16;
+static const int DEFAULT_SECONDS = 10;
+
+// Sound lengths (frames)
+static const Uint32 SOUND_LENGTHS[SOUND_COUNT] = {
+
+    4410, 11025, 22050, 44100
+};
+
+// Reference voice
+typedef struct {
+
+    const Sint16* data; // NULL if free
+    Uint32 frames;
+    Uint32 pos;
+    Sint32 gainLeft;
+    Sint32 gainRight;
+}
+REF_VOICE;
+
+// Sounds
+static Sint16* sounds[SOUND_COUNT];
+// Reference voices
+static REF_VOICE refVoices[VOICE_MAX];
+// Outputs
+static Sint16 out[BUFFER_FRAMES * 2];
+static Sint16 refOut[BUFFER_FRAMES * 2];
+// Random state
+static Uint32 seed = 1;
+
+
+// Get a random number
+static Uint32 next_random() {
+
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 8;
+}
+
+
+// Get a random number in [0,1)
+static float next_float() {
+
+    return (float)(next_random() & 0xFFFF) / 65536.0f;
+}
+
+
+// Get the time in microseconds
+static double get_time() {
+
+    return (double)SDL_GetPerformanceCounter() * 1000000.0
+        / (double)SDL_GetPerformanceFrequency();
+}
+
+
+// Convert a gain to Q15, like the mixer
+static Sint32 to_q15(float g) {
+
+    if(g <= 0.0f) return 0;
+    if(g >= 1.0f) return 32767;
+
+    return (Sint32)(g * 32767);
+}
+
+
+// Create the sounds. Loud noise over a tone, so that
+// a few voices are enough to saturate
+static int create_sounds() {
+
+    int i = 0;
+    Uint32 j;
+    Sint32 s;
+    for(; i < SOUND_COUNT; ++ i) {
+
+        sounds[i] = (Sint16*)malloc(sizeof(Sint16) * 2 * SOUND_LENGTHS[i]);
+        if(sounds[i] == NULL) {
+
+            return 1;
+        }
+
+        for(j = 0; j < SOUND_LENGTHS[i]; ++ j) {
+
+            s = (Sint32)((j * (i+1) * 37) & 0x3FFF) - 0x2000
+                + (Sint32)(next_random() & 0x7FFF) - 0x4000;
+            sounds[i][j*2] = (Sint16)s;
+            sounds[i][j*2 +1] = (Sint16)(-s / 2);
+        }
+    }
+    return 0;
+}
+
+
+// Start a sound on a voice, in both mixers
+static void start_voice(int voice) {
+
+    int i = (int)(next_random() % SOUND_COUNT);
+    float gain = 0.25f + next_float();
+    float pan = next_float() * 2.0f - 1.0f;
+
+    mixer_play(voice, sounds[i], SOUND_LENGTHS[i], gain, pan);
+
+    REF_VOICE* v = &refVoices[voice];
+    v->data = sounds[i];
+    v->frames = SOUND_LENGTHS[i];
+    v->pos = 0;
+    v->gainLeft = to_q15(pan > 0.0f ? gain * (1.0f - pan) : gain);
+    v->gainRight = to_q15(pan < 0.0f ? gain * (1.0f + pan) : gain);
+}
+
+
+// Mix the reference voices, one sample at a time
+static void render_reference(Sint16* dest, int frames) {
+
+    int i, k;
+    Sint32 l, r;
+    REF_VOICE* v;
+    for(i = 0; i < frames; ++ i) {
+
+        l = dest[i*2];
+        r = dest[i*2 +1];
+        for(k = 0; k < VOICE_MAX; ++ k) {
+
+            v = &refVoices[k];
+            if(v->data == NULL || v->pos + (Uint32)i >= v->frames) continue;
+
+            l += (v->data[(v->pos+i)*2] * v->gainLeft) >> 15;
+            r += (v->data[(v->pos+i)*2 +1] * v->gainRight) >> 15;
+        }
+        dest[i*2] = (Sint16)(l > SDL_MAX_SINT16 ? SDL_MAX_SINT16
+            : (l < SDL_MIN_SINT16 ? SDL_MIN_SINT16 : l));
+        dest[i*2 +1] = (Sint16)(r > SDL_MAX_SINT16 ? SDL_MAX_SINT16
+            : (r < SDL_MIN_SINT16 ? SDL_MIN_SINT16 : r));
+    }
+
+    for(k = 0; k < VOICE_MAX; ++ k) {
+
+        v = &refVoices[k];
+        if(v->data == NULL) continue;
+
+        v->pos += (Uint32)frames;
+        if(v->pos >= v->frames)
+            v->data = NULL;
+    }
+}
+
+
+// Run the bench
+int mix_bench_main(int argc, char** argv) {
+
+    int voices = argc > 2 ? (int)strtol(argv[2], NULL, 10) : DEFAULT_VOICES;
+    int seconds = argc > 3 ? (int)strtol(argv[3], NULL, 10) : DEFAULT_SECONDS;
+    if(voices < 1 || voices > VOICE_MAX || seconds < 1) {
+
+        printf("Usage: %s --mix-bench [voices (1-%d)] [seconds]\n",
+            argv[0], VOICE_MAX);
+        return 1;
+    }
+
+    if(create_sounds() == 1) {
+
+        printf("Failed to allocate memory!\n");
+        return 1;
+    }
+
+    mixer_init(FREQUENCY, false);
+
+    int buffers = seconds * FREQUENCY / BUFFER_FRAMES;
+    int mismatches = 0;
+    double refUs = 0.0;
+    double start;
+    int i, k;
+    for(i = 0; i < buffers; ++ i) {
+
+        // Keep every voice busy
+        for(k = 0; k < voices; ++ k) {
+
+            if(refVoices[k].data == NULL)
+                start_voice(k);
+        }
+
+        // Music under the voices
+        for(k = 0; k < BUFFER_FRAMES * 2; ++ k)
+            out[k] = (Sint16)((next_random() & 0x3FFF) - 0x2000);
+        memcpy(refOut, out, sizeof(out));
+
+        mixer_render(out, BUFFER_FRAMES);
+
+        start = get_time();
+        render_reference(refOut, BUFFER_FRAMES);
+        refUs += get_time() - start;
+
+        if(memcmp(out, refOut, sizeof(out)) != 0)
+            ++ mismatches;
+    }
+
+    MIXER_STATS s = mixer_get_stats();
+    mixer_destroy();
+
+    printf("voices,buffers,frames per buffer,mean us,max us,budget us,"
+        "load %%,reference mean us,mismatched buffers\n");
+    printf("%d,%u,%d,%.2f,%.2f,%.0f,%.3f,%.2f,%d\n",
+        voices, s.calls, BUFFER_FRAMES,
+        s.totalUs / s.calls, s.maxUs, s.budgetUs,
+        s.totalUs / s.calls / s.budgetUs * 100.0,
+        refUs / s.calls, mismatches);
+
+    for(i = 0; i < SOUND_COUNT; ++ i)
+        free(sounds[i]);
+
+    return mismatches > 0 ? 1 : 0;
+}
@@ -0,0 +1,15 @@
+// GOAT
+// Software mixer bench (header)
+// (c) 2018 Jani Nykänen
+
+#ifndef __MIX_BENCH__
+#define __MIX_BENCH__
+
+// Mix synthetic voices without an audio device, check
+// the output against a plain reference mix, and print
+// the cost per buffer. From the command line:
+// --mix-bench [voices] [seconds]
+// Returns 1 if the outputs differ
+int mix_bench_main(int argc, char** argv);
+
+#endif // __MIX_BENCH__
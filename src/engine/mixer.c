@@ -0,0 +1,298 @@
+// GOAT
+// Software mixer (source)
+// (c) 2018 Jani Nykänen
+
+#include "mixer.h"
+
+#include <SDL2/SDL_mixer.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Gain of 1.0 (Q15)
+#define GAIN_ONE 32767
+
+// Voice
+typedef struct {
+
+    const Sint16* data; // NULL if free
+    Uint32 frames;
+    Uint32 pos;
+    Sint16 gainLeft; // Q15
+    Sint16 gainRight;
+}
+MIX_VOICE;
+
+// Voices
+static MIX_VOICE voices[VOICE_MAX];
+// Voice table lock, held while mixing
+static SDL_SpinLock lock;
+// Mix buffer (32-bit, so voices do not clip each other)
+static Sint32 acc[MIXER_BLOCK * 2];
+
+// Output frequency
+static int freq;
+// Is enabled
+static bool enabled;
+// Is the callback registered
+static bool hooked;
+
+// Statistics
+static MIXER_STATS stats;
+
+
+// Mixing callback, after SDL_mixer (music) is done
+static void postmix(void* udata, Uint8* stream, int len) {
+
+    mixer_render((Sint16*)stream, len / (int)(sizeof(Sint16) * 2));
+}
+
+
+// Convert a gain to Q15
+static Sint16 to_q15(float g) {
+
+    if(g <= 0.0f) return 0;
+    if(g >= 1.0f) return GAIN_ONE;
+
+    return (Sint16)(g * GAIN_ONE);
+}
+
+
+// Add a voice to the mix buffer
+static int mix_voice(MIX_VOICE* v, int frames) {
+
+    Uint32 left = v->frames - v->pos;
+    int n = left < (Uint32)frames ? (int)left : frames;
+    const Sint16* src = v->data + v->pos * 2;
+    int i = 0;
+
+#ifdef __SSE2__
+    // Four frames at a time. The 16x16 products are
+    // rebuilt to 32 bits from the low & high halves
+    __m128i g = _mm_set_epi16(v->gainRight, v->gainLeft, v->gainRight, v->gainLeft,
+        v->gainRight, v->gainLeft, v->gainRight, v->gainLeft);
+    __m128i x, lo, hi;
+    __m128i* a;
+    for(; i + 4 <= n; i += 4) {
+
+        x = _mm_loadu_si128((const __m128i*)(src + i*2));
+        lo = _mm_mullo_epi16(x, g);
+        hi = _mm_mulhi_epi16(x, g);
+
+        a = (__m128i*)(acc + i*2);
+        _mm_storeu_si128(a, _mm_add_epi32(_mm_loadu_si128(a),
+            _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 15)));
+        _mm_storeu_si128(a+1, _mm_add_epi32(_mm_loadu_si128(a+1),
+            _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 15)));
+    }
+#endif
+    for(; i < n; ++ i) {
+
+        acc[i*2] += ((Sint32)src[i*2] * v->gainLeft) >> 15;
+        acc[i*2 +1] += ((Sint32)src[i*2 +1] * v->gainRight) >> 15;
+    }
+
+    v->pos += (Uint32)n;
+    if(v->pos >= v->frames)
+        v->data = NULL;
+
+    return n;
+}
+
+
+// Add the mix buffer to the output, saturated
+static void write_output(Sint16* out, int frames) {
+
+    int count = frames * 2;
+    int i = 0;
+    Sint32 s;
+
+#ifdef __SSE2__
+    // The output is widened (sign extended) and summed
+    // in 32 bits, then packed with saturation
+    __m128i o, s0, s1;
+    for(; i + 8 <= count; i += 8) {
+
+        o = _mm_loadu_si128((const __m128i*)(out + i));
+        s0 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(acc + i)),
+            _mm_srai_epi32(_mm_unpacklo_epi16(o, o), 16));
+        s1 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(acc + i + 4)),
+            _mm_srai_epi32(_mm_unpackhi_epi16(o, o), 16));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(s0, s1));
+    }
+#endif
+    for(; i < count; ++ i) {
+
+        s = (Sint32)out[i] + acc[i];
+        out[i] = (Sint16)(s > SDL_MAX_SINT16 ? SDL_MAX_SINT16
+            : (s < SDL_MIN_SINT16 ? SDL_MIN_SINT16 : s));
+    }
+}
+
+
+// Mix a block of frames. Returns the number of voices
+static int render_block(Sint16* out, int frames) {
+
+    memset(acc, 0, sizeof(Sint32) * frames * 2);
+
+    int count = 0;
+    int i = 0;
+    for(; i < VOICE_MAX; ++ i) {
+
+        if(voices[i].data == NULL) continue;
+
+        stats.voiceFrames += (Uint64)mix_voice(&voices[i], frames);
+        ++ count;
+    }
+
+    if(count > 0)
+        write_output(out, frames);
+
+    return count;
+}
+
+
+// Initialize the mixer
+void mixer_init(int frequency, bool hook) {
+
+    memset(voices, 0, sizeof(voices));
+    memset(&stats, 0, sizeof(MIXER_STATS));
+    freq = frequency;
+
+    if(hook)
+        Mix_SetPostMix(postmix, NULL);
+
+    hooked = hook;
+    enabled = true;
+}
+
+
+// Play frames on a voice
+void mixer_play(int voice, const Sint16* data, Uint32 frames, float gain, float pan) {
+
+    if(voice < 0 || voice >= VOICE_MAX) return;
+
+    // Balance, the center is full volume on both sides
+    float l = pan > 0.0f ? gain * (1.0f - pan) : gain;
+    float r = pan < 0.0f ? gain * (1.0f + pan) : gain;
+
+    SDL_AtomicLock(&lock);
+
+    MIX_VOICE* v = &voices[voice];
+    v->data = frames > 0 ? data : NULL;
+    v->frames = frames;
+    v->pos = 0;
+    v->gainLeft = to_q15(l);
+    v->gainRight = to_q15(r);
+
+    SDL_AtomicUnlock(&lock);
+}
+
+
+// Stop all voices
+void mixer_stop_all() {
+
+    SDL_AtomicLock(&lock);
+    memset(voices, 0, sizeof(voices));
+    SDL_AtomicUnlock(&lock);
+}
+
+
+// Stop the voices playing the given data
+void mixer_stop_data(const void* data) {
+
+    SDL_AtomicLock(&lock);
+
+    int i = 0;
+    for(; i < VOICE_MAX; ++ i) {
+
+        if(voices[i].data == (const Sint16*)data)
+            voices[i].data = NULL;
+    }
+
+    SDL_AtomicUnlock(&lock);
+}
+
+
+// Mix the voices
+void mixer_render(Sint16* out, int frames) {
+
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    SDL_AtomicLock(&lock);
+
+    int n;
+    int count;
+    int pos = 0;
+    int most = 0;
+    while(pos < frames) {
+
+        n = frames - pos < MIXER_BLOCK ? frames - pos : MIXER_BLOCK;
+        count = render_block(out + pos*2, n);
+        if(count > most) most = count;
+
+        pos += n;
+    }
+
+    double us = (double)(SDL_GetPerformanceCounter() - start) * 1000000.0
+        / (double)SDL_GetPerformanceFrequency();
+    double budget = freq > 0 ? (double)frames * 1000000.0 / (double)freq : 0.0;
+
+    ++ stats.calls;
+    stats.frames += (Uint64)frames;
+    stats.totalUs += us;
+    if(us > stats.maxUs) stats.maxUs = us;
+    if(budget > stats.budgetUs) stats.budgetUs = budget;
+    if(most > stats.maxVoices) stats.maxVoices = most;
+
+    SDL_AtomicUnlock(&lock);
+}
+
+
+// Get the statistics
+MIXER_STATS mixer_get_stats() {
+
+    SDL_AtomicLock(&lock);
+    MIXER_STATS s = stats;
+    SDL_AtomicUnlock(&lock);
+
+    return s;
+}
+
+
+// Print the statistics
+void mixer_print_stats() {
+
+    MIXER_STATS s = mixer_get_stats();
+    if(s.calls == 0) return;
+
+    printf("Mixer: %u buffers, %.2f us mean, %.2f us max (budget %.0f us), "
+        "%.2f voices mean, %d max\n",
+        s.calls, s.totalUs / s.calls, s.maxUs, s.budgetUs,
+        s.frames > 0 ? (double)s.voiceFrames / (double)s.frames : 0.0,
+        s.maxVoices);
+}
+
+
+// Is the mixer used
+bool mixer_enabled() {
+
+    return enabled;
+}
+
+
+// Stop the mixer
+void mixer_destroy() {
+
+    if(!enabled) return;
+
+    if(hooked)
+        Mix_SetPostMix(NULL, NULL);
+
+    hooked = false;
+    enabled = false;
+}
@@ -0,0 +1,62 @@
+// GOAT
+// Software mixer (header)
+// (c) 2018 Jani Nykänen
+
+#ifndef __MIXER__
+#define __MIXER__
+
+#include <SDL2/SDL.h>
+
+#include "voice.h"
+
+#include <stdbool.h>
+
+// Frames mixed at once
+#define MIXER_BLOCK 1024
+
+// Mixing cost statistics
+typedef struct {
+
+    Uint32 calls; // Buffers mixed
+    Uint64 frames; // Output frames
+    Uint64 voiceFrames; // Voice frames mixed
+    double totalUs; // Time spent mixing
+    double maxUs; // Longest buffer
+    double budgetUs; // Length of the longest buffer
+    int maxVoices; // Most voices at once
+}
+MIXER_STATS;
+
+// Initialize the mixer. Voices are 16-bit stereo at
+// the given frequency, like the output. Registers the
+// mixing callback if "hook" is set (otherwise call
+// mixer_render yourself)
+void mixer_init(int frequency, bool hook);
+
+// Play 16-bit stereo frames on a voice. The data must
+// stay until the voice is done. Pan is -1 (left) to 1
+void mixer_play(int voice, const Sint16* data, Uint32 frames, float gain, float pan);
+
+// Stop all voices
+void mixer_stop_all();
+
+// Stop the voices playing the given data
+void mixer_stop_data(const void* data);
+
+// Mix the voices into 16-bit stereo frames (added to
+// what is there, saturated)
+void mixer_render(Sint16* out, int frames);
+
+// Get the statistics
+MIXER_STATS mixer_get_stats();
+
+// Print the statistics
+void mixer_print_stats();
+
+// Is the mixer used
+bool mixer_enabled();
+
+// Stop the mixer
+void mixer_destroy();
+
+#endif // __MIXER__
@@ -4,6 +4,8 @@
 
 #include "music.h"
 
+#include <SDL2/SDL_mixer.h>
+
 #include "../include/system.h"
 #include "../include/std.h"
 
@@ -14,36 +16,58 @@ static int globalMusicVol;
 static bool playing;
 // Music enabled
 static bool musicEnabled;
-// Old volume
-static float oldVol;
+// Output frequency
+static int frequency;
+
+
+// Convert milliseconds to frames
+static int ms_to_frames(int ms) {
+
+    return (int)((Sint64)ms * frequency / 1000);
+}
 
 
 // Init music
-void init_music() {
+int init_music() {
 
     globalMusicVol = 100;
     playing = false;
     musicEnabled = true;
-    oldVol = 1.0f;
+
+    Uint16 format = 0;
+    int channels = 0;
+    if(Mix_QuerySpec(&frequency, &format, &channels) == 0) {
+
+        error_throw("Audio is not open, cannot play music!", NULL);
+        return 1;
+    }
+
+    // Replaces the music player of SDL_mixer
+    return stream_init(frequency, true);
 }   
 
 
-// Load music
+// Load music. Only checks that the file is there, it
+// is decoded while it plays
 MUSIC* load_music(const char* path) {
 
-    MUSIC* m = (MUSIC*)malloc(sizeof(MUSIC));
-    if(m == NULL) {     
+    SDL_RWops* rw = SDL_RWFromFile(path, "rb");
+    if(rw == NULL || strlen(path) >= STREAM_PATH_SIZE) {     
 
-        error_mem_alloc();
+        if(rw != NULL) SDL_RWclose(rw);
+        error_throw("Failed to load a music file in ",path);
         return NULL;
     }
+    SDL_RWclose(rw);
 
-    m->data = Mix_LoadMUS(path);
-    if(m->data == NULL) {     
+    MUSIC* m = (MUSIC*)malloc(sizeof(MUSIC));
+    if(m == NULL) {     
 
-        error_throw("Failed to load a music file in ",path);
+        error_mem_alloc();
         return NULL;
     }
+    snprintf(m->path, STREAM_PATH_SIZE, "%s", path);
+
     return m;
 }
 
@@ -52,17 +76,8 @@ void fade_in_music(MUSIC* mus, float vol, int loops, int time) {
 
     if(mus == NULL || !musicEnabled) return;
 
-    oldVol = vol;
-
-    float mvol = (float)globalMusicVol / 100.0f;
-
-    int v = (int)(128 * vol * mvol);
-    if(v > 128) v = 128;
-    if(v < 0) v = 0;
-
-    Mix_HaltMusic();
-    Mix_VolumeMusic(v);
-    Mix_FadeInMusic(mus->data, loops,time);
+    stream_set_volume((float)globalMusicVol / 100.0f);
+    stream_play(mus->path, vol, loops, ms_to_frames(time));
 
     playing = true;
 }
@@ -80,7 +95,6 @@ void destroy_music(MUSIC* m) {
 
     if(m == NULL) return;
 
-    Mix_FreeMusic(m->data);
     free(m);
 }
 
@@ -90,14 +104,14 @@ void stop_music() {
 
     if(!musicEnabled) return;
 
-    Mix_FadeOutMusic(1000);
+    stream_stop(ms_to_frames(1000));
 }
 
 
 // Fade out
 void fade_out_music(int ms) {
 
-    Mix_FadeOutMusic(ms);
+    stream_stop(ms_to_frames(ms));
 }
 
 
@@ -106,12 +120,12 @@ void enable_music(bool state) {
 
     if(!state) {     
 
-        Mix_PauseMusic();
+        stream_pause(true);
         globalMusicVol = 0;
     }
     else {     
 
-        Mix_ResumeMusic();
+        stream_pause(false);
         globalMusicVol = 100;
     }
     musicEnabled = state;
@@ -129,10 +143,7 @@ bool music_enabled() {
 // Set global music volume
 void set_global_music_volume(int vol) {
 
-    float mvol = (float)vol / 100.0f;
-    int v = (int)(128 * oldVol * mvol);
-
-    Mix_VolumeMusic(v);
+    stream_set_volume((float)vol / 100.0f);
 
     globalMusicVol = vol;
 }
@@ -142,4 +153,12 @@ void set_global_music_volume(int vol) {
 int get_global_music_volume() {
 
     return globalMusicVol;
-}
\ No newline at end of file
+}
+
+
+// Stop streaming music
+void quit_music() {
+
+    stream_print_stats();
+    stream_destroy();
+}
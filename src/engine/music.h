@@ -5,24 +5,24 @@
 #ifndef __MUSIC__
 #define __MUSIC__
 
-#include <SDL2/SDL_mixer.h>
+#include "stream.h"
 
 #include <stdbool.h>
 
-// Music
+// Music. Streamed from the file when played
 typedef struct {
 
-    Mix_Music* data;
+    char path[STREAM_PATH_SIZE];
 }
 MUSIC;
 
-// Init music
-void init_music();
+// Init music. Returns 1 on error
+int init_music();
 
 // Load music
 MUSIC* load_music(const char* path);
 
-// Fade in music
+// Fade in music, crossfaded from what plays
 void fade_in_music(MUSIC* mus, float vol, int loops, int time);
 
 // Play music
@@ -49,4 +49,7 @@ void set_global_music_volume(int vol);
 // Return global music volume
 int get_global_music_volume();
 
+// Stop streaming music
+void quit_music();
+
 #endif // __MUSIC__
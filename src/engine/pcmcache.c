@@ -0,0 +1,139 @@
+// GOAT
+// Baked sample PCM (source)
+// (c) 2018 Jani Nykänen
+
+#include "pcmcache.h"
+
+#include "../include/std.h"
+
+#include <sys/stat.h>
+#include <stddef.h>
+
+// Magic ("GPCM") & version
+#define PCM_MAGIC 0x4D435047
+#define PCM_VERSION 1
+// Path buffer size
+#define PATH_SIZE 256
+
+// File header, followed by the PCM
+typedef struct {
+
+    Uint32 magic;
+    Uint32 version;
+    Sint32 freq;
+    Uint16 format;
+    Uint16 channels;
+    Sint64 sourceTime; // Modified time of the source
+    Sint64 sourceSize;
+    Uint32 length; // In bytes
+    Uint32 reserved;
+}
+HEADER;
+
+
+// Get the path of the baked file
+static bool baked_path(const char* path, char* out) {
+
+    int n = snprintf(out, PATH_SIZE, "%s.pcm", path);
+    return n > 0 && n < PATH_SIZE;
+}
+
+
+// Fill the parts of a header that must match
+static bool fill_header(HEADER* h, const char* path, int freq, Uint16 format, int channels) {
+
+    struct stat st;
+    if(stat(path, &st) != 0) return false;
+
+    memset(h, 0, sizeof(HEADER));
+    h->magic = PCM_MAGIC;
+    h->version = PCM_VERSION;
+    h->freq = freq;
+    h->format = format;
+    h->channels = (Uint16)channels;
+    h->sourceTime = (Sint64)st.st_mtime;
+    h->sourceSize = (Sint64)st.st_size;
+
+    return true;
+}
+
+
+// Read baked PCM
+Uint8* pcm_cache_read(const char* path, int freq, Uint16 format, int channels, Uint32* length) {
+
+    char bakedPath[PATH_SIZE];
+    HEADER want;
+    HEADER h;
+    if(!baked_path(path, bakedPath)
+     || !fill_header(&want, path, freq, format, channels))
+        return NULL;
+
+    FILE* f = fopen(bakedPath, "rb");
+    if(f == NULL) return NULL;
+
+    // Stale or from another device format
+    if(fread(&h, sizeof(HEADER), 1, f) != 1
+     || memcmp(&h, &want, offsetof(HEADER, length)) != 0
+     || h.length == 0) {
+
+        fclose(f);
+        return NULL;
+    }
+
+    Uint8* pcm = (Uint8*)malloc(h.length);
+    if(pcm == NULL) {
+
+        fclose(f);
+        return NULL;
+    }
+
+    // Nothing may follow the PCM
+    if(fread(pcm, 1, h.length, f) != h.length || fgetc(f) != EOF) {
+
+        free(pcm);
+        fclose(f);
+        return NULL;
+    }
+    fclose(f);
+
+    *length = h.length;
+    return pcm;
+}
+
+
+// Bake PCM. Written to a temporary file first, so a
+// reader never sees half of it
+int pcm_cache_write(const char* path, int freq, Uint16 format, int channels,
+    const Uint8* pcm, Uint32 length) {
+
+    char bakedPath[PATH_SIZE];
+    char tmpPath[PATH_SIZE + 4];
+    HEADER h;
+    if(!baked_path(path, bakedPath)
+     || !fill_header(&h, path, freq, format, channels))
+        return 1;
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", bakedPath);
+    h.length = length;
+
+    FILE* f = fopen(tmpPath, "wb");
+    if(f == NULL) return 1;
+
+    bool ok = fwrite(&h, sizeof(HEADER), 1, f) == 1
+        && fwrite(pcm, 1, length, f) == length;
+    if(fclose(f) != 0 || !ok) {
+
+        remove(tmpPath);
+        return 1;
+    }
+
+#ifdef _WIN32
+    remove(bakedPath);
+#endif
+    if(rename(tmpPath, bakedPath) != 0) {
+
+        remove(tmpPath);
+        return 1;
+    }
+
+    return 0;
+}
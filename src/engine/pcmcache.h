@@ -0,0 +1,20 @@
+// GOAT
+// Baked sample PCM (header)
+// (c) 2018 Jani Nykänen
+
+#ifndef __PCM_CACHE__
+#define __PCM_CACHE__
+
+#include <SDL2/SDL.h>
+
+// Read the PCM baked for a sound file. It must be in
+// the given device format and newer than the source.
+// Returns a buffer to be freed, NULL if there is none
+Uint8* pcm_cache_read(const char* path, int freq, Uint16 format, int channels, Uint32* length);
+
+// Bake the PCM of a sound file, converted to the given
+// device format. Returns 1 on error
+int pcm_cache_write(const char* path, int freq, Uint16 format, int channels,
+    const Uint8* pcm, Uint32 length);
+
+#endif // __PCM_CACHE__
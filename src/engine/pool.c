@@ -0,0 +1,118 @@
+// GOAT
+// Slot pool (source)
+// (c) 2018 Jani Nykänen
+
+#include "pool.h"
+
+#include <stdio.h>
+
+// Used slots are marked with this link
+#define SLOT_USED -2
+
+
+// Next valid generation
+static Uint16 next_generation(Uint16 g) {
+
+    return g == 0xFFFF ? 1 : g+1;
+}
+
+
+// Reset a pool
+void pool_reset(POOL* p, int* next, Uint16* generation, int capacity) {
+
+    int i = 0;
+
+    p->capacity = capacity;
+    p->count = 0;
+    p->freeHead = capacity > 0 ? 0 : -1;
+
+    // Link the slots in order, so the first free
+    // slot is the lowest one
+    for(; i < capacity; ++ i) {
+
+        next[i] = i+1 < capacity ? i+1 : -1;
+        generation[i] = next_generation(generation[i]);
+    }
+}
+
+
+// Allocate a slot
+int pool_alloc(POOL* p, int* next) {
+
+    if(p->freeHead == -1) {
+
+        ++ p->dropped;
+        return -1;
+    }
+
+    int slot = p->freeHead;
+    p->freeHead = next[slot];
+    next[slot] = SLOT_USED;
+
+    ++ p->count;
+    ++ p->allocated;
+    if(p->count > p->peak)
+        p->peak = p->count;
+
+    return slot;
+}
+
+
+// Free a slot
+void pool_free(POOL* p, int* next, Uint16* generation, int slot) {
+
+    if(slot < 0 || slot >= p->capacity || next[slot] != SLOT_USED)
+        return;
+
+    generation[slot] = next_generation(generation[slot]);
+
+    next[slot] = p->freeHead;
+    p->freeHead = slot;
+    -- p->count;
+}
+
+
+// Get a handle to a slot
+POOL_HANDLE pool_handle(const Uint16* generation, int slot) {
+
+    if(slot < 0) return POOL_HANDLE_NONE;
+
+    return ((POOL_HANDLE)generation[slot] << 16) | (POOL_HANDLE)slot;
+}
+
+
+// Get the slot of a handle
+int pool_resolve(const POOL* p, const Uint16* generation, POOL_HANDLE h) {
+
+    int slot = (int)(h & 0xFFFF);
+    Uint16 gen = (Uint16)(h >> 16);
+
+    if(h == POOL_HANDLE_NONE || slot >= p->capacity || generation[slot] != gen)
+        return -1;
+
+    return slot;
+}
+
+
+// Collect pool statistics
+void pool_collect_stats(POOL* p, POOL_STATS* s) {
+
+    s->capacity = p->capacity;
+    if(p->peak > s->peak)
+        s->peak = p->peak;
+    s->allocated += p->allocated;
+    s->dropped += p->dropped;
+
+    p->peak = p->count;
+    p->allocated = 0;
+    p->dropped = 0;
+}
+
+
+// Print collected pool statistics
+void pool_print_stats(const POOL_STATS* s, const char* name) {
+
+    printf("Pool %s: peak %d/%d, %u allocated, %u dropped.\n",
+        name, s->peak, s->capacity, 
+        (unsigned)s->allocated, (unsigned)s->dropped);
+}
@@ -0,0 +1,69 @@
+// GOAT
+// Slot pool (header)
+// (c) 2018 Jani Nykänen
+
+#ifndef __POOL__
+#define __POOL__
+
+#include <SDL2/SDL.h>
+
+#include <stdbool.h>
+
+// Handle to a pool slot. The low 16 bits are the slot,
+// the high 16 bits its generation. 0 is never valid
+typedef Uint32 POOL_HANDLE;
+
+// No handle
+#define POOL_HANDLE_NONE 0
+
+// Slot pool header. The free list is intrusive: the
+// next links and generations are arrays owned by the
+// user, indexed by slot
+typedef struct {
+
+    int capacity;
+    int freeHead; // -1 if full
+    int count;
+
+    // Statistics not collected yet
+    int peak;
+    Uint32 allocated;
+    Uint32 dropped; // Allocations that failed (pool full)
+}
+POOL;
+
+// Collected pool statistics. Kept apart from the pool,
+// so that they are not reset, saved or rewound with it
+typedef struct {
+
+    int capacity;
+    int peak;
+    Uint32 allocated;
+    Uint32 dropped;
+}
+POOL_STATS;
+
+// Reset a pool, all slots become free. Bumps the
+// generations so old handles become invalid
+void pool_reset(POOL* p, int* next, Uint16* generation, int capacity);
+
+// Allocate a slot, returns -1 if full
+int pool_alloc(POOL* p, int* next);
+
+// Free a slot
+void pool_free(POOL* p, int* next, Uint16* generation, int slot);
+
+// Get a handle to a slot
+POOL_HANDLE pool_handle(const Uint16* generation, int slot);
+
+// Get the slot of a handle, -1 if the handle is stale
+int pool_resolve(const POOL* p, const Uint16* generation, POOL_HANDLE h);
+
+// Add the statistics of a pool to the collected ones,
+// and clear them in the pool
+void pool_collect_stats(POOL* p, POOL_STATS* s);
+
+// Print collected pool statistics
+void pool_print_stats(const POOL_STATS* s, const char* name);
+
+#endif // __POOL__
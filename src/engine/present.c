@@ -0,0 +1,416 @@
+// GOAT
+// Software present (source)
+// (c) 2018 Jani Nykänen
+
+#include "present.h"
+
+#include "graphics.h"
+#include "mathext.h"
+#include "error.h"
+
+#include "../lib/tinycthread.h"
+
+#include "../include/std.h"
+
+#include <stdint.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Worker data
+typedef struct {
+
+    thrd_t thread;
+    int index;
+    Uint32* row; // Expanded canvas row
+    Uint32* scaled; // Scaled row (used when clipping)
+    int scaledSize;
+}
+WORKER;
+
+// Job (shared by the workers)
+typedef struct {
+
+    Uint8* pixels;
+    int pitch;
+    int surfWidth;
+    int surfHeight;
+    _POINT pos;
+    int scale;
+    int filter;
+}
+JOB;
+
+// Canvas size
+static _POINT canvas;
+
+// Workers, the first one is the main thread
+static WORKER workers[PRESENT_MAX_THREADS];
+// Worker count
+static int workerCount;
+
+// Current job
+static JOB job;
+
+// Synchronization
+static mtx_t lock;
+static cnd_t startCond;
+static cnd_t doneCond;
+static int generation;
+static int pending;
+static bool quit;
+
+
+// Scale a row horizontally
+static void scale_row(Uint32* dst, const Uint32* src, int w, int scale) {
+
+    int x = 0;
+    int i;
+    Uint32 c;
+
+    switch(scale) {
+
+    case 1:
+        memcpy(dst, src, w * sizeof(Uint32));
+        return;
+
+    case 2:
+#ifdef __SSE2__
+        for(; x + 4 <= w; x += 4) {
+
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + x));
+            _mm_storeu_si128((__m128i*)(dst + x*2), _mm_unpacklo_epi32(v, v));
+            _mm_storeu_si128((__m128i*)(dst + x*2 + 4), _mm_unpackhi_epi32(v, v));
+        }
+#endif
+        for(; x < w; ++ x) {
+
+            dst[x*2] = dst[x*2 +1] = src[x];
+        }
+        return;
+
+    case 3:
+        for(; x < w; ++ x) {
+
+            c = src[x];
+            dst[x*3] = c;
+            dst[x*3 +1] = c;
+            dst[x*3 +2] = c;
+        }
+        return;
+
+    case 4:
+#ifdef __SSE2__
+        for(; x + 4 <= w; x += 4) {
+
+            __m128i v = _mm_loadu_si128((const __m128i*)(src + x));
+            _mm_storeu_si128((__m128i*)(dst + x*4), _mm_shuffle_epi32(v, 0x00));
+            _mm_storeu_si128((__m128i*)(dst + x*4 + 4), _mm_shuffle_epi32(v, 0x55));
+            _mm_storeu_si128((__m128i*)(dst + x*4 + 8), _mm_shuffle_epi32(v, 0xAA));
+            _mm_storeu_si128((__m128i*)(dst + x*4 + 12), _mm_shuffle_epi32(v, 0xFF));
+        }
+#endif
+        for(; x < w; ++ x) {
+
+            c = src[x];
+            dst[x*4] = dst[x*4 +1] = dst[x*4 +2] = dst[x*4 +3] = c;
+        }
+        return;
+
+    default:
+        for(; x < w; ++ x) {
+
+            c = src[x];
+            for(i = 0; i < scale; ++ i)
+                dst[x*scale + i] = c;
+        }
+        return;
+    }
+}
+
+
+// Halve the brightness of a row (scanlines)
+static void dim_row(Uint32* row, int w) {
+
+    int x = 0;
+    for(; x < w; ++ x) {
+
+        row[x] = 0xFF000000 | ((row[x] >> 1) & 0x007F7F7F);
+    }
+}
+
+
+// Apply an aperture grille mask to a row (CRT)
+static void mask_row(Uint32* row, int w) {
+
+    const Uint32 KEEP[] = {0xFF0000, 0x00FF00, 0x0000FF};
+
+    int x = 0;
+    Uint32 c;
+    for(; x < w; ++ x) {
+
+        c = row[x];
+        row[x] = 0xFF000000 | (c & KEEP[x % 3])
+            | ((c >> 1) & 0x007F7F7F & ~KEEP[x % 3]);
+    }
+}
+
+
+// Draw a canvas row to the target
+static void draw_row(WORKER* wk, int y) {
+
+    int scale = job.scale;
+    int w = canvas.x * scale;
+    int dy = job.pos.y + y * scale;
+    int i;
+
+    // Expand the row
+    canvas_present_row(wk->row, y);
+
+    // Check if the row is fully inside the surface
+    bool inside = job.pos.x >= 0 && job.pos.x + w <= job.surfWidth;
+
+    Uint32* first = NULL;
+    Uint32* dst;
+    int x0 = 0;
+    int len = w;
+
+    if(inside) {
+
+        // Find the first visible target row
+        for(i = 0; i < scale; ++ i) {
+
+            if(dy+i >= 0 && dy+i < job.surfHeight) {
+
+                first = (Uint32*)(job.pixels + (dy+i) * job.pitch) + job.pos.x;
+                break;
+            }
+        }
+        if(first == NULL) return;
+    }
+    else {
+
+        // Scale to a temporary buffer
+        if(wk->scaledSize < w) {
+
+            free(wk->scaled);
+            wk->scaled = (Uint32*)malloc(sizeof(Uint32) * w);
+            if(wk->scaled == NULL) {
+
+                wk->scaledSize = 0;
+                return;
+            }
+            wk->scaledSize = w;
+        }
+        first = wk->scaled;
+
+        x0 = job.pos.x < 0 ? -job.pos.x : 0;
+        len = min_2(w, job.surfWidth - job.pos.x) - x0;
+        if(len <= 0) return;
+    }
+
+    // Scale horizontally & apply the mask
+    scale_row(first, wk->row, canvas.x, scale);
+    if(job.filter == PRESENT_FILTER_CRT)
+        mask_row(first, w);
+
+    // Copy to the target rows
+    for(i = 0; i < scale; ++ i) {
+
+        if(dy+i < 0 || dy+i >= job.surfHeight)
+            continue;
+
+        dst = (Uint32*)(job.pixels + (dy+i) * job.pitch) + job.pos.x + x0;
+        if(dst != first + x0)
+            memcpy(dst, first + x0, len * sizeof(Uint32));
+
+        // Scanlines
+        if(job.filter != PRESENT_FILTER_NONE && scale > 1 && i == scale-1)
+            dim_row(dst, len);
+    }
+}
+
+
+// Draw the rows that belong to a worker
+static void draw_band(WORKER* wk) {
+
+    int start = canvas.y * wk->index / workerCount;
+    int end = canvas.y * (wk->index+1) / workerCount;
+
+    int y = start;
+    for(; y < end; ++ y) {
+
+        draw_row(wk, y);
+    }
+}
+
+
+// Worker thread
+static int worker_thread(void* arg) {
+
+    WORKER* wk = (WORKER*)arg;
+    int gen = 0;
+
+    while(true) {
+
+        // Wait for a job
+        mtx_lock(&lock);
+        while(gen == generation && !quit)
+            cnd_wait(&startCond, &lock);
+
+        if(quit) {
+
+            mtx_unlock(&lock);
+            return 0;
+        }
+        gen = generation;
+        mtx_unlock(&lock);
+
+        draw_band(wk);
+
+        // Tell we are done
+        mtx_lock(&lock);
+        if(-- pending == 0)
+            cnd_signal(&doneCond);
+        mtx_unlock(&lock);
+    }
+
+    return 0;
+}
+
+
+// Initialize the software present
+int present_init(_POINT canvasSize, int threads) {
+
+    canvas = canvasSize;
+
+    if(threads <= 0)
+        threads = SDL_GetCPUCount();
+    threads = max_2(1, min_2(threads, min_2(PRESENT_MAX_THREADS, canvas.y)));
+
+    if(mtx_init(&lock, mtx_plain) != thrd_success
+    || cnd_init(&startCond) != thrd_success
+    || cnd_init(&doneCond) != thrd_success) {
+
+        error_throw("Failed to create present synchronization objects!", NULL);
+        return 1;
+    }
+    generation = 0;
+    pending = 0;
+    quit = false;
+
+    // Create workers
+    int i = 0;
+    workerCount = threads;
+    for(; i < workerCount; ++ i) {
+
+        workers[i].index = i;
+        workers[i].scaled = NULL;
+        workers[i].scaledSize = 0;
+        workers[i].row = (Uint32*)malloc(sizeof(Uint32) * canvas.x);
+        if(workers[i].row == NULL) {
+
+            error_mem_alloc();
+            return 1;
+        }
+
+        // The main thread works, too
+        if(i == 0) continue;
+
+        if(thrd_create(&workers[i].thread, worker_thread, &workers[i]) != thrd_success) {
+
+            // Work with what we have
+            workerCount = i;
+            break;
+        }
+    }
+
+    printf("Software present: %d thread(s).\n", workerCount);
+
+    return 0;
+}
+
+
+// Is the pixel format supported
+bool present_supports_format(Uint32 format) {
+
+    return format == SDL_PIXELFORMAT_ARGB8888
+        || format == SDL_PIXELFORMAT_RGB888;
+}
+
+
+// Draw the canvas to a surface, scaled by an integer
+void present_to_surface(SDL_Surface* surf, _POINT pos, int scale, int filter) {
+
+    if(surf == NULL || scale < 1) return;
+
+    if(SDL_MUSTLOCK(surf) && SDL_LockSurface(surf) != 0)
+        return;
+
+    canvas_present_begin();
+
+    job.pixels = (Uint8*)surf->pixels;
+    job.pitch = surf->pitch;
+    job.surfWidth = surf->w;
+    job.surfHeight = surf->h;
+    job.pos = pos;
+    job.scale = scale;
+    job.filter = filter;
+
+    // Start the workers
+    if(workerCount > 1) {
+
+        mtx_lock(&lock);
+        pending = workerCount-1;
+        ++ generation;
+        cnd_broadcast(&startCond);
+        mtx_unlock(&lock);
+    }
+
+    // Do our share
+    draw_band(&workers[0]);
+
+    // Wait for the others
+    if(workerCount > 1) {
+
+        mtx_lock(&lock);
+        while(pending > 0)
+            cnd_wait(&doneCond, &lock);
+        mtx_unlock(&lock);
+    }
+
+    canvas_present_end();
+
+    if(SDL_MUSTLOCK(surf))
+        SDL_UnlockSurface(surf);
+}
+
+
+// Destroy the software present
+void present_destroy() {
+
+    int i;
+
+    // Stop workers
+    mtx_lock(&lock);
+    quit = true;
+    cnd_broadcast(&startCond);
+    mtx_unlock(&lock);
+
+    for(i = 1; i < workerCount; ++ i) {
+
+        thrd_join(workers[i].thread, NULL);
+    }
+
+    for(i = 0; i < workerCount; ++ i) {
+
+        free(workers[i].row);
+        free(workers[i].scaled);
+    }
+    workerCount = 0;
+
+    cnd_destroy(&startCond);
+    cnd_destroy(&doneCond);
+    mtx_destroy(&lock);
+}
@@ -0,0 +1,38 @@
+// GOAT
+// Software present (header)
+// (c) 2018 Jani Nykänen
+
+#ifndef __PRESENT__
+#define __PRESENT__
+
+#include <SDL2/SDL.h>
+
+#include "vector.h"
+
+#include <stdbool.h>
+
+// Max worker threads
+#define PRESENT_MAX_THREADS 16
+
+// Present filters
+enum {
+
+    PRESENT_FILTER_NONE = 0,
+    PRESENT_FILTER_SCANLINES = 1,
+    PRESENT_FILTER_CRT = 2,
+};
+
+// Initialize the software present. Thread count 0 means
+// "one thread per CPU"
+int present_init(_POINT canvasSize, int threads);
+
+// Is the pixel format supported
+bool present_supports_format(Uint32 format);
+
+// Draw the canvas to a surface, scaled by an integer
+void present_to_surface(SDL_Surface* surf, _POINT pos, int scale, int filter);
+
+// Destroy the software present
+void present_destroy();
+
+#endif // __PRESENT__
@@ -0,0 +1,46 @@
+// GOAT
+// Random number generator (source)
+// (c) 2018 Jani Nykänen
+
+#include "rng.h"
+
+
+// Seed a generator
+void rng_seed(RNG* r, Uint64 seed, Uint64 stream) {
+
+    r->state = 0;
+    r->inc = (stream << 1) | 1;
+    rng_next(r);
+    r->state += seed;
+    rng_next(r);
+}
+
+
+// Next 32-bit number
+Uint32 rng_next(RNG* r) {
+
+    Uint64 old = r->state;
+    r->state = old * 6364136223846793005ULL + r->inc;
+
+    Uint32 xorshifted = (Uint32)(((old >> 18) ^ old) >> 27);
+    Uint32 rot = (Uint32)(old >> 59);
+
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
+
+
+// Random integer in [0, n)
+int rng_range(RNG* r, int n) {
+
+    if(n <= 1) return 0;
+
+    // Multiply-shift, no division
+    return (int)(((Uint64)rng_next(r) * (Uint32)n) >> 32);
+}
+
+
+// Random float in [0, 1)
+float rng_float(RNG* r) {
+
+    return (float)(rng_next(r) >> 8) * (1.0f / 16777216.0f);
+}
@@ -0,0 +1,32 @@
+// GOAT
+// Random number generator (header)
+// (c) 2018 Jani Nykänen
+
+#ifndef __RNG__
+#define __RNG__
+
+#include <SDL2/SDL.h>
+
+// Random number generator (PCG32). Each generator is
+// a separate stream, so no global state is shared
+typedef struct {
+
+    Uint64 state;
+    Uint64 inc;
+}
+RNG;
+
+// Seed a generator. Generators with the same seed but
+// a different stream give unrelated sequences
+void rng_seed(RNG* r, Uint64 seed, Uint64 stream);
+
+// Next 32-bit number
+Uint32 rng_next(RNG* r);
+
+// Random integer in [0, n), 0 if n <= 1
+int rng_range(RNG* r, int n);
+
+// Random float in [0, 1)
+float rng_float(RNG* r);
+
+#endif // __RNG__
@@ -4,6 +4,10 @@
 
 #include "sample.h"
 
+#include "voice.h"
+#include "mixer.h"
+#include "pcmcache.h"
+
 #include "../include/system.h"
 #include "../include/std.h"
 
@@ -11,6 +15,57 @@
 static int globalSoundVol;
 // Samples enabled
 static bool samplesEnabled;
+// Is the channel of a voice panned (SDL_mixer)
+static bool panned[VOICE_MAX];
+
+// Loaded samples
+static SAMPLE* loaded[SAMPLE_LOADED_MAX];
+static int loadedCount;
+// PCM bytes loaded
+static Uint32 memoryUsed;
+
+
+// Find a loaded sample
+static SAMPLE* find_loaded(const char* path) {
+
+    int i = 0;
+    for(; i < loadedCount; ++ i) {
+
+        if(strcmp(loaded[i]->path, path) == 0)
+            return loaded[i];
+    }
+    return NULL;
+}
+
+
+// Load the chunk of a sample, in the device format
+static int load_chunk(SAMPLE* s, const char* path, int freq, Uint16 format, int channels) {
+
+    Uint32 len = 0;
+    s->pcm = pcm_cache_read(path, freq, format, channels, &len);
+    if(s->pcm != NULL) {
+
+        s->chunk = Mix_QuickLoad_RAW(s->pcm, len);
+        if(s->chunk != NULL) return 0;
+
+        free(s->pcm);
+        s->pcm = NULL;
+    }
+
+    // Convert, and bake for the next time
+    s->chunk = Mix_LoadWAV(path);
+    if(!s->chunk) {
+
+        error_throw("Failed to load a sound file in ",path);
+        return 1;
+    }
+    if(pcm_cache_write(path, freq, format, channels, s->chunk->abuf, s->chunk->alen) == 1) {
+
+        printf("Could not bake the sound in %s, loading it again next time.\n", path);
+    }
+
+    return 0;
+}
 
 
 // Init audio
@@ -32,55 +87,122 @@ void set_global_sample_volume(int vol) {
 // Load a sound
 SAMPLE* load_sample(const char* path) {
 
+    // Already loaded
+    SAMPLE* s = find_loaded(path);
+    if(s != NULL) {
+
+        ++ s->refs;
+        return s;
+    }
+
+    if(loadedCount >= SAMPLE_LOADED_MAX || strlen(path) >= SAMPLE_PATH_SIZE) {
+
+        error_throw("Too many samples, or too long a path: ", path);
+        return NULL;
+    }
+
+    // The device format
+    int freq = 0;
+    int channels = 0;
+    Uint16 format = 0;
+    if(Mix_QuerySpec(&freq, &format, &channels) == 0 || freq <= 0) {
+
+        error_throw("Audio is not open, cannot load ", path);
+        return NULL;
+    }
+
     // Allocate memory
-    SAMPLE * s = (SAMPLE*)malloc(sizeof(s));
+    s = (SAMPLE*)malloc(sizeof(SAMPLE));
     if(s == NULL) {     
 
         error_mem_alloc();
         return NULL;
     }
 
-    // Load WAV
-    s->chunk =Mix_LoadWAV(path);
-    if(!s->chunk) {     
-    
-        error_throw("Failed to load a sound file in ",path);
+    if(load_chunk(s, path, freq, format, channels) == 1) {
+
         free(s);
         return NULL;
     }
 
+    if(memoryUsed + s->chunk->alen > SAMPLE_MEMORY_MAX) {
+
+        error_throw("Out of sample memory, cannot load ", path);
+        Mix_FreeChunk(s->chunk);
+        free(s->pcm);
+        free(s);
+        return NULL;
+    }
+    memoryUsed += s->chunk->alen;
+
+    // Get the length, for the voice allocator
+    Uint32 frame = (SDL_AUDIO_BITSIZE(format) / 8) * channels;
+    s->length = (Uint32)((Uint64)s->chunk->alen * 1000 / (frame * freq)) + 1;
+
     // Set default values
-    s->channel = 0;
-    s->played = false;
+    s->priority = SAMPLE_PRIORITY;
+    s->polyphony = SAMPLE_POLYPHONY;
+
+    snprintf(s->path, SAMPLE_PATH_SIZE, "%s", path);
+    s->refs = 1;
+    loaded[loadedCount ++] = s;
 
     return s;
 }
 
 
+// Set the voice priority and the polyphony limit
+void set_sample_voices(SAMPLE* s, int priority, int polyphony) {
+
+    if(s == NULL) return;
+
+    s->priority = priority;
+    s->polyphony = polyphony;
+}
+
+
 // Play sound
 void play_sample(SAMPLE* s, float vol) {
 
+    play_sample_pan(s, vol, 0.0f);
+}
+
+
+// Play sound, panned
+void play_sample_pan(SAMPLE* s, float vol, float pan) {
+
     if(s == NULL || !samplesEnabled) return;
 
-    float svol = (float)globalSoundVol / 100.0f;
+    // Every voice is playing something more important
+    int ch = voice_alloc(s, s->priority, s->polyphony, s->length);
+    if(ch < 0) return;
 
-    if(!s->played) {     
+    float svol = (float)globalSoundVol / 100.0f;
 
-        // Get channel, halt, set volume, play again
-        s->channel = Mix_PlayChannel(-1,s->chunk,0);
-        Mix_HaltChannel(s->channel);
+    // The chunk is in the device format, 16-bit stereo
+    if(mixer_enabled()) {
 
-        Mix_Volume(s->channel,(int)(MIX_MAX_VOLUME * vol * svol));
-        Mix_PlayChannel(-1,s->chunk,0);
-        
-        s->played = true;
+        mixer_play(ch, (const Sint16*)s->chunk->abuf,
+            s->chunk->alen / (sizeof(Sint16) * 2), vol * svol, pan);
+        return;
     }
-    else {     
 
-        Mix_HaltChannel(s->channel);
-        Mix_Volume(s->channel,(int)(MIX_MAX_VOLUME * vol * svol));
-        Mix_PlayChannel(s->channel,s->chunk,0);
+    int v = (int)(MIX_MAX_VOLUME * vol * svol);
+    if(v > MIX_MAX_VOLUME) v = MIX_MAX_VOLUME;
+    if(v < 0) v = 0;
+
+    // Full volume on both sides unregisters the effect
+    if(pan != 0.0f || panned[ch]) {
+
+        Mix_SetPanning(ch,
+            (Uint8)(pan > 0.0f ? 255 * (1.0f - pan) : 255),
+            (Uint8)(pan < 0.0f ? 255 * (1.0f + pan) : 255));
+        panned[ch] = pan != 0.0f;
     }
+
+    // Playing on a channel replaces what was there
+    Mix_Volume(ch, v);
+    Mix_PlayChannel(ch, s->chunk, 0);
 }
 
 
@@ -88,19 +210,42 @@ void play_sample(SAMPLE* s, float vol) {
 void stop_all_samples() {
 
     Mix_HaltChannel(-1);
+    mixer_stop_all();
+    voices_clear();
 }
 
 
 // Destroy sound & free memory
 void destroy_sample(SAMPLE* s) {
 
-    if(s == NULL) return;
+    if(s == NULL || -- s->refs > 0) return;
 
+    int i = 0;
+    for(; i < loadedCount; ++ i) {
+
+        if(loaded[i] == s) {
+
+            loaded[i] = loaded[-- loadedCount];
+            break;
+        }
+    }
+    memoryUsed -= s->chunk->alen;
+
+    // Halts the channels playing it
+    mixer_stop_data(s->chunk->abuf);
     Mix_FreeChunk(s->chunk);
+    free(s->pcm);
     free(s);
 }
 
 
+// Get the PCM bytes of the loaded samples
+Uint32 samples_memory() {
+
+    return memoryUsed;
+}
+
+
 // Enable/disable samples
 void enable_samples(bool state) {
 
@@ -10,12 +10,28 @@
 
 #include <stdbool.h>
 
+// Default voice settings of a sample
+#define SAMPLE_PRIORITY 0
+#define SAMPLE_POLYPHONY 4
+
+// Max samples loaded at once
+#define SAMPLE_LOADED_MAX 64
+// Max PCM bytes loaded at once
+#define SAMPLE_MEMORY_MAX (16 * 1024 * 1024)
+// Path buffer size
+#define SAMPLE_PATH_SIZE 128
+
 // Sample type
 typedef struct {
 
     Mix_Chunk* chunk;
-    int channel;
-    bool played;
+    Uint8* pcm; // Baked PCM of the chunk, NULL if the chunk owns it
+    Uint32 length; // In milliseconds
+    int priority; // Higher ones steal voices from lower
+    int polyphony; // Max voices playing this at once
+
+    char path[SAMPLE_PATH_SIZE];
+    int refs;
 }
 SAMPLE;
 
@@ -25,18 +41,30 @@ void init_samples();
 // Set global sample volume
 void set_global_sample_volume(int vol);
 
-// Load a sample
+// Load a sample. A sample already loaded from the same
+// path is shared. The PCM is baked in the device format
+// next to the file (path.pcm) and read from there on
+// the next load, unless the file has changed
 SAMPLE* load_sample(const char* path);
 
+// Set the voice priority and the polyphony limit
+void set_sample_voices(SAMPLE* s, int priority, int polyphony);
+
 // Play a sample
 void play_sample(SAMPLE* s, float vol);
 
+// Play a sample, panned from -1 (left) to 1 (right)
+void play_sample_pan(SAMPLE* s, float vol, float pan);
+
 // Stop all samples
 void stop_all_samples();
 
-// Destroy a sample
+// Destroy a sample. Freed once every load of it is
 void destroy_sample(SAMPLE* s);
 
+// Get the PCM bytes of the loaded samples
+Uint32 samples_memory();
+
 // Enable/disable samples
 void enable_samples(bool state);
 
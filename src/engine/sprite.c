@@ -5,6 +5,7 @@
 #include "sprite.h"
 
 #include "graphics.h"
+#include "batch.h"
 
 #include "../include/std.h"
 
@@ -75,4 +76,11 @@ void spr_draw_frame(SPRITE*s, _BITMAP* bmp, int frame, int row, int x, int y, in
 void spr_draw(SPRITE* s, _BITMAP* bmp, int x, int y, int flip) {
 
     spr_draw_frame(s,bmp,s->frame,s->row,x,y,flip);
-}
\ No newline at end of file
+}
+
+
+// Add a sprite to the sprite batch
+void spr_batch(SPRITE* s, _BITMAP* bmp, int x, int y, int flip, int layer) {
+
+    batch_add_region(bmp,s->w*s->frame,s->h*s->row,s->w,s->h,x,y,flip,layer);
+}
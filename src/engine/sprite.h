@@ -30,4 +30,7 @@ void spr_draw_frame(SPRITE*s, _BITMAP* bmp, int frame, int row, int x, int y, in
 // Draw a sprite
 void spr_draw(SPRITE* s, _BITMAP* bmp, int x, int y, int flip);
 
+// Add a sprite to the sprite batch
+void spr_batch(SPRITE* s, _BITMAP* bmp, int x, int y, int flip, int layer);
+
 #endif // __SPRITE__
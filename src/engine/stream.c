@@ -0,0 +1,746 @@
+// GOAT
+// Music streaming (source)
+// (c) 2018 Jani Nykänen
+
+#include "stream.h"
+
+#include "error.h"
+
+#include "../lib/tinycthread.h"
+
+#include "../include/std.h"
+
+#include <SDL2/SDL_mixer.h>
+#include <vorbis/vorbisfile.h>
+
+// Frames played at once
+#define BLOCK_FRAMES 1024
+// Frames decoded at once
+#define DECODE_FRAMES 4096
+// Frames decoded before a track starts
+#define PREFILL_FRAMES 8192
+
+// How often the worker tops up the rings (ms)
+static const long FILL_INTERVAL = 10;
+// Shortest fade out, so a cut does not click (ms)
+static const int DECLICK_MS = 5;
+
+// Deck states
+enum {
+
+    DECK_IDLE = 0, // Owned by the worker
+    DECK_LOADING = 1, // Owned by the worker
+    DECK_POSTED = 2, // Waiting for the callback
+    DECK_LIVE = 3, // Played by the callback
+    DECK_RETIRED = 4, // Done, to be closed by the worker
+};
+
+// A track being decoded & played
+typedef struct {
+
+    SDL_atomic_t state;
+    SDL_atomic_t write; // Frames decoded
+    SDL_atomic_t read; // Frames played
+    SDL_atomic_t eof; // Nothing more will be decoded
+    Sint16* ring;
+
+    // Worker only
+    OggVorbis_File vf;
+    SDL_AudioStream* conv; // NULL if no conversion needed
+    int loops; // Plays left after this, -1 for forever
+
+    // Callback only
+    float gain;
+    float target;
+    float step;
+    Uint32 fadeLeft;
+}
+DECK;
+
+// Request from the worker or the main thread to the
+// callback
+typedef struct {
+
+    bool set;
+    int deck; // -1 to fade out only
+    float gain;
+    Uint32 fade;
+}
+REQUEST;
+
+// Track requested from the worker
+typedef struct {
+
+    bool set;
+    char path[STREAM_PATH_SIZE];
+    float gain;
+    int loops;
+    Uint32 fade;
+}
+COMMAND;
+
+// Decks
+static DECK decks[STREAM_DECKS];
+
+// Worker
+static thrd_t worker;
+static mtx_t lock;
+static cnd_t wake;
+static COMMAND command;
+static bool quit;
+// Stops so far, a track loading over one is dropped
+static Uint32 stopSerial;
+// Decode buffers (worker only)
+static Sint16 decodeBuf[DECODE_FRAMES * 2];
+static Uint8 rawBuf[DECODE_FRAMES * 4];
+
+// Request to the callback
+static SDL_SpinLock requestLock;
+static REQUEST request;
+
+// Mix buffer (callback only)
+static float acc[BLOCK_FRAMES * 2];
+
+// Master volume (1/65536)
+static SDL_atomic_t volume;
+static SDL_atomic_t paused;
+
+// Output frequency
+static int freq;
+// Is initialized
+static bool initialized;
+// Is the callback registered
+static bool hooked;
+
+// Statistics
+static SDL_SpinLock statsLock;
+static STREAM_STATS stats;
+
+
+// Read from an SDL stream, for vorbisfile
+static size_t rw_read(void* ptr, size_t size, size_t nmemb, void* src) {
+
+    return SDL_RWread((SDL_RWops*)src, ptr, size, nmemb);
+}
+
+
+// Seek an SDL stream, for vorbisfile
+static int rw_seek(void* src, ogg_int64_t offset, int whence) {
+
+    return SDL_RWseek((SDL_RWops*)src, (Sint64)offset, whence) < 0 ? -1 : 0;
+}
+
+
+// Close an SDL stream, for vorbisfile
+static int rw_close(void* src) {
+
+    return SDL_RWclose((SDL_RWops*)src);
+}
+
+
+// Tell the position of an SDL stream, for vorbisfile
+static long rw_tell(void* src) {
+
+    return (long)SDL_RWtell((SDL_RWops*)src);
+}
+
+
+// Convert milliseconds to frames
+static Uint32 ms_to_frames(int ms) {
+
+    return ms <= 0 ? 0 : (Uint32)((Sint64)ms * freq / 1000);
+}
+
+
+// Post a request to the callback. A request it has not
+// seen yet is replaced, and its deck given back
+static void post_request(REQUEST r) {
+
+    SDL_AtomicLock(&requestLock);
+    if(request.set && request.deck >= 0)
+        SDL_AtomicSet(&decks[request.deck].state, DECK_RETIRED);
+    request = r;
+    request.set = true;
+    SDL_AtomicUnlock(&requestLock);
+}
+
+
+// Close a deck
+static void close_deck(DECK* d) {
+
+    ov_clear(&d->vf);
+    if(d->conv != NULL) {
+
+        SDL_FreeAudioStream(d->conv);
+        d->conv = NULL;
+    }
+    SDL_AtomicSet(&d->state, DECK_IDLE);
+}
+
+
+// Open a track on a deck. Returns 1 on error
+static int open_deck(DECK* d, const COMMAND* c) {
+
+    static const ov_callbacks CALLBACKS = {rw_read, rw_seek, rw_close, rw_tell};
+
+    SDL_RWops* rw = SDL_RWFromFile(c->path, "rb");
+    if(rw == NULL) {
+
+        printf("Failed to open a music file in %s\n", c->path);
+        return 1;
+    }
+
+    // The stream is closed with the file, unless
+    // opening fails
+    if(ov_open_callbacks(rw, &d->vf, NULL, 0, CALLBACKS) != 0) {
+
+        SDL_RWclose(rw);
+        printf("Not an Ogg Vorbis file: %s\n", c->path);
+        return 1;
+    }
+
+    vorbis_info* info = ov_info(&d->vf, -1);
+    d->conv = NULL;
+    if(info->channels != 2 || info->rate != freq) {
+
+        d->conv = SDL_NewAudioStream(AUDIO_S16SYS, (Uint8)info->channels, (int)info->rate,
+            AUDIO_S16SYS, 2, freq);
+        if(d->conv == NULL) {
+
+            ov_clear(&d->vf);
+            printf("Cannot convert the music in %s\n", c->path);
+            return 1;
+        }
+    }
+
+    d->loops = c->loops < 0 ? -1 : (c->loops > 1 ? c->loops-1 : 0);
+    SDL_AtomicSet(&d->write, 0);
+    SDL_AtomicSet(&d->read, 0);
+    SDL_AtomicSet(&d->eof, 0);
+
+    return 0;
+}
+
+
+// Decode frames of a deck. Returns the number of
+// frames, -1 at the end of the track
+static int decode(DECK* d, Sint16* out, int frames) {
+
+    int bitstream = 0;
+    int got;
+    long bytes;
+
+    while(true) {
+
+        // Converted frames first
+        if(d->conv != NULL) {
+
+            got = SDL_AudioStreamGet(d->conv, out, frames * 4);
+            if(got > 0) return got / 4;
+
+            bytes = ov_read(&d->vf, (char*)rawBuf, sizeof(rawBuf),
+                SDL_BYTEORDER == SDL_BIG_ENDIAN, 2, 1, &bitstream);
+        }
+        else {
+
+            bytes = ov_read(&d->vf, (char*)out, frames * 4,
+                SDL_BYTEORDER == SDL_BIG_ENDIAN, 2, 1, &bitstream);
+        }
+
+        // Skip a hole in the data
+        if(bytes == OV_HOLE) continue;
+
+        if(bytes > 0) {
+
+            if(d->conv == NULL) return (int)(bytes / 4);
+
+            if(SDL_AudioStreamPut(d->conv, rawBuf, (int)bytes) != 0)
+                return -1;
+            continue;
+        }
+
+        // The end, loop without a gap
+        if(bytes == 0 && d->loops != 0 && ov_pcm_seek(&d->vf, 0) == 0) {
+
+            if(d->loops > 0) -- d->loops;
+            continue;
+        }
+
+        // Out of data (or an error)
+        if(d->conv != NULL && SDL_AudioStreamAvailable(d->conv) == 0) {
+
+            SDL_AudioStreamFlush(d->conv);
+            if(SDL_AudioStreamAvailable(d->conv) > 0) continue;
+        }
+        return -1;
+    }
+}
+
+
+// Decode into the ring of a deck, until it is full or
+// at least "frames" ahead. Returns frames ahead
+static Uint32 fill_deck(DECK* d, Uint32 frames) {
+
+    Uint32 w = (Uint32)SDL_AtomicGet(&d->write);
+    Uint32 ahead = w - (Uint32)SDL_AtomicGet(&d->read);
+    Uint32 space;
+    Uint32 pos;
+    Uint32 first;
+    int n;
+
+    while(ahead < frames && SDL_AtomicGet(&d->eof) == 0) {
+
+        space = STREAM_RING_FRAMES - ahead;
+        n = decode(d, decodeBuf, space < DECODE_FRAMES ? (int)space : DECODE_FRAMES);
+        if(n < 0) {
+
+            SDL_AtomicSet(&d->eof, 1);
+            break;
+        }
+
+        // Copy, wrapping around
+        pos = w & (STREAM_RING_FRAMES-1);
+        first = STREAM_RING_FRAMES - pos < (Uint32)n ? STREAM_RING_FRAMES - pos : (Uint32)n;
+        memcpy(d->ring + pos*2, decodeBuf, first * 4);
+        memcpy(d->ring, decodeBuf + first*2, ((Uint32)n - first) * 4);
+
+        // The frames are published after they are copied
+        w += (Uint32)n;
+        ahead += (Uint32)n;
+        SDL_AtomicSet(&d->write, (int)w);
+    }
+
+    return ahead;
+}
+
+
+// Start a requested track. Serial is the stop count
+// when it was taken
+static void start_track(int i, const COMMAND* c, Uint32 serial) {
+
+    DECK* d = &decks[i];
+    if(open_deck(d, c) == 1) {
+
+        SDL_AtomicSet(&d->state, DECK_IDLE);
+        return;
+    }
+
+    // Enough to start with, the rest while playing
+    fill_deck(d, PREFILL_FRAMES);
+
+    REQUEST r;
+    r.deck = i;
+    r.gain = c->gain;
+    r.fade = c->fade;
+
+    // Checked & posted under the lock, so a stop either
+    // comes after this and fades it out, or before and
+    // the track never plays
+    mtx_lock(&lock);
+    if(serial != stopSerial) {
+
+        mtx_unlock(&lock);
+        close_deck(d);
+        return;
+    }
+    SDL_AtomicSet(&d->state, DECK_POSTED);
+    post_request(r);
+    mtx_unlock(&lock);
+}
+
+
+// Worker thread
+static int worker_thread(void* arg) {
+
+    COMMAND c;
+    Uint32 serial = 0;
+    struct timespec ts;
+    int i;
+    int idle;
+    int state;
+
+    while(true) {
+
+        // Close the tracks the callback is done with
+        idle = -1;
+        for(i = 0; i < STREAM_DECKS; ++ i) {
+
+            state = SDL_AtomicGet(&decks[i].state);
+            if(state == DECK_RETIRED)
+                close_deck(&decks[i]);
+            if(state == DECK_RETIRED || state == DECK_IDLE)
+                idle = i;
+        }
+
+        // Sleep until asked, or until it is time to top up
+        mtx_lock(&lock);
+        if((!command.set || idle < 0) && !quit) {
+
+            timespec_get(&ts, TIME_UTC);
+            ts.tv_nsec += FILL_INTERVAL * 1000000;
+            if(ts.tv_nsec >= 1000000000) {
+
+                ts.tv_nsec -= 1000000000;
+                ++ ts.tv_sec;
+            }
+            cnd_timedwait(&wake, &lock, &ts);
+        }
+        if(quit) {
+
+            mtx_unlock(&lock);
+            break;
+        }
+
+        // Waits for a free deck, if all are fading
+        c.set = command.set && idle >= 0;
+        if(c.set) {
+
+            c = command;
+            command.set = false;
+            serial = stopSerial;
+            SDL_AtomicSet(&decks[idle].state, DECK_LOADING);
+        }
+        mtx_unlock(&lock);
+
+        if(c.set)
+            start_track(idle, &c, serial);
+
+        // Top up
+        for(i = 0; i < STREAM_DECKS; ++ i) {
+
+            state = SDL_AtomicGet(&decks[i].state);
+            if(state == DECK_POSTED || state == DECK_LIVE)
+                fill_deck(&decks[i], STREAM_RING_FRAMES);
+        }
+    }
+
+    return 0;
+}
+
+
+// Music callback
+static void callback(void* udata, Uint8* stream, int len) {
+
+    stream_render((Sint16*)stream, len / (int)(sizeof(Sint16) * 2));
+}
+
+
+// Take a request from the other threads
+static void take_request() {
+
+    REQUEST r;
+    SDL_AtomicLock(&requestLock);
+    r = request;
+    request.set = false;
+    SDL_AtomicUnlock(&requestLock);
+
+    if(!r.set) return;
+
+    // Fade out the others from where they are
+    Uint32 declick = ms_to_frames(DECLICK_MS);
+    Uint32 out = r.fade > declick ? r.fade : declick;
+    DECK* d;
+    int i = 0;
+    for(; i < STREAM_DECKS; ++ i) {
+
+        d = &decks[i];
+        if(i == r.deck || SDL_AtomicGet(&d->state) != DECK_LIVE)
+            continue;
+
+        d->target = 0.0f;
+        d->fadeLeft = out;
+        d->step = -d->gain / (float)out;
+    }
+
+    if(r.deck < 0) return;
+
+    d = &decks[r.deck];
+    d->target = r.gain;
+    d->fadeLeft = r.fade;
+    d->gain = r.fade > 0 ? 0.0f : r.gain;
+    d->step = r.fade > 0 ? r.gain / (float)r.fade : 0.0f;
+    SDL_AtomicSet(&d->state, DECK_LIVE);
+
+    SDL_AtomicLock(&statsLock);
+    ++ stats.fades;
+    SDL_AtomicUnlock(&statsLock);
+}
+
+
+// Mix the frames of a deck, with its fade. Returns
+// the number of frames mixed
+static int mix_deck(DECK* d, int frames) {
+
+    Uint32 r = (Uint32)SDL_AtomicGet(&d->read);
+    Uint32 ahead = (Uint32)SDL_AtomicGet(&d->write) - r;
+    int n = ahead < (Uint32)frames ? (int)ahead : frames;
+
+    const Sint16* src;
+    Uint32 pos;
+    int i = 0;
+    for(; i < n; ++ i) {
+
+        pos = (r + (Uint32)i) & (STREAM_RING_FRAMES-1);
+        src = d->ring + pos*2;
+        acc[i*2] += (float)src[0] * d->gain;
+        acc[i*2 +1] += (float)src[1] * d->gain;
+
+        // Sample-accurate fade
+        if(d->fadeLeft > 0) {
+
+            d->gain += d->step;
+            if(-- d->fadeLeft == 0)
+                d->gain = d->target;
+        }
+    }
+
+    // The frames can be written over now
+    SDL_AtomicSet(&d->read, (int)(r + (Uint32)n));
+
+    return n;
+}
+
+
+// Play a block of frames. Returns true if a track ran
+// out of decoded frames
+static bool render_block(Sint16* out, int frames, float master) {
+
+    bool underrun = false;
+    DECK* d;
+    int n;
+    int i = 0;
+
+    memset(acc, 0, sizeof(float) * frames * 2);
+
+    for(; i < STREAM_DECKS; ++ i) {
+
+        d = &decks[i];
+        if(SDL_AtomicGet(&d->state) != DECK_LIVE) continue;
+
+        n = mix_deck(d, frames);
+
+        // Done: ended, or faded out
+        if((n < frames && SDL_AtomicGet(&d->eof) != 0
+          && SDL_AtomicGet(&d->write) == SDL_AtomicGet(&d->read))
+         || (d->fadeLeft == 0 && d->target <= 0.0f)) {
+
+            SDL_AtomicSet(&d->state, DECK_RETIRED);
+        }
+        else if(n < frames) {
+
+            underrun = true;
+        }
+    }
+
+    float s;
+    for(i = 0; i < frames * 2; ++ i) {
+
+        s = acc[i] * master;
+        out[i] = (Sint16)(s > SDL_MAX_SINT16 ? SDL_MAX_SINT16
+            : (s < SDL_MIN_SINT16 ? SDL_MIN_SINT16 : s));
+    }
+
+    return underrun;
+}
+
+
+// Initialize streaming
+int stream_init(int frequency, bool hook) {
+
+    int i = 0;
+
+    freq = frequency;
+    memset(&stats, 0, sizeof(STREAM_STATS));
+    memset(&request, 0, sizeof(REQUEST));
+    memset(&command, 0, sizeof(COMMAND));
+    stopSerial = 0;
+    SDL_AtomicSet(&volume, 65536);
+    SDL_AtomicSet(&paused, 0);
+    quit = false;
+
+    for(; i < STREAM_DECKS; ++ i) {
+
+        memset(&decks[i], 0, sizeof(DECK));
+        decks[i].ring = (Sint16*)malloc(sizeof(Sint16) * 2 * STREAM_RING_FRAMES);
+        if(decks[i].ring == NULL) {
+
+            error_mem_alloc();
+            return 1;
+        }
+    }
+
+    if(mtx_init(&lock, mtx_plain) != thrd_success
+    || cnd_init(&wake) != thrd_success) {
+
+        error_throw("Failed to create music synchronization objects!", NULL);
+        return 1;
+    }
+
+    if(thrd_create(&worker, worker_thread, NULL) != thrd_success) {
+
+        error_throw("Failed to create the music thread!", NULL);
+        return 1;
+    }
+
+    if(hook)
+        Mix_HookMusic(callback, NULL);
+
+    hooked = hook;
+    initialized = true;
+
+    return 0;
+}
+
+
+// Start a track
+void stream_play(const char* path, float vol, int loops, int fadeFrames) {
+
+    if(!initialized) return;
+
+    mtx_lock(&lock);
+    snprintf(command.path, STREAM_PATH_SIZE, "%s", path);
+    command.gain = vol;
+    command.loops = loops;
+    command.fade = fadeFrames > 0 ? (Uint32)fadeFrames : 0;
+    command.set = true;
+    cnd_signal(&wake);
+    mtx_unlock(&lock);
+}
+
+
+// Fade out everything
+void stream_stop(int fadeFrames) {
+
+    if(!initialized) return;
+
+    REQUEST r;
+    r.deck = -1;
+    r.gain = 0.0f;
+    r.fade = fadeFrames > 0 ? (Uint32)fadeFrames : 0;
+
+    // A track not started yet is not started at all,
+    // and one still loading is dropped by the worker
+    mtx_lock(&lock);
+    command.set = false;
+    ++ stopSerial;
+    post_request(r);
+    mtx_unlock(&lock);
+}
+
+
+// Set the master volume
+void stream_set_volume(float vol) {
+
+    if(vol < 0.0f) vol = 0.0f;
+    if(vol > 1.0f) vol = 1.0f;
+
+    SDL_AtomicSet(&volume, (int)(vol * 65536.0f));
+}
+
+
+// Pause or resume
+void stream_pause(bool state) {
+
+    SDL_AtomicSet(&paused, state ? 1 : 0);
+}
+
+
+// Play decoded frames
+void stream_render(Sint16* out, int frames) {
+
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    float master = (float)SDL_AtomicGet(&volume) / 65536.0f;
+    bool underrun = false;
+    int n;
+    int pos = 0;
+
+    take_request();
+
+    // Paused, nothing is used up
+    if(SDL_AtomicGet(&paused) != 0) {
+
+        memset(out, 0, sizeof(Sint16) * 2 * frames);
+        return;
+    }
+
+    while(pos < frames) {
+
+        n = frames - pos < BLOCK_FRAMES ? frames - pos : BLOCK_FRAMES;
+        if(render_block(out + pos*2, n, master))
+            underrun = true;
+
+        pos += n;
+    }
+
+    double us = (double)(SDL_GetPerformanceCounter() - start) * 1000000.0
+        / (double)SDL_GetPerformanceFrequency();
+    double budget = freq > 0 ? (double)frames * 1000000.0 / (double)freq : 0.0;
+
+    SDL_AtomicLock(&statsLock);
+    ++ stats.calls;
+    if(underrun) ++ stats.underruns;
+    stats.totalUs += us;
+    if(us > stats.maxUs) stats.maxUs = us;
+    if(budget > stats.budgetUs) stats.budgetUs = budget;
+    SDL_AtomicUnlock(&statsLock);
+}
+
+
+// Get the statistics
+STREAM_STATS stream_get_stats() {
+
+    SDL_AtomicLock(&statsLock);
+    STREAM_STATS s = stats;
+    SDL_AtomicUnlock(&statsLock);
+
+    return s;
+}
+
+
+// Print the statistics
+void stream_print_stats() {
+
+    STREAM_STATS s = stream_get_stats();
+    if(s.calls == 0) return;
+
+    printf("Music: %u buffers, %.2f us mean, %.2f us max (budget %.0f us), "
+        "%u underruns, %u tracks\n",
+        s.calls, s.totalUs / s.calls, s.maxUs, s.budgetUs,
+        s.underruns, s.fades);
+}
+
+
+// Stop streaming
+void stream_destroy() {
+
+    if(!initialized) return;
+
+    // The callback is not running after this
+    if(hooked)
+        Mix_HookMusic(NULL, NULL);
+
+    mtx_lock(&lock);
+    quit = true;
+    cnd_signal(&wake);
+    mtx_unlock(&lock);
+    thrd_join(worker, NULL);
+
+    int i = 0;
+    int state;
+    for(; i < STREAM_DECKS; ++ i) {
+
+        state = SDL_AtomicGet(&decks[i].state);
+        if(state != DECK_IDLE)
+            close_deck(&decks[i]);
+
+        free(decks[i].ring);
+        decks[i].ring = NULL;
+    }
+
+    cnd_destroy(&wake);
+    mtx_destroy(&lock);
+
+    hooked = false;
+    initialized = false;
+}
@@ -0,0 +1,66 @@
+// GOAT
+// Music streaming (header)
+// (c) 2018 Jani Nykänen
+
+#ifndef __STREAM__
+#define __STREAM__
+
+#include <SDL2/SDL.h>
+
+#include <stdbool.h>
+
+// Decoded frames kept ahead per track (a power of two)
+#define STREAM_RING_FRAMES 32768
+// Tracks playing or loading at once
+#define STREAM_DECKS 3
+// Path buffer size
+#define STREAM_PATH_SIZE 128
+
+// Playback statistics
+typedef struct {
+
+    Uint32 calls; // Buffers played
+    Uint32 underruns; // Buffers that ran out of decoded frames
+    Uint32 fades; // Tracks started
+    double totalUs; // Time spent in the callback
+    double maxUs; // Longest callback
+    double budgetUs; // Length of the longest buffer
+}
+STREAM_STATS;
+
+// Initialize streaming. Tracks are decoded by a worker
+// thread to 16-bit stereo at the given frequency. If
+// "hook" is set, the music of SDL_mixer is replaced
+// (otherwise call stream_render yourself). Returns 1
+// on error
+int stream_init(int frequency, bool hook);
+
+// Start an Ogg Vorbis track, crossfaded from what plays
+// over the given number of frames. The file is opened
+// and decoded on the worker. Loops is the number of
+// plays, -1 for forever
+void stream_play(const char* path, float vol, int loops, int fadeFrames);
+
+// Fade out everything that plays
+void stream_stop(int fadeFrames);
+
+// Set the master volume
+void stream_set_volume(float vol);
+
+// Pause or resume
+void stream_pause(bool state);
+
+// Play decoded frames into a 16-bit stereo buffer
+// (replaces what is there)
+void stream_render(Sint16* out, int frames);
+
+// Get the statistics
+STREAM_STATS stream_get_stats();
+
+// Print the statistics
+void stream_print_stats();
+
+// Stop streaming
+void stream_destroy();
+
+#endif // __STREAM__
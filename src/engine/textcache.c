@@ -0,0 +1,357 @@
+// GOAT
+// Text cache (source)
+// (c) 2018 Jani Nykänen
+
+#include "textcache.h"
+
+#include "graphics.h"
+#include "error.h"
+
+#include "../include/std.h"
+
+// Cached text entry
+typedef struct {
+
+    _BITMAP* font;
+    char text[TEXT_CACHE_STRING_LENGTH];
+    Uint32 hash;
+    int xoff;
+    int yoff;
+    int len;
+
+    // Pre-rendered string & its position relative
+    // to the text origin
+    _BITMAP* bmp;
+    int ox;
+    int oy;
+
+    // Opaque spans, (x, length) pairs. Row y uses
+    // the pairs from rows[y] to rows[y+1]-1
+    int* rows;
+    Uint16* spans;
+
+    Uint32 lastUse;
+    bool used;
+}
+TEXT_ENTRY;
+
+// Entries
+static TEXT_ENTRY entries[TEXT_CACHE_SIZE];
+// Use counter
+static Uint32 useCounter;
+
+
+// Hash a string (FNV-1a), also computes the length
+static Uint32 hash_string(const char* text, int* len) {
+
+    Uint32 h = 2166136261u;
+    int i = 0;
+    for(; text[i] != '\0'; ++ i) {
+
+        h ^= (Uint8)text[i];
+        h *= 16777619u;
+    }
+    *len = i;
+
+    return h;
+}
+
+
+// Free the data of an entry
+static void free_entry(TEXT_ENTRY* e) {
+
+    if(e->bmp != NULL)
+        bitmap_destroy(e->bmp);
+    if(e->rows != NULL)
+        free(e->rows);
+    if(e->spans != NULL)
+        free(e->spans);
+
+    e->bmp = NULL;
+    e->rows = NULL;
+    e->spans = NULL;
+    e->used = false;
+}
+
+
+// Compute the opaque spans of the pre-rendered string
+static int compute_spans(TEXT_ENTRY* e) {
+
+    _BITMAP* b = e->bmp;
+    Uint8 alpha = get_alpha();
+    int x, y, start;
+    int count = 0;
+    Uint8* row;
+
+    // Count spans first
+    for(y = 0; y < b->height; ++ y) {
+
+        row = b->data + y * b->width;
+        for(x = 0; x < b->width; ++ x) {
+
+            if(row[x] != alpha && (x == 0 || row[x-1] == alpha))
+                ++ count;
+        }
+    }
+
+    e->rows = (int*)malloc(sizeof(int) * (b->height+1));
+    e->spans = (Uint16*)malloc(sizeof(Uint16) * 2 * (count > 0 ? count : 1));
+    if(e->rows == NULL || e->spans == NULL) {
+
+        error_mem_alloc();
+        return 1;
+    }
+
+    // Store spans
+    count = 0;
+    for(y = 0; y < b->height; ++ y) {
+
+        e->rows[y] = count;
+
+        row = b->data + y * b->width;
+        x = 0;
+        while(x < b->width) {
+
+            if(row[x] == alpha) {
+
+                ++ x;
+                continue;
+            }
+
+            start = x;
+            while(x < b->width && row[x] != alpha)
+                ++ x;
+
+            e->spans[count*2] = (Uint16)start;
+            e->spans[count*2 +1] = (Uint16)(x - start);
+            ++ count;
+        }
+    }
+    e->rows[b->height] = count;
+
+    return 0;
+}
+
+
+// Render a string to an entry
+static int rasterise(TEXT_ENTRY* e) {
+
+    _BITMAP* font = e->font;
+    const char* text = e->text;
+    Uint8 alpha = get_alpha();
+
+    int cw = font->width / 16;
+    int ch = cw;
+    int i;
+    unsigned char c;
+
+    // Find the bounds of the glyphs
+    int x = 0;
+    int y = 0;
+    int minx = 0, miny = 0, maxx = 0, maxy = 0;
+    bool first = true;
+    for(i = 0; i < e->len; ++ i) {
+
+        c = text[i];
+        if(c == '\n') {
+
+            x = 0;
+            y += e->yoff + ch;
+            continue;
+        }
+
+        if(first || x < minx) minx = x;
+        if(first || y < miny) miny = y;
+        if(first || x+cw > maxx) maxx = x+cw;
+        if(first || y+ch > maxy) maxy = y+ch;
+        first = false;
+
+        x += cw + e->xoff;
+    }
+
+    // Nothing to be drawn
+    if(first) {
+
+        e->bmp = NULL;
+        return 0;
+    }
+
+    e->ox = minx;
+    e->oy = miny;
+    e->bmp = bitmap_create(maxx-minx, maxy-miny);
+    if(e->bmp == NULL) {
+
+        return 1;
+    }
+    memset(e->bmp->data, alpha, e->bmp->width * e->bmp->height);
+
+    // Copy glyphs
+    int gx, gy, px, py;
+    Uint8 col;
+    x = -minx;
+    y = -miny;
+    for(i = 0; i < e->len; ++ i) {
+
+        c = text[i];
+        if(c == '\n') {
+
+            x = -minx;
+            y += e->yoff + ch;
+            continue;
+        }
+
+        gx = (c % 16) * cw;
+        gy = (c / 16) * ch;
+        if(gy + ch <= font->height) {
+
+            for(py = 0; py < ch; ++ py) {
+
+                for(px = 0; px < cw; ++ px) {
+
+                    col = font->data[(gy+py) * font->width + gx+px];
+                    if(col != alpha)
+                        e->bmp->data[(y+py) * e->bmp->width + x+px] = col;
+                }
+            }
+        }
+
+        x += cw + e->xoff;
+    }
+
+    return compute_spans(e);
+}
+
+
+// Find an entry, or create one
+static TEXT_ENTRY* get_entry(_BITMAP* font, const char* text, int len, Uint32 hash, int xoff, int yoff) {
+
+    int i = 0;
+    TEXT_ENTRY* e;
+    TEXT_ENTRY* victim = &entries[0];
+
+    for(; i < TEXT_CACHE_SIZE; ++ i) {
+
+        e = &entries[i];
+        if(!e->used) {
+
+            if(victim->used)
+                victim = e;
+            continue;
+        }
+
+        if(e->hash == hash && e->font == font && e->xoff == xoff && e->yoff == yoff
+         && e->len == len && strcmp(e->text, text) == 0) {
+
+            return e;
+        }
+
+        // Least recently used
+        if(victim->used && e->lastUse < victim->lastUse)
+            victim = e;
+    }
+
+    // Replace the victim
+    free_entry(victim);
+
+    victim->font = font;
+    victim->hash = hash;
+    victim->xoff = xoff;
+    victim->yoff = yoff;
+    victim->len = len;
+    memcpy(victim->text, text, len+1);
+
+    if(rasterise(victim) == 1) {
+
+        free_entry(victim);
+        return NULL;
+    }
+    victim->used = true;
+
+    return victim;
+}
+
+
+// Draw text with a _BITMAP font, using a cached
+// pre-rendered copy of the string
+void draw_text_cached(_BITMAP* font, const char* text,
+    int dx, int dy, int xoff, int yoff, bool center) {
+
+    int len;
+    Uint32 hash = hash_string(text, &len);
+
+    // Too long to be cached
+    if(len >= TEXT_CACHE_STRING_LENGTH) {
+
+        draw_text(font, text, dx, dy, xoff, yoff, center);
+        return;
+    }
+
+    TEXT_ENTRY* e = get_entry(font, text, len, hash, xoff, yoff);
+    if(e == NULL) {
+
+        draw_text(font, text, dx, dy, xoff, yoff, center);
+        return;
+    }
+    e->lastUse = ++ useCounter;
+
+    if(e->bmp == NULL) return;
+
+    FRAME* f = get_global_frame();
+    _POINT tr = get_translation();
+
+    int cw = font->width / 16;
+    if(center) {
+
+        dx -= (len+1) * (cw+xoff) / 2;
+    }
+
+    int x = dx + e->ox + tr.x;
+    int y = dy + e->oy + tr.y;
+
+    // Clip rows
+    int ystart = y < 0 ? -y : 0;
+    int yend = e->bmp->height;
+    if(y + yend > f->height)
+        yend = f->height - y;
+
+    int row, i, sx, sw, px;
+    Uint8* dst;
+    Uint8* src;
+    for(row = ystart; row < yend; ++ row) {
+
+        dst = f->data + (y+row) * f->width;
+        src = e->bmp->data + row * e->bmp->width;
+
+        for(i = e->rows[row]; i < e->rows[row+1]; ++ i) {
+
+            sx = e->spans[i*2];
+            sw = e->spans[i*2 +1];
+            px = x + sx;
+
+            // Clip the span
+            if(px < 0) {
+
+                sx -= px;
+                sw += px;
+                px = 0;
+            }
+            if(px + sw > f->width)
+                sw = f->width - px;
+
+            if(sw > 0)
+                memcpy(dst + px, src + sx, sw);
+        }
+    }
+}
+
+
+// Clear the text cache
+void text_cache_clear() {
+
+    int i = 0;
+    for(; i < TEXT_CACHE_SIZE; ++ i) {
+
+        free_entry(&entries[i]);
+    }
+    useCounter = 0;
+}
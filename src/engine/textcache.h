@@ -0,0 +1,25 @@
+// GOAT
+// Text cache (header)
+// (c) 2018 Jani Nykänen
+
+#ifndef __TEXT_CACHE__
+#define __TEXT_CACHE__
+
+#include "bitmap.h"
+
+#include <stdbool.h>
+
+// Cache slot count
+#define TEXT_CACHE_SIZE 64
+
+// Max length of a cached string
+#define TEXT_CACHE_STRING_LENGTH 64
+
+// Draw text with a _BITMAP font, using a cached
+// pre-rendered copy of the string
+void draw_text_cached(_BITMAP* font, const char* text, int x, int y, int xoff, int yoff, bool center);
+
+// Clear the text cache
+void text_cache_clear();
+
+#endif // __TEXT_CACHE__
@@ -0,0 +1,124 @@
+// GOAT
+// Voice allocator (source)
+// (c) 2018 Jani Nykänen
+
+#include "voice.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+// Voice
+typedef struct {
+
+    const void* owner; // NULL if free
+    int priority;
+    Uint32 serial; // Start order
+    Uint32 end; // Ticks when done
+}
+VOICE;
+
+// Voices
+static VOICE voices[VOICE_MAX];
+static int voiceCount;
+// Start counter
+static Uint32 serial;
+
+
+// Is a voice playing
+static bool is_active(VOICE* v, Uint32 now) {
+
+    return v->owner != NULL && (Sint32)(v->end - now) > 0;
+}
+
+
+// Initialize the voice pool
+void voices_init(int count) {
+
+    voiceCount = count < 1 ? 1 : (count > VOICE_MAX ? VOICE_MAX : count);
+    serial = 0;
+    voices_clear();
+}
+
+
+// Allocate a voice for a sound
+int voice_alloc(const void* owner, int priority, int polyphony, Uint32 length) {
+
+    Uint32 now = SDL_GetTicks();
+
+    int own = 0;
+    int oldestOwn = -1;
+    int idle = -1;
+    int victim = -1;
+    VOICE* v;
+
+    int i = 0;
+    for(; i < voiceCount; ++ i) {
+
+        v = &voices[i];
+        if(!is_active(v, now)) {
+
+            if(idle < 0) idle = i;
+            continue;
+        }
+
+        if(v->owner == owner) {
+
+            ++ own;
+            if(oldestOwn < 0 || v->serial < voices[oldestOwn].serial)
+                oldestOwn = i;
+        }
+
+        // Lowest priority, then oldest
+        if(victim < 0 || v->priority < voices[victim].priority
+         || (v->priority == voices[victim].priority
+          && v->serial < voices[victim].serial))
+            victim = i;
+    }
+
+    if(polyphony > 0 && own >= polyphony)
+        i = oldestOwn;
+    else if(idle >= 0)
+        i = idle;
+    else if(victim >= 0 && voices[victim].priority <= priority)
+        i = victim;
+    else
+        return -1;
+
+    v = &voices[i];
+    v->owner = owner;
+    v->priority = priority;
+    v->serial = ++ serial;
+    v->end = now + length;
+
+    return i;
+}
+
+
+// Free all the voices
+void voices_clear() {
+
+    memset(voices, 0, sizeof(voices));
+}
+
+
+// Get the number of voices playing
+int voices_active() {
+
+    Uint32 now = SDL_GetTicks();
+    int count = 0;
+    int i = 0;
+    for(; i < voiceCount; ++ i) {
+
+        if(is_active(&voices[i], now))
+            ++ count;
+    }
+
+    return count;
+}
+
+
+// Get the number of voices
+int voices_count() {
+
+    return voiceCount;
+}
@@ -0,0 +1,32 @@
+// GOAT
+// Voice allocator (header)
+// (c) 2018 Jani Nykänen
+
+#ifndef __VOICE__
+#define __VOICE__
+
+#include <SDL2/SDL.h>
+
+// Max voices
+#define VOICE_MAX 64
+
+// Initialize the voice pool
+void voices_init(int count);
+
+// Allocate a voice for a sound. A free voice is used
+// first, then the oldest one of the lowest priority
+// (not above the given one). A sound that already
+// plays on "polyphony" voices takes its own oldest.
+// Returns the voice index, -1 if none can be used
+int voice_alloc(const void* owner, int priority, int polyphony, Uint32 length);
+
+// Free all the voices
+void voices_clear();
+
+// Get the number of voices playing
+int voices_active();
+
+// Get the number of voices
+int voices_count();
+
+#endif // __VOICE__
@@ -0,0 +1,402 @@
+// GOAT
+// Autoplay bot (source)
+// (c) 2018 Jani Nykänen
+
+#include "bot.h"
+
+#include "../include/std.h"
+
+// Max plans tried per frame
+#define PLAN_MAX 64
+// Hold lengths tried for the stick
+#define PLAN_HOLD_COUNT 3
+
+// Constants
+static const float DROP_LIMIT = 184.0f;
+static const float PANIC_LIMIT = 96.0f;
+static const float STEER_DISTANCE = 12.0f;
+static const float GOAT_WIDTH = 8.0f;
+static const float GOAT_SPEED = 1.5f;
+static const float THREAT_Y = 28.0f;
+static const float HOLE_CLEARANCE = 24.0f;
+static const float LANDING_CLEARANCE = 32.0f;
+static const float MONSTER_PENALTY = 256.0f;
+static const int PLAN_HOLD[PLAN_HOLD_COUNT] = {8, 32, 64};
+static const int PLAN_LENGTH = 96;
+static const float HEALTH_WEIGHT = 1000.0f;
+static const float COMFORT_Y = 112.0f;
+static const float TOP_LIMIT = 64.0f;
+static const float TOP_WEIGHT = 24.0f;
+
+// Plan. The stick & the button are held for a while,
+// the target is followed while on the same platform
+typedef struct {
+
+    int platform; // -1 if no target
+    float target;
+    float stick;
+    bool holdStick;
+    int button; // -1 if none
+    int hold; // Frames the stick & the button are held
+}
+PLAN;
+
+
+// Get the signed distance between two x positions.
+// The stage wraps around, so this is never more than
+// half the stage width
+static float x_distance(float from, float to) {
+
+    float d = to - from;
+    if(d > 128.0f) d -= 256.0f;
+    else if(d < -128.0f) d += 256.0f;
+
+    return d;
+}
+
+
+// Get the first platform at or below a (world) y
+// position, -1 if none
+static int platform_below(GAME_STATE* s, float y) {
+
+    PLATFORM* p;
+    float camY = s->cam.pos.y;
+    int best = -1;
+
+    int i = 0;
+    for(; i < PLATFORM_COUNT; ++ i) {
+
+        p = &s->stage.platforms[i];
+        if(!p->exist || p->y + camY < y)
+            continue;
+
+        if(best == -1 || p->y < s->stage.platforms[best].y)
+            best = i;
+    }
+
+    return best;
+}
+
+
+// Get the platform the goat is on (or falling to),
+// and the one below it
+static void find_platforms(GAME_STATE* s, int* cur, int* below) {
+
+    *cur = platform_below(s, s->player.pos.y - 1.0f);
+    *below = *cur == -1 ? -1
+        : platform_below(s, s->stage.platforms[*cur].y + s->cam.pos.y + 1.0f);
+}
+
+
+// Would the goat land on a platform at an x position.
+// The goat lands if it overlaps a solid run, so it only
+// falls through holes wider than itself
+static bool is_solid(PLATFORM* p, float x) {
+
+    int i = 0;
+    for(; i < p->runCount; ++ i) {
+
+        if(x >= p->runStart[i]*16.0f - GOAT_WIDTH
+         && x < (p->runStart[i] + p->runLength[i])*16.0f + GOAT_WIDTH)
+            return true;
+    }
+
+    return false;
+}
+
+
+// Find the nearest x position over solid ground
+static float find_ground(PLATFORM* p, float x) {
+
+    float best = x;
+    float c;
+    int i = 0;
+    for(; i < p->runCount; ++ i) {
+
+        c = fmaxf(p->runStart[i]*16.0f,
+            fminf(x, (p->runStart[i] + p->runLength[i])*16.0f));
+        if(i == 0 || fabsf(c-x) < fabsf(best-x))
+            best = c;
+    }
+
+    return best;
+}
+
+
+// Get the center of a gap between the solid runs of a
+// platform (gap i is left of run i), -1 if too narrow
+static float gap_center(PLATFORM* p, int i) {
+
+    float start = i == 0 ? 0.0f
+        : (p->runStart[i-1] + p->runLength[i-1])*16.0f + GOAT_WIDTH;
+    float end = i == p->runCount ? 256.0f
+        : p->runStart[i]*16.0f - GOAT_WIDTH;
+
+    return end - start < 1.0f ? -1.0f : (start + end) / 2.0f;
+}
+
+
+// Count the monsters near a point. Moving monsters
+// count if their path crosses the point
+static int monsters_near(GAME_STATE* s, float x, float y, float w, float h) {
+
+    MONSTER_LIST* l = &s->monsters;
+    int count = 0;
+    int k, i;
+    bool inPath;
+
+    for(k = 0; k < l->activeCount; ++ k) {
+
+        i = l->active[k];
+        if(!l->exist[i] || l->id[i] == MONSTER_FISH || fabsf(l->y[i]-y) >= h)
+            continue;
+
+        inPath = (l->id[i] == MONSTER_WALKER || l->id[i] == MONSTER_FLIER)
+            && x+w > l->leftLimit[i] && x-w < l->rightLimit[i];
+
+        if(inPath || fabsf(l->x[i]-x) < w)
+            ++ count;
+    }
+
+    return count;
+}
+
+
+// Find the best hole to drop through. Returns the
+// x position to go to, or -1 if none found
+static float find_hole(GAME_STATE* s, PLATFORM* cur, PLATFORM* below, float gx, bool panic) {
+
+    float camY = s->cam.pos.y;
+    float y = cur->y + camY;
+    float by = below->y + camY;
+
+    float best = -1.0f;
+    float bestCost = 0.0f;
+    float x, cost;
+    int i;
+
+    for(i = 0; i <= cur->runCount; ++ i) {
+
+        x = gap_center(cur, i);
+        if(x < 0.0f) continue;
+
+        cost = fabsf(x_distance(gx, x));
+
+        // Monsters guarding the hole or the landing spot
+        cost += MONSTER_PENALTY * monsters_near(s, x, y, HOLE_CLEARANCE, THREAT_Y);
+        cost += MONSTER_PENALTY * monsters_near(s, x, by, LANDING_CLEARANCE, THREAT_Y);
+
+        // Falling through two platforms is dangerous
+        if(!is_solid(below, x)) {
+
+            if(!panic) continue;
+            cost += MONSTER_PENALTY * 4;
+        }
+
+        if(best < 0.0f || cost < bestCost) {
+
+            best = x;
+            bestCost = cost;
+        }
+    }
+
+    return best;
+}
+
+
+// Get the frames needed to reach a hole from the
+// current platform
+static float escape_time(GAME_STATE* s) {
+
+    int cur, below;
+    find_platforms(s, &cur, &below);
+    if(cur == -1 || below == -1) return 0.0f;
+
+    float x = find_hole(s, &s->stage.platforms[cur],
+        &s->stage.platforms[below], s->player.pos.x, true);
+    if(x < 0.0f) return 0.0f;
+
+    return fabsf(x_distance(s->player.pos.x, x)) / GOAT_SPEED;
+}
+
+
+// Get the input of a plan at a frame. By default, the
+// goat heads down through the holes
+static void plan_input(GAME_STATE* s, PLAN* plan, int frame, GAME_INPUT* in) {
+
+    GOAT* g = &s->player;
+    int cur, below;
+    int i = 0;
+
+    in->stick = vec2(0, 0);
+    for(; i < GAME_BUTTON_COUNT; ++ i) {
+
+        in->buttons[i] = STATE_UP;
+    }
+
+    find_platforms(s, &cur, &below);
+    PLATFORM* p = cur == -1 ? NULL : &s->stage.platforms[cur];
+    PLATFORM* pb = below == -1 ? NULL : &s->stage.platforms[below];
+
+    // Drop down once the platform below is high enough
+    // to land on safely. In the air, only make sure
+    // to land on something
+    float target = g->pos.x;
+    if(!g->canJump) {
+
+        if(p != NULL && !is_solid(p, g->pos.x))
+            p = pb;
+        if(p != NULL && !is_solid(p, g->pos.x))
+            target = find_ground(p, g->pos.x);
+    }
+    else if(plan->platform != -1 && plan->platform == cur) {
+
+        target = plan->target;
+    }
+    else if(p != NULL && pb != NULL
+     && (pb->y < DROP_LIMIT || p->y < PANIC_LIMIT)) {
+
+        float x = find_hole(s, p, pb, g->pos.x, p->y < PANIC_LIMIT);
+        if(x >= 0.0f)
+            target = x;
+    }
+
+    // Steer
+    float d = x_distance(g->pos.x, target);
+    in->stick.x = fmaxf(-1.0f, fminf(1.0f, d / STEER_DISTANCE));
+
+    if(frame >= plan->hold) return;
+
+    if(plan->holdStick)
+        in->stick.x = plan->stick;
+
+    if(plan->button != -1)
+        in->buttons[plan->button] = frame == 0 ? STATE_PRESSED : STATE_DOWN;
+}
+
+
+// Play a plan on a copy of the game and rate the outcome
+static float rate_plan(GAME_STATE* s, GAME_STATE* sim, PLAN* plan) {
+
+    int frame = 0;
+
+    memcpy(sim, s, sizeof(GAME_STATE));
+    sim->headless = true;
+
+    for(; frame < PLAN_LENGTH && !status_is_game_over(&sim->status); ++ frame) {
+
+        plan_input(sim, plan, frame, &sim->input);
+        game_state_update(sim, 1.0f);
+    }
+    if(status_is_game_over(&sim->status))
+        return -HEALTH_WEIGHT * 4.0f + frame;
+
+    // Stay healthy, then stay away from the screen
+    // edges. Being carried to the top kills, so getting
+    // hurt is better than staying there
+    float y = sim->player.pos.y - sim->cam.pos.y;
+    float rate = sim->status.health * HEALTH_WEIGHT - fabsf(y - COMFORT_Y)
+        - fmaxf(0.0f, TOP_LIMIT - y) * TOP_WEIGHT;
+
+    // Make sure there is still time to get off the
+    // platform
+    if(sim->player.canJump && escape_time(sim) > y / sim->globalSpeed)
+        rate -= HEALTH_WEIGHT * 2.0f;
+
+    return rate;
+}
+
+
+// Add a plan, and its variants with the buttons
+static int add_plans(GAME_STATE* s, PLAN* plans, int count, PLAN plan) {
+
+    GOAT* g = &s->player;
+
+    plans[count ++] = plan;
+
+    if(g->canJump) {
+
+        plan.button = GAME_BUTTON_JUMP;
+        plans[count ++] = plan;
+    }
+    if(g->touchedGround && g->dashTimer <= 0.0f) {
+
+        plan.button = GAME_BUTTON_DASH;
+        plans[count ++] = plan;
+    }
+
+    return count;
+}
+
+
+// Fill the input of a game from its state
+void bot_think(GAME_STATE* s, GAME_INPUT* in) {
+
+    GAME_STATE sim;
+    PLAN plans[PLAN_MAX];
+    PLAN plan = {-1, 0.0f, 0.0f, false, -1, PLAN_HOLD[0]};
+    int count = 0;
+    int best = 0;
+    float bestRate = 0.0f;
+    float rate, x;
+    int i, j, cur, below;
+
+    // Retry after game over (the jump button
+    // picks the first menu entry)
+    if(status_is_game_over(&s->status)) {
+
+        plan_input(s, &plan, plan.hold, in);
+        in->stick.x = 0.0f;
+        if(s->frame % 2 == 0)
+            in->buttons[GAME_BUTTON_JUMP] = STATE_PRESSED;
+
+        return;
+    }
+
+    // The default plan
+    count = add_plans(s, plans, count, plan);
+
+    // Dodging
+    plan.holdStick = true;
+    for(j = 0; j < PLAN_HOLD_COUNT; ++ j) {
+
+        plan.hold = PLAN_HOLD[j];
+        for(i = -1; i <= 1; ++ i) {
+
+            plan.stick = (float)i;
+            count = add_plans(s, plans, count, plan);
+        }
+    }
+    plan.holdStick = false;
+    plan.hold = PLAN_HOLD[0];
+
+    // Go to a specific hole
+    find_platforms(s, &cur, &below);
+    if(cur != -1 && s->player.canJump) {
+
+        plan.platform = cur;
+        for(i = 0; i <= s->stage.platforms[cur].runCount
+         && count + 3 <= PLAN_MAX; ++ i) {
+
+            x = gap_center(&s->stage.platforms[cur], i);
+            if(x < 0.0f) continue;
+
+            plan.target = x;
+            count = add_plans(s, plans, count, plan);
+        }
+    }
+
+    // Look ahead, and pick the plan with the best
+    // outcome. The default plan wins ties
+    for(i = 0; i < count; ++ i) {
+
+        rate = rate_plan(s, &sim, &plans[i]);
+        if(i == 0 || rate > bestRate) {
+
+            best = i;
+            bestRate = rate;
+        }
+    }
+
+    plan_input(s, &plans[best], 0, in);
+}
@@ -0,0 +1,15 @@
+// GOAT
+// Autoplay bot (header)
+// (c) 2018 Jani Nykänen
+
+#ifndef __BOT__
+#define __BOT__
+
+#include "state.h"
+
+// Fill the input of a game from its state. The bot
+// keeps no memory of its own, so the same state always
+// gives the same input
+void bot_think(GAME_STATE* s, GAME_INPUT* in);
+
+#endif // __BOT__
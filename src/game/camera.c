@@ -6,34 +6,23 @@
 
 #include "../include/std.h"
 
-// Global camera
-static CAMERA globalCamera;
 
+// Create a camera
+CAMERA create_camera() {
 
-// Initialize global camera
-void init_global_camera() {
-
-    // Create the global camerea
-    globalCamera = (CAMERA){ vec2(0, 0) };
-}
-
-
-// Get global camera
-CAMERA* get_global_camera(){
-
-    return &globalCamera;
+    return (CAMERA){ vec2(0, 0) };
 }
 
 
-// Use global camera
-void use_global_camera() {
+// Use a camera
+void use_camera(CAMERA* c) {
 
-    translate(-(int)round(globalCamera.pos.x), -(int)round(globalCamera.pos.y));
+    translate(-(int)round(c->pos.x), -(int)round(c->pos.y));
 }
 
 
 // Move the camera
-void move_camera(float speed, float tm) {
+void move_camera(CAMERA* c, float speed, float tm) {
 
-    globalCamera.pos.y += speed *tm;
+    c->pos.y += speed *tm;
 }
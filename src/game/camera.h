@@ -14,16 +14,13 @@ typedef struct {
 }
 CAMERA;
 
-// Initialize global camera
-void init_global_camera();
+// Create a camera
+CAMERA create_camera();
 
-// Get global camera
-CAMERA* get_global_camera();
-
-// Use global camera
-void use_global_camera();
+// Use a camera
+void use_camera(CAMERA* c);
 
 // Update the camera
-void move_camera(float speed, float tm);
+void move_camera(CAMERA* c, float speed, float tm);
 
 #endif // __CAMERA__
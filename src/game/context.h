@@ -0,0 +1,12 @@
+// GOAT
+// Game context (header)
+// (c) 2018 Jani Nykänen
+
+#ifndef __CONTEXT__
+#define __CONTEXT__
+
+// Game state, defined in state.h. The game modules
+// only pass pointers to it around
+typedef struct _GAME_STATE GAME_STATE;
+
+#endif // __CONTEXT__
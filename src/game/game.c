@@ -4,14 +4,11 @@
 
 #include "game.h"
 
-#include "stage.h"
-#include "goat.h"
-#include "camera.h"
-#include "status.h"
-#include "gem.h"
-#include "monster.h"
 #include "pause.h"
 #include "gameover.h"
+#include "savestate.h"
+#include "rewind.h"
+#include "bot.h"
 
 #include "../global.h"
 #include "../vpad.h"
@@ -19,60 +16,121 @@
 #include "../include/system.h"
 #include "../include/audio.h"
 
-// Constants
-#define GEM_COUNT 16
-#define MONSTER_COUNT 16
-static const float INITIAL_GLOBAL_SPEED = 0.5f;
-static const float SPEED_UP_INTERVAL = 20.0f * 60.f;
-static const float SPEED_UP = 0.1f;
-static const int MAX_UP = 10;
-
-// Global speed
-static float globalSpeed;
-static float speedCounter;
-static int upCounter;
-
-// Game objects
-static GOAT player;
-static GEM gems[GEM_COUNT];
-static MONSTER monsters[MONSTER_COUNT];
+// Game state
+static GAME_STATE state;
 
 // Is paused
 static bool paused;
 
+// Random numbers
+static RNG rngSeeds; // Run seeds
+static RNG rngFx;
+static Uint64 fixedSeed;
+
+// Quick save
+static SAVESTATE quickSave;
+static bool quickSaved;
+
+// Spawn statistics of the session
+static POOL_STATS gemStats;
+static POOL_STATS monsterStats;
+
+// Autoplay. Set when the game is updated, so the
+// bot does not press buttons in the other scenes
+static bool autoplayArmed;
+
 // Samples
 static SAMPLE* sPause;
 
+// Stage music by the number of speed-ups, NULL if the
+// music does not change
+static MUSIC* stageMusic[SPEED_UP_MAX +1];
+static int musicStage;
 
-// Find the next gem
-static GEM* find_next() {
+// Quick save file
+static const char* QUICK_SAVE_PATH = "savestate.bin";
 
-    int i = 0;
-    for(; i < GEM_COUNT; ++ i) {
+// Stage music
+static const float STAGE_MUSIC_VOL = 0.50f;
+static const int STAGE_MUSIC_FADE = 2000;
 
-        if(gems[i].exist == false && gems[i].deathTimer <= 0.0f) {
 
-            return &gems[i];
-        }
-    }
+// Read the game input from the virtual gamepad
+static void read_input(GAME_INPUT* in) {
 
-    return &gems[0];
+    in->stick = vpad_get_stick();
+    in->buttons[GAME_BUTTON_JUMP] = vpad_get_button(0);
+    in->buttons[GAME_BUTTON_DASH] = vpad_get_button(1);
 }
 
 
-// Update speed
-static void update_speed(float tm) {
+// Move the spawn statistics out of the state, so that
+// they cover the whole session, and are not saved or
+// rewound with it
+static void collect_stats() {
+
+    pool_collect_stats(&state.gems.pool, &gemStats);
+    pool_collect_stats(&state.monsters.pool, &monsterStats);
+}
 
-    if(upCounter >= MAX_UP) return;
 
-    speedCounter += 1.0f * tm;
-    if(speedCounter >= SPEED_UP_INTERVAL) {
+// Drive the virtual gamepad with the bot
+static void autoplay_drive(VEC2* stick, int* buttons) {
+
+    if(!autoplayArmed || pause_is_active()) return;
+    autoplayArmed = false;
+
+    GAME_INPUT in;
+    bot_think(&state, &in);
+
+    *stick = in.stick;
+    buttons[0] = in.buttons[GAME_BUTTON_JUMP];
+    buttons[1] = in.buttons[GAME_BUTTON_DASH];
+}
+
+
+// Quick save. The savestate is also written to a file,
+// so that it survives a crash
+static void quick_save() {
+
+    savestate_capture(&quickSave, &state);
+    quickSaved = true;
+
+    if(savestate_write(&quickSave, QUICK_SAVE_PATH) == 1)
+        printf("%s\n", error_get_message());
+    else
+        printf("Saved the state to %s\n", QUICK_SAVE_PATH);
+}
+
 
-        speedCounter -= SPEED_UP_INTERVAL;
-        globalSpeed += SPEED_UP;
+// Quick load, from the file if nothing saved yet
+static void quick_load() {
 
-        ++ upCounter;
+    if(!quickSaved) {
+
+        if(savestate_read(&quickSave, QUICK_SAVE_PATH) == 1) {
+
+            printf("%s\n", error_get_message());
+            return;
+        }
+        quickSaved = true;
     }
+
+    if(savestate_restore(&quickSave, &state) == 1)
+        printf("%s\n", error_get_message());
+    else
+        rewind_clear();
+}
+
+
+// Crossfade to the music of the current stage
+static void update_stage_music() {
+
+    if(state.upCounter == musicStage) return;
+
+    musicStage = state.upCounter;
+    if(stageMusic[musicStage] != NULL)
+        fade_in_music(stageMusic[musicStage], STAGE_MUSIC_VOL, -1, STAGE_MUSIC_FADE);
 }
 
 
@@ -83,10 +141,18 @@ static int game_init() {
     ASSET_PACK* ass = global_get_asset_pack();
     sPause = (SAMPLE*)assets_get(ass, "pause");
 
+    char name[NAME_STRING_SIZE];
+    int i = 0;
+    for(; i <= SPEED_UP_MAX; ++ i) {
+
+        snprintf(name, NAME_STRING_SIZE, "stage%d", i);
+        stageMusic[i] = (MUSIC*)assets_get(ass, name);
+    }
+    musicStage = -1;
+
     // Initialize components
     stage_init(ass);
     init_goat(ass);
-    init_global_camera();
     init_status(ass);
     init_gems(ass);
     init_monsters(ass);
@@ -97,6 +163,16 @@ static int game_init() {
 
     // Set default values
     paused = false;
+    state.headless = false;
+    quickSaved = false;
+    fixedSeed = 0;
+    memset(&gemStats, 0, sizeof(POOL_STATS));
+    memset(&monsterStats, 0, sizeof(POOL_STATS));
+    rng_seed(&rngSeeds, (Uint64)time(NULL), 0);
+
+    autoplayArmed = false;
+    if(core_get_config().autoplay)
+        vpad_set_driver(autoplay_drive);
 
     // Reset
     game_reset();
@@ -108,12 +184,15 @@ static int game_init() {
 // Update
 static void game_update(float tm) {
 
-    int i = 0;
-    int i2 = 0;
+    autoplayArmed = true;
 
     // Do not update if fading
     if(is_fading()) return;
 
+    // The music follows the speed-ups (also when
+    // rewound or loaded)
+    update_stage_music();
+
     // If paused
     if(pause_is_active()) {
 
@@ -121,8 +200,19 @@ static void game_update(float tm) {
         return;
     }
 
+    // Quick save & load
+    if(input_get_key((int)SDL_SCANCODE_F5) == STATE_PRESSED) {
+
+        quick_save();
+    }
+    else if(input_get_key((int)SDL_SCANCODE_F9) == STATE_PRESSED) {
+
+        quick_load();
+        return;
+    }
+
     // Check pause
-    if(!status_is_game_over() 
+    if(!status_is_game_over(&state.status) 
      && (vpad_get_button(2) == STATE_PRESSED
      || vpad_get_button(3) == STATE_PRESSED) ) {
 
@@ -131,45 +221,25 @@ static void game_update(float tm) {
         return;
     }
 
-    // Update stage
-    stage_update(globalSpeed, tm);
-
-    // Update player
-    goat_update(&player, tm);
-    stage_goat_collision(&player);
-
-    // Update gems
-    for(i = 0; i < GEM_COUNT; ++ i) {
-
-        gem_update(&gems[i], tm);
-        gem_goat_collision(&gems[i], &player);
-        stage_gem_collision(&gems[i]);
-    }
-
-    // Update monsters
-    for(i = 0; i < MONSTER_COUNT; ++ i) {
+    // Rewind while the button is held down
+    int rewindButton = vpad_get_button(4);
+    if(rewindButton == STATE_DOWN || rewindButton == STATE_PRESSED) {
 
-        monster_update(&monsters[i], tm);
-        monster_goat_collision(&monsters[i], &player);
+        bool wasOver = status_is_game_over(&state.status);
+        if(rewind_step(&state) && wasOver && !status_is_game_over(&state.status))
+            gover_reset();
 
-        for(i2 = 0; i2 < MONSTER_COUNT; ++ i2) {
-
-            if(i2 == i) continue;
-            monster_to_monster_collision(&monsters[i], &monsters[i2]);
-        }
+        return;
     }
 
-    // Update status
-    status_update(tm);
-
-    // Move camera
-    move_camera(globalSpeed, tm);
-
-    // Update global speed
-    update_speed(tm);
+    // Update the game
+    read_input(&state.input);
+    game_state_update(&state, tm);
+    collect_stats();
+    rewind_record(&state);
 
     // Update game over
-    gover_update(tm);
+    gover_update(&state.status, tm);
 }
 
 
@@ -187,13 +257,12 @@ static void game_draw() {
 
     int shakeX = 0;
     int shakeY = 0;
-    int i = 0;
 
     // If player hurt, shake the screen
-    if(player.hurtTimer > 0.0f) {
+    if(state.player.hurtTimer > 0.0f) {
 
-        shakeX = rand() % SHAKE_COUNT - (SHAKE_COUNT/2);
-        shakeY = rand() % SHAKE_COUNT - (SHAKE_COUNT/2);
+        shakeX = rng_range(&rngFx, SHAKE_COUNT) - (SHAKE_COUNT/2);
+        shakeY = rng_range(&rngFx, SHAKE_COUNT) - (SHAKE_COUNT/2);
     }
 
     // Reset translation
@@ -203,27 +272,23 @@ static void game_draw() {
     clear(0b01000000);
 
     // Draw stage
-    stage_draw();
+    stage_draw(&state.stage);
 
     // Draw game objects
-    use_global_camera();
-    for(i = 0; i < GEM_COUNT; ++ i) {
-
-        gem_draw(&gems[i]);
-    }
-    for(i = 0; i < MONSTER_COUNT; ++ i) {
-
-        monster_draw(&monsters[i]);
-    }
-    goat_draw(&player);
+    use_camera(&state.cam);
+    batch_begin();
+    gems_draw(&state.gems);
+    monsters_draw(&state.monsters);
+    goat_draw(&state);
+    batch_submit();
 
     // Draw status
     translate(0, 0);
-    status_draw();
+    status_draw(&state.status);
 
     // Draw game over
     translate(0, 0);
-    gover_draw();
+    gover_draw(&state.status);
 }
 
 
@@ -231,6 +296,11 @@ static void game_draw() {
 static void game_destroy() {
 
     // pause_destroy();
+
+    // Tell if spawns were dropped
+    collect_stats();
+    pool_print_stats(&gemStats, "gems");
+    pool_print_stats(&monsterStats, "monsters");
 }
 
 
@@ -244,30 +314,18 @@ static void game_on_change() {
 // Reset
 void game_reset() {
 
-    int i = 0;
-
-    // Set default values
-    globalSpeed = INITIAL_GLOBAL_SPEED;
-    get_global_camera()->pos = vec2(0, 0);
-    upCounter = 0;
-    speedCounter = 0;
-
-    // (Re)create game objects
-    player = create_goat(vec2(128.0f,-4.0f));
-    for(i = 0; i < GEM_COUNT; ++ i) {
-
-        gems[i].exist = false;
-        gems[i].deathTimer = -1.0f;
-    }
-    for(i = 0; i < MONSTER_COUNT; ++ i) {
+    // Pick a seed
+    Uint64 seed = fixedSeed;
+    if(seed == 0)
+        seed = ((Uint64)rng_next(&rngSeeds) << 32) | rng_next(&rngSeeds);
 
-        monsters[i].exist = false;
-        monsters[i].deathTimer = -1.0f;
-    }
+    rng_seed(&rngFx, seed, RNG_STREAM_FX);
+    printf("Run seed: %llu\n", (unsigned long long)seed);
 
-    // Reset components
-    stage_reset();
-    reset_status();
+    // Reset the game & components
+    game_state_reset(&state, seed);
+    collect_stats();
+    rewind_clear();
     gover_reset();
 }
 
@@ -281,47 +339,22 @@ SCENE game_get_scene() {
 }
 
 
-// Add a gem to the game world
-void add_gem(float x, float y) {
-
-    GEM* gem = find_next();
-    *gem = create_gem(vec2(x, y));
-}
-
-
-// Add a gem with a gravity to the game world
-void add_gem_with_gravity(float x, float y, float sx, float sy) {
+// Use a fixed seed for the following runs
+void game_set_seed(Uint64 seed) {
 
-    GEM* gem = find_next();
-    *gem = create_gem_with_gravity(vec2(x, y), vec2(sx, sy));
-}
-
-
-// Add a monster to the game world
-void add_monster(float x, float y, float left, float right, int id) {
-
-    // Find the first monster that does not exist
-    int i = 0;
-    for(; i < MONSTER_COUNT; ++ i) {
-
-        if(monsters[i].exist == false && monsters[i].dying == false) {
-
-            monsters[i] = create_monster(vec2(x, y), left, right, id);
-            return;
-        }
-    }
+    fixedSeed = seed;
 }
 
 
-// Get the amount of speed ups
-int get_speed_up_count() {
+// Get the seed of the current run
+Uint64 game_get_seed() {
 
-    return upCounter;
+    return state.seed;
 }
 
 
-// Get global speed
-float get_global_speed() {
+// Get the state of the game scene
+GAME_STATE* game_get_state() {
 
-    return globalSpeed;
+    return &state;
 }
@@ -9,26 +9,33 @@
 
 #include "../include/renderer.h"
 
+#include "state.h"
+
+// Draw layers of the game objects
+enum {
+
+    LAYER_GEM = 0,
+    LAYER_MONSTER = 1,
+    LAYER_SPLASH = 2,
+    LAYER_CLOUD = 3,
+    LAYER_GOAT = 4,
+};
+
 // Reset game
 void game_reset();
 
 // Get game scene
 SCENE game_get_scene();
 
-// Add a gem to the game world
-void add_gem(float x, float y);
-
-// Add a gem with a gravity to the game world
-void add_gem_with_gravity(float x, float y, float sx, float sy);
-
-// Add a monster to the game world
-void add_monster(float x, float y, float left, float right, int id);
+// Use a fixed seed for the following runs. 0 means
+// a new seed is picked for each run
+void game_set_seed(Uint64 seed);
 
-// Get the amount of speed ups
-int get_speed_up_count();
+// Get the seed of the current run
+Uint64 game_get_seed();
 
-// Get global speed
-float get_global_speed();
+// Get the state of the game scene
+GAME_STATE* game_get_state();
 
 #endif // __GAME__
 
@@ -59,7 +59,7 @@ static void draw_menu_text(int x, int y, int yoff) {
     int i = 0;
     for(; i < ELEMENT_COUNT; ++ i) {
 
-        draw_text( (cursor.moving || (cursor.pos != i)) ? bmpFont : bmpFont2, 
+        draw_text_cached( (cursor.moving || (cursor.pos != i)) ? bmpFont : bmpFont2, 
             GOVER_TEXT[i],x,y +yoff*i,-7,0,false);
     }
 
@@ -152,9 +152,9 @@ void init_game_over(ASSET_PACK* ass) {
 
 
 // Update
-void gover_update(float tm) {
+void gover_update(STATUS* st, float tm) {
 
-    if(!status_is_game_over()) return;
+    if(!status_is_game_over(st)) return;
 
     // Update timer
     if(goverTimer < GOVER_MAX)
@@ -180,7 +180,7 @@ void gover_update(float tm) {
 
 
 // Draw
-void gover_draw() {
+void gover_draw(STATUS* st) {
 
     const int POS_X = 48;
     const int POS_Y = 192-48;
@@ -188,7 +188,7 @@ void gover_draw() {
     const int BIG_TEXT_Y = 32;
     const int SCORE_Y = 192-80;
 
-    if(!status_is_game_over()) return;
+    if(!status_is_game_over(st)) return;
 
     // Draw game over text
     draw_game_over_text((256-240) / 2, BIG_TEXT_Y);
@@ -208,8 +208,8 @@ void gover_draw() {
 
     // Draw score
     char scoreStr[16];
-    status_get_score_string(scoreStr, 16);
-    draw_text(bmpFontBig, scoreStr, 128, SCORE_Y, -16, 0, true);
+    status_get_score_string(st, scoreStr, 16);
+    draw_text_cached(bmpFontBig, scoreStr, 128, SCORE_Y, -16, 0, true);
 }
 
 
@@ -7,14 +7,16 @@
 
 #include "../include/system.h"
 
+#include "status.h"
+
 // Initialize
 void init_game_over(ASSET_PACK* ass);
 
 // Update
-void gover_update(float tm);
+void gover_update(STATUS* st, float tm);
 
 // Draw
-void gover_draw();
+void gover_draw(STATUS* st);
 
 // Reset game over
 void gover_reset();
@@ -4,8 +4,8 @@
 
 #include "gem.h"
 
-#include "status.h"
-#include "camera.h"
+#include "state.h"
+#include "game.h"
 
 #include "../include/std.h"
 #include "../include/audio.h"
@@ -27,9 +27,6 @@ static _BITMAP* bmpGem;
 static SAMPLE* sGem;
 static SAMPLE* sHeal;
 
-// Heart probability
-static int heartProb;
-
 
 // Initialize gems
 void init_gems(ASSET_PACK* ass) {
@@ -40,208 +37,314 @@ void init_gems(ASSET_PACK* ass) {
     sGem = (SAMPLE*)assets_get(ass, "sGem");
     sHeal = (SAMPLE*)assets_get(ass, "heal");
 
-    // Set heart probability to max
-    heartProb = HEART_PROB_MAX;
+    // Rapid pickups overlap, but give way to the rest
+    set_sample_voices(sGem, 0, 6);
+    set_sample_voices(sHeal, 1, 2);
 }
 
 
-// Create gem, base
-static GEM create_gem_base(VEC2 pos) {
+// Add a slot to the active list
+static void activate(GEM_LIST* l, int i) {
 
-    GEM g;
-    g.pos = pos;
-    g.spr = create_sprite(24, 24);
-    g.waveTimer = (float)(rand() % 1000) / 1000.0f * 2 * M_PI;
-    g.deathTimer = 0.0f;
-    g.exist = true;
-    g.hasGravity = false;
-    g.waitTimer = -1.0f;
+    if(l->activePos[i] != -1) return;
 
-    return g;
+    l->activePos[i] = l->activeCount;
+    l->active[l->activeCount ++] = i;
 }
 
 
-// Create a gem
-GEM create_gem(VEC2 pos) {
-    
-    GEM g = create_gem_base(pos);
+// Remove a slot from the active list (swap-remove)
+static void deactivate(GEM_LIST* l, int i) {
 
-    if(heartProb > 2)
-        -- heartProb;
-    g.isHeart = (rand() % heartProb == 0);
-    
-    if(g.isHeart)
-        heartProb = HEART_PROB_MAX;
+    int pos = l->activePos[i];
+    if(pos == -1) return;
+
+    int last = l->active[-- l->activeCount];
+    l->active[pos] = last;
+    l->activePos[last] = pos;
+    l->activePos[i] = -1;
+
+    pool_free(&l->pool, l->next, l->generation, i);
+}
 
-    return g;
+
+// Kill a gem
+static void kill_gem(GEM_LIST* l, int i) {
+
+    l->exist[i] = false;
+    l->speedX[i] = 0.0f;
+    l->speedY[i] = 0.0f;
+    l->waveSpeed[i] = 0.0f;
 }
 
 
-// Create a gem with gravity
-GEM create_gem_with_gravity(VEC2 pos, VEC2 speed) {
+// Add a gem, base. Returns the slot, -1 if full
+static int add_gem_base(GEM_LIST* l, VEC2 pos) {
+
+    int i = pool_alloc(&l->pool, l->next);
+    if(i == -1) return -1;
+
+    l->x[i] = pos.x;
+    l->y[i] = pos.y;
+    l->speedX[i] = 0.0f;
+    l->speedY[i] = 0.0f;
+    l->oldY[i] = pos.y;
+    l->spr[i] = create_sprite(24, 24);
+    l->waveTimer[i] = rng_float(&l->rng) * 2 * M_PI;
+    l->waveSpeed[i] = WAVE_SPEED;
+    l->deathTimer[i] = 0.0f;
+    l->exist[i] = true;
+    l->hasGravity[i] = false;
+    l->waitTimer[i] = -1.0f;
 
-    GEM g = create_gem_base(pos);
-    g.hasGravity = true;
-    g.speed = speed;
-    g.waveTimer = 0.0f;
-    g.oldY = 0.0f;
-    g.waitTimer = WAIT_TIME;
-    g.isHeart = false;
+    activate(l, i);
 
-    return g;
+    return i;
 }
 
 
-// Update a gem
-void gem_update(GEM* gem, float tm) {
+// Seed the gem random numbers
+void gems_seed(GEM_LIST* l, Uint64 seed) {
 
-    if(!gem->exist) {
+    rng_seed(&l->rng, seed, RNG_STREAM_GEMS);
+}
 
-        // Update death timer
-        if(gem->deathTimer > 0.0f) {
 
-            gem->deathTimer -= 1.0f * tm;
-        }
+// Clear a gem list
+void gem_list_clear(GEM_LIST* l) {
+
+    int i = 0;
+    for(; i < GEM_COUNT; ++ i) {
 
-        return;   
+        kill_gem(l, i);
+        l->deathTimer[i] = -1.0f;
+        l->activePos[i] = -1;
     }
+    l->activeCount = 0;
 
-    // Update wait timer
-    if(gem->waitTimer > 0.0f)
-        gem->waitTimer -= 1.0f * tm;
+    pool_reset(&l->pool, l->next, l->generation, GEM_COUNT);
 
-    // Store old y coordinate
-    gem->oldY = gem->pos.y;
+    // Set heart probability to max
+    l->heartProb = HEART_PROB_MAX;
+}
+
+
+// Add a gem
+POOL_HANDLE gem_add(GEM_LIST* l, VEC2 pos) {
+    
+    int i = add_gem_base(l, pos);
+    if(i == -1) return POOL_HANDLE_NONE;
+
+    if(l->heartProb > 2)
+        -- l->heartProb;
+    l->isHeart[i] = (rng_range(&l->rng, l->heartProb) == 0);
+    
+    if(l->isHeart[i])
+        l->heartProb = HEART_PROB_MAX;
 
-    float camY = get_global_camera()->pos.y;
+    return pool_handle(l->generation, i);
+}
+
+
+// Add a gem with gravity
+POOL_HANDLE gem_add_with_gravity(GEM_LIST* l, VEC2 pos, VEC2 speed) {
+
+    int i = add_gem_base(l, pos);
+    if(i == -1) return POOL_HANDLE_NONE;
+
+    l->hasGravity[i] = true;
+    l->speedX[i] = speed.x;
+    l->speedY[i] = speed.y;
+    l->waveTimer[i] = 0.0f;
+    l->waveSpeed[i] = 0.0f;
+    l->oldY[i] = 0.0f;
+    l->waitTimer[i] = WAIT_TIME;
+    l->isHeart[i] = false;
+
+    return pool_handle(l->generation, i);
+}
 
-    // Wave
-    if(!gem->hasGravity) {
-        gem->waveTimer += WAVE_SPEED * tm;
 
-    } 
-    else {
+// Update gems
+void gems_update(GEM_LIST* l, CAMERA* cam, float tm) {
+
+    float camY = cam->pos.y;
+    int i, k;
+
+    // Update speeds
+    for(k = 0; k < l->activeCount; ++ k) {
+
+        i = l->active[k];
+        if(!l->exist[i]) continue;
+
+        // Update wait timer
+        if(l->waitTimer[i] > 0.0f)
+            l->waitTimer[i] -= 1.0f * tm;
+
+        // Store old y coordinate
+        l->oldY[i] = l->y[i];
+
+        if(!l->hasGravity[i]) continue;
 
         // Update gravity
-        gem->speed.y += GEM_GRAVITY * tm;
-        if(gem->speed.y > MAX_GRAVITY)
-            gem->speed.y = MAX_GRAVITY;
+        l->speedY[i] += GEM_GRAVITY * tm;
+        if(l->speedY[i] > MAX_GRAVITY)
+            l->speedY[i] = MAX_GRAVITY;
 
         // Update horizontal speed
-        if(gem->speed.x > 0.0f) {
+        if(l->speedX[i] > 0.0f) {
 
-            gem->speed.x -= GEM_SLOW_X * tm;
-            if(gem->speed.x < 0.0f)
-                gem->speed.x = 0.0f;
+            l->speedX[i] -= GEM_SLOW_X * tm;
+            if(l->speedX[i] < 0.0f)
+                l->speedX[i] = 0.0f;
         }
-        else if(gem->speed.x < 0.0f) {
+        else if(l->speedX[i] < 0.0f) {
 
-            gem->speed.x += GEM_SLOW_X * tm;
-            if(gem->speed.x > 0.0f)
-                gem->speed.x = 0.0f;
+            l->speedX[i] += GEM_SLOW_X * tm;
+            if(l->speedX[i] > 0.0f)
+                l->speedX[i] = 0.0f;
         }
+    }
 
-        // Movement
-        gem->pos.x += gem->speed.x *tm;
-        gem->pos.y += gem->speed.y *tm;
+    // Movement & waves. Speeds are zero for the gems
+    // that do not move, so all the slots can be updated
+    for(i = 0; i < GEM_COUNT; ++ i) {
 
-        // If outside the screen (horizontal)
-        if(gem->pos.x > 256.0f)
-            gem->pos.x -= 256.0f;
+        l->x[i] += l->speedX[i] * tm;
+        l->y[i] += l->speedY[i] * tm;
+        l->waveTimer[i] += l->waveSpeed[i] * tm;
+    }
+
+    // Bounds, animation & death. Iterated backwards so
+    // removing does not skip anything
+    for(k = l->activeCount-1; k >= 0; -- k) {
+
+        i = l->active[k];
+
+        if(!l->exist[i]) {
 
-        else if(gem->pos.x < 0.0f)
-            gem->pos.x += 256.0f;
+            // Update death timer
+            if(l->deathTimer[i] > 0.0f)
+                l->deathTimer[i] -= 1.0f * tm;
 
-        // Bottom
-        if(gem->pos.y > camY+192+16.0f) {
+            if(l->deathTimer[i] <= 0.0f)
+                deactivate(l, i);
 
-            gem->exist = false;
-            gem->deathTimer = -1.0f;
+            continue;
         }
-    }
 
-    // Animate
-    if(gem->isHeart)
-        spr_animate(&gem->spr,1,0,5, 5, tm);
-    
-    else
-        spr_animate(&gem->spr,0,0,4, 5, tm);
+        if(l->hasGravity[i]) {
+
+            // If outside the screen (horizontal)
+            if(l->x[i] > 256.0f)
+                l->x[i] -= 256.0f;
 
-    // If outside the screen, "kill"
-    if(gem->pos.y < camY - 12.0f - AMPLITUDE) {
+            else if(l->x[i] < 0.0f)
+                l->x[i] += 256.0f;
 
-        gem->exist = false;
+            // Bottom
+            if(l->y[i] > camY+192+16.0f) {
+
+                kill_gem(l, i);
+                l->deathTimer[i] = -1.0f;
+            }
+        }
+
+        // Animate
+        if(l->isHeart[i])
+            spr_animate(&l->spr[i],1,0,5, 5, tm);
+        
+        else
+            spr_animate(&l->spr[i],0,0,4, 5, tm);
+
+        // If outside the screen, "kill"
+        if(l->y[i] < camY - 12.0f - AMPLITUDE) {
+
+            kill_gem(l, i);
+        }
+
+        if(!l->exist[i] && l->deathTimer[i] <= 0.0f)
+            deactivate(l, i);
     }
 }
 
 
-// Draw a game
-void gem_draw(GEM* gem) {
+// Draw gems (adds them to the sprite batch)
+void gems_draw(GEM_LIST* l) {
 
-    // Rendering position
-    int y = (int)round(gem->pos.y-12.0f + AMPLITUDE * sin(gem->waveTimer));
-    int x = (int)round(gem->pos.x-12.0f);
+    int i, k, x, y, fade;
+    for(k = 0; k < l->activeCount; ++ k) {
 
-    if(!gem->exist) {
+        i = l->active[k];
 
-        // Fading
-        if(gem->deathTimer > 0.0f) {
+        // Rendering position
+        y = (int)round(l->y[i]-12.0f + AMPLITUDE * sin(l->waveTimer[i]));
+        x = (int)round(l->x[i]-12.0f);
 
-            int fade = 1+ (int)round(gem->deathTimer / DEATH_MAX * 8.0f);
-            draw_bitmap_region_fading(bmpGem,0,gem->isHeart ? 24 : 0,24,24,x,y, FLIP_NONE, fade, get_alpha());
-        }   
-        return;
-    }
+        if(!l->exist[i]) {
+
+            // Fading
+            if(l->deathTimer[i] > 0.0f) {
+
+                fade = 1+ (int)round(l->deathTimer[i] / DEATH_MAX * 8.0f);
+                batch_add_region_fading(bmpGem,0,l->isHeart[i] ? 24 : 0,24,24,x,y, FLIP_NONE, fade, get_alpha(), LAYER_GEM);
+            }   
+            continue;
+        }
 
-    // Draw
-    spr_draw(&gem->spr,bmpGem, x,y, FLIP_NONE);
+        // Draw
+        spr_batch(&l->spr[i],bmpGem, x,y, FLIP_NONE, LAYER_GEM);
 
-    // "Off-screen"
-    if(gem->hasGravity) {
+        // "Off-screen"
+        if(l->hasGravity[i]) {
 
-        if(gem->pos.x < 16.0f)
-            spr_draw(&gem->spr,bmpGem, x +256.0f,y, FLIP_NONE);
+            if(l->x[i] < 16.0f)
+                spr_batch(&l->spr[i],bmpGem, x +256,y, FLIP_NONE, LAYER_GEM);
 
-        else if(gem->pos.x > 256.0f-16.0f)
-            spr_draw(&gem->spr,bmpGem, x - 256.0f,y, FLIP_NONE);
+            else if(l->x[i] > 256.0f-16.0f)
+                spr_batch(&l->spr[i],bmpGem, x - 256,y, FLIP_NONE, LAYER_GEM);
+        }
     }
 }
 
 
 // Gem-to-goat collision
-void gem_goat_collision(GEM* gem, GOAT* g) {
+void gem_goat_collision(GAME_STATE* s, int i) {
 
     const float DIM = 10.0f;
 
-    if(!gem->exist || gem->waitTimer > 0.0f) return;
+    GEM_LIST* l = &s->gems;
+    GOAT* g = &s->player;
+
+    if(!l->exist[i] || l->waitTimer[i] > 0.0f) return;
     
     // If collision boxes overlay
-    if(g->pos.x+8 >= gem->pos.x-DIM && g->pos.x-8 <= gem->pos.x+DIM
-      && g->pos.y >= gem->pos.y-DIM && g->pos.y-16 <= gem->pos.y+DIM) {
+    if(g->pos.x+8 >= l->x[i]-DIM && g->pos.x-8 <= l->x[i]+DIM
+      && g->pos.y >= l->y[i]-DIM && g->pos.y-16 <= l->y[i]+DIM) {
 
-          gem->exist = false;
-          gem->deathTimer = DEATH_MAX;
+          kill_gem(l, i);
+          l->deathTimer[i] = DEATH_MAX;
 
           // Add gem to status
-          (gem->isHeart ? status_add_health : status_add_coin) ();
+          (l->isHeart[i] ? status_add_health : status_add_coin) (&s->status);
 
-          play_sample(gem->isHeart ? sHeal : sGem, 0.65f);
+          game_state_play_sample(s, l->isHeart[i] ? sHeal : sGem, 0.65f);
     }
 }
 
 
 // Gem-to-floor collision
-void gem_floor_collision(GEM* g, float x, float y, float w) {
+void gem_floor_collision(GEM_LIST* l, int i, float x, float y, float w) {
 
     const float WIDTH = 4;
     const float DELTA = 1.0f;
 
-    if(g->pos.x >= x-WIDTH && g->pos.x < x+w+WIDTH) {
+    if(l->x[i] >= x-WIDTH && l->x[i] < x+w+WIDTH) {
 
-        if(g->speed.y > 0.0f && g->oldY+8.0f < y+DELTA && g->pos.y+8.0f > y-DELTA) {
+        if(l->speedY[i] > 0.0f && l->oldY[i]+8.0f < y+DELTA && l->y[i]+8.0f > y-DELTA) {
 
-            g->pos.y = y-8.0f;
-            g->speed.y *= -0.90f;
+            l->y[i] = y-8.0f;
+            l->speedY[i] *= -0.90f;
         }
     }
 }
@@ -8,46 +8,82 @@
 #include "../include/renderer.h"
 #include "../include/system.h"
 
+#include "context.h"
 #include "goat.h"
+#include "camera.h"
 
-// Gem type
+#include "../engine/pool.h"
+#include "../engine/rng.h"
+
+// Gem capacity. Can be raised at compile time
+#ifndef GEM_COUNT
+#define GEM_COUNT 16
+#endif
+
+// Gem list. Hot data is stored as a structure of
+// arrays indexed by slot, the live slots (existing
+// or fading) are listed densely in active
 typedef struct {
 
-    VEC2 pos;
-    VEC2 speed;
-    SPRITE spr;
-    bool exist;
-    bool hasGravity;
-    bool isHeart;
-
-    float waveTimer;
-    float deathTimer;
-    float waitTimer;
-    float oldY;
+    // Hot data
+    float x[GEM_COUNT];
+    float y[GEM_COUNT];
+    float speedX[GEM_COUNT];
+    float speedY[GEM_COUNT];
+    float oldY[GEM_COUNT];
+    float waveTimer[GEM_COUNT];
+    float waveSpeed[GEM_COUNT]; // 0 if not waving
+    float deathTimer[GEM_COUNT];
+    float waitTimer[GEM_COUNT];
+    bool exist[GEM_COUNT];
+    bool hasGravity[GEM_COUNT];
+    bool isHeart[GEM_COUNT];
+
+    // Cold data
+    SPRITE spr[GEM_COUNT];
+
+    // Live slots
+    int active[GEM_COUNT];
+    int activePos[GEM_COUNT]; // Position in active, -1 if free
+    int activeCount;
+
+    // Slot pool
+    POOL pool;
+    int next[GEM_COUNT];
+    Uint16 generation[GEM_COUNT];
+
+    // Random numbers
+    RNG rng;
+    int heartProb; // Heart probability
 }
-GEM;
+GEM_LIST;
 
 // Initialize gems
 void init_gems(ASSET_PACK* ass);
 
-// Create a gem
-GEM create_gem(VEC2 pos);
+// Seed the gem random numbers
+void gems_seed(GEM_LIST* l, Uint64 seed);
+
+// Clear a gem list
+void gem_list_clear(GEM_LIST* l);
 
-// Create a gem with gravity
-GEM create_gem_with_gravity(VEC2 pos, VEC2 speed);
+// Add a gem. Returns a handle, or POOL_HANDLE_NONE
+// if the list is full
+POOL_HANDLE gem_add(GEM_LIST* l, VEC2 pos);
 
-// Update a gem
-void gem_update(GEM* gem, float tm);
+// Add a gem with gravity
+POOL_HANDLE gem_add_with_gravity(GEM_LIST* l, VEC2 pos, VEC2 speed);
 
-// Draw a gem
-void gem_draw(GEM* gem);
+// Update gems
+void gems_update(GEM_LIST* l, CAMERA* cam, float tm);
+
+// Draw gems (adds them to the sprite batch)
+void gems_draw(GEM_LIST* l);
 
 // Gem-to-goat collision
-void gem_goat_collision(GEM* gem, GOAT* g);
+void gem_goat_collision(GAME_STATE* s, int i);
 
 // Gem-to-floor collision
-void gem_floor_collision(GEM* g, float x, float y, float w);
+void gem_floor_collision(GEM_LIST* l, int i, float x, float y, float w);
 
 #endif // __GEM__
-
-
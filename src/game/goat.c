@@ -4,11 +4,8 @@
 
 #include "goat.h"
 
+#include "state.h"
 #include "game.h"
-#include "camera.h"
-#include "status.h"
-
-#include "../vpad.h"
 
 #include "../include/std.h"
 #include "../include/audio.h"
@@ -87,11 +84,12 @@ static void generate_clouds(GOAT* g, float tm) {
 
 
 // Control a goat
-static void control_goat(GOAT* g) {
+static void control_goat(GAME_STATE* s, GOAT* g) {
 
     const float DELTA = 0.01f;
 
-    VEC2 stick = vpad_get_stick();
+    GAME_INPUT* in = &s->input;
+    VEC2 stick = in->stick;
     if(fabsf(stick.x) <= DELTA)
         stick.x = 0.0f;
 
@@ -104,24 +102,24 @@ static void control_goat(GOAT* g) {
     g->target.x = stick.x * GOAT_TARGET;
 
     // Jump
-    if(g->canJump && vpad_get_button(0) == STATE_PRESSED) {
+    if(g->canJump && in->buttons[GAME_BUTTON_JUMP] == STATE_PRESSED) {
 
         g->speed.y = GOAT_JUMP;
 
-        play_sample(sJump, 0.5f);
+        game_state_play_sample(s, sJump, 0.5f);
     }
 
     // Limit jump height by releasing the button
     if(!g->canJump && g->speed.y < 0.0f 
-     && vpad_get_button(0) == STATE_RELEASED) {
+     && in->buttons[GAME_BUTTON_JUMP] == STATE_RELEASED) {
 
         g->speed.y /= 1.75f;
     }
 
     // Dash
-    if(g->dashTimer <= 0.0f && vpad_get_button(1) == STATE_PRESSED) {
+    if(g->dashTimer <= 0.0f && in->buttons[GAME_BUTTON_DASH] == STATE_PRESSED) {
 
-        play_sample(sRam, 0.60f);
+        game_state_play_sample(s, sRam, 0.60f);
 
         g->dashing = true;
         if(g->canJump) {
@@ -134,7 +132,7 @@ static void control_goat(GOAT* g) {
         }
     }
 
-    if(g->dashing && vpad_get_button(1) == STATE_RELEASED)  {
+    if(g->dashing && in->buttons[GAME_BUTTON_DASH] == STATE_RELEASED)  {
 
         g->dashTimer = DASH_TIMER_MAX;
         g->dashing = false;
@@ -250,8 +248,8 @@ static void draw_cloud_sprite(CLOUD* c, int x, int y) {
 
     int fade = 13- (int)floor(c->timer / CLOUD_LIMIT * 12);
 
-    draw_bitmap_region_fading(bmpGoat,
-        c->frame*32,c->row*32, 32,32, x,y,c->flip,fade, 255);
+    batch_add_region_fading(bmpGoat,
+        c->frame*32,c->row*32, 32,32, x,y,c->flip,fade, 255, LAYER_CLOUD);
 }
 
 
@@ -280,7 +278,7 @@ static void draw_cloud(CLOUD* c) {
 
 
 // Draw a "single" goat
-static void draw_single_goat(GOAT* g, int x, int y) {
+static void draw_single_goat(GOAT* g, int x, int y, bool dying) {
 
     if(g->flip == FLIP_NONE)
         ++ x;
@@ -288,19 +286,20 @@ static void draw_single_goat(GOAT* g, int x, int y) {
         -- x;
 
     // Dying
-    if(status_is_game_over()) {
+    if(dying) {
 
         if(!g->dead) {
 
             int fade = 1 + (int)floor(g->deathTimer / DEATH_TIMER_MAX * 10.0f);
-            draw_bitmap_region_fading(
+            batch_add_region_fading(
                 bmpGoat,
                 g->spr.frame * g->spr.w,
                 g->spr.row * g->spr.h,
                 g->spr.w, g->spr.h,
                 x, y,
                 g->flip, 
-                fade, get_alpha()
+                fade, get_alpha(),
+                LAYER_GOAT
             );
         }
 
@@ -309,7 +308,7 @@ static void draw_single_goat(GOAT* g, int x, int y) {
     
 
     if(g->hurtTimer <= 0.0f || (int)floor(g->hurtTimer/4) % 2 == 0)
-        spr_draw(&g->spr,bmpGoat,x,y, g->flip);
+        spr_batch(&g->spr,bmpGoat,x,y, g->flip, LAYER_GOAT);
 
     else {
 
@@ -318,7 +317,7 @@ static void draw_single_goat(GOAT* g, int x, int y) {
         int sw = g->spr.w;
         int sh = g->spr.h;
 
-        draw_bitmap_region_fading(bmpGoat,sx,sy,sw,sh,x,y, g->flip,2,get_alpha());
+        batch_add_region_fading(bmpGoat,sx,sy,sw,sh,x,y, g->flip,2,get_alpha(), LAYER_GOAT);
     }
 }
 
@@ -340,13 +339,22 @@ void init_goat(ASSET_PACK* ass) {
     sHurt = (SAMPLE*)assets_get(ass, "hurt");
     sDie = (SAMPLE*)assets_get(ass, "die");
     sRam = (SAMPLE*)assets_get(ass, "ram");
+
+    // Getting hurt must be heard over the effects
+    set_sample_voices(sJump, 1, 2);
+    set_sample_voices(sRam, 1, 2);
+    set_sample_voices(sHurt, 2, 1);
+    set_sample_voices(sDie, 2, 1);
 }
 
 
 // Create a new goat
 GOAT create_goat(VEC2 p) {
 
+    // Clear the padding, too, so that game states can
+    // be compared byte by byte
     GOAT g;
+    memset(&g, 0, sizeof(GOAT));
 
     g.pos = p;
     g.oldY = p.y;
@@ -372,9 +380,10 @@ GOAT create_goat(VEC2 p) {
 }
 
 
-// Update goat
-void goat_update(GOAT* g, float tm) {
+// Update the goat of a game
+void goat_update(GAME_STATE* s, float tm) {
 
+    GOAT* g = &s->player;
     int i = 0;
     const float DELTA = -0.1f;
 
@@ -389,7 +398,7 @@ void goat_update(GOAT* g, float tm) {
         g->hurtTimer -= 1.0f * tm;
 
     // If game over, die if not already dead
-    if(status_is_game_over()) {
+    if(status_is_game_over(&s->status)) {
 
         if(!g->dead) {
 
@@ -402,7 +411,7 @@ void goat_update(GOAT* g, float tm) {
     }
 
     // Update basic things
-    control_goat(g);
+    control_goat(s, g);
     move_goat(g, tm);
     animate_goat(g, tm);
     generate_clouds(g, tm);
@@ -410,7 +419,7 @@ void goat_update(GOAT* g, float tm) {
     g->canJump = false;
 
     // Death
-    int camY = (int)get_global_camera()->pos.y;
+    int camY = (int)s->cam.pos.y;
 
     if(g->touchedGround && 
       (g->pos.y > camY+192+24 || (g->speed.y >= DELTA && g->pos.y <= camY) ) ) {
@@ -418,16 +427,19 @@ void goat_update(GOAT* g, float tm) {
         // Kill
         for(i = 0; i < 3; ++ i) {
 
-            status_reduce_health();
+            status_reduce_health(&s->status);
         }
 
-        play_sample(sDie, 0.70f);
+        game_state_play_sample(s, sDie, 0.70f);
     }
 }
 
 
-// Draw goat
-void goat_draw(GOAT* g) {
+// Draw the goat of a game (adds it to the sprite batch)
+void goat_draw(GAME_STATE* s) {
+
+    GOAT* g = &s->player;
+    bool dying = status_is_game_over(&s->status);
 
     int x = (int)roundf(g->pos.x-16);
     int y = (int)roundf(g->pos.y-28) +1;
@@ -440,16 +452,16 @@ void goat_draw(GOAT* g) {
     }
 
     // "Original"
-    draw_single_goat(g,x,y);
+    draw_single_goat(g,x,y, dying);
 
     // "Outsider"
     if(g->pos.x < g->spr.w/2) {
 
-        draw_single_goat(g,x +256,y);
+        draw_single_goat(g,x +256,y, dying);
     }
     if(g->pos.x > 256- g->spr.w/2) {
 
-        draw_single_goat(g,x -256,y);
+        draw_single_goat(g,x -256,y, dying);
     }
 }
 
@@ -480,12 +492,13 @@ void goat_floor_collision(GOAT* g, float x, float y, float w) {
 
 
 // Hurt collision
-void goat_hurt_collision(GOAT* g, float x, float y, float w, float h) {
+void goat_hurt_collision(GAME_STATE* s, float x, float y, float w, float h) {
 
     const float DIM_X = 8.0f;
     const float DIM_Y = 16.0f;
 
-    if(g->hurtTimer > 0.0f || status_is_game_over()) return;
+    GOAT* g = &s->player;
+    if(g->hurtTimer > 0.0f || status_is_game_over(&s->status)) return;
 
     // Check if inside the actual goat or those "off-screen entities"
     if(hurt(g->pos,DIM_X,DIM_Y,x,y,w,h)
@@ -493,15 +506,15 @@ void goat_hurt_collision(GOAT* g, float x, float y, float w, float h) {
     ||(g->pos.x > 256.0f-g->spr.w/2 && hurt(vec2(g->pos.x - 256, g->pos.y),DIM_X,DIM_Y,x,y,w,h) ) ) {
 
         g->hurtTimer = HURT_TIME;
-        status_reduce_health();
+        status_reduce_health(&s->status);
 
-        if(status_is_game_over()) {
+        if(status_is_game_over(&s->status)) {
 
-            play_sample(sDie, 0.70f);
+            game_state_play_sample(s, sDie, 0.70f);
         }
         else {
 
-            play_sample(sHurt, 0.60f);
+            game_state_play_sample(s, sHurt, 0.60f);
         }
     }
 }
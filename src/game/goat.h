@@ -8,6 +8,8 @@
 #include "../include/renderer.h"
 #include "../include/system.h"
 
+#include "context.h"
+
 // Cloud count
 #define CLOUD_COUNT 16
 
@@ -54,17 +56,17 @@ void init_goat(ASSET_PACK* ass);
 // Create a new goat
 GOAT create_goat(VEC2 p);
 
-// Update goat
-void goat_update(GOAT* g, float tm);
+// Update the goat of a game
+void goat_update(GAME_STATE* s, float tm);
 
-// Draw goat
-void goat_draw(GOAT* g);
+// Draw the goat of a game
+void goat_draw(GAME_STATE* s);
 
 // Goat-to-floor collision
 void goat_floor_collision(GOAT* g, float x, float y, float w);
 
 // Hurt collision
-void goat_hurt_collision(GOAT* g, float x, float y, float w, float h);
+void goat_hurt_collision(GAME_STATE* s, float x, float y, float w, float h);
 
 // Stop dashing
 void goat_stop_dashing(GOAT* g);
@@ -4,9 +4,10 @@
 
 #include "monster.h"
 
-#include "camera.h"
+#include "state.h"
 #include "game.h"
-#include "status.h"
+
+#include "../engine/mathext.h"
 
 #include "../include/std.h"
 #include "../include/audio.h"
@@ -43,39 +44,70 @@ static _BITMAP* bmpSplash;
 static SAMPLE* sHit;
 
 
+// Add a slot to the active list
+static void activate(MONSTER_LIST* l, int i) {
+
+    if(l->activePos[i] != -1) return;
+
+    l->activePos[i] = l->activeCount;
+    l->active[l->activeCount ++] = i;
+}
+
+
+// Remove a slot from the active list (swap-remove)
+static void deactivate(MONSTER_LIST* l, int i) {
+
+    int pos = l->activePos[i];
+    if(pos == -1) return;
+
+    int last = l->active[-- l->activeCount];
+    l->active[pos] = last;
+    l->activePos[last] = pos;
+    l->activePos[i] = -1;
+
+    // Free slots must not move
+    l->speedX[i] = 0.0f;
+    l->speedY[i] = 0.0f;
+
+    pool_free(&l->pool, l->next, l->generation, i);
+}
+
+
 // "Set monster"
-static void set_monster(MONSTER* m) {
+static void set_monster(MONSTER_LIST* l, int i) {
 
-    switch(m->id) {
+    MONSTER* m = &l->cold[i];
 
-    case 0:
+    switch(l->id[i]) {
 
-        m->direction = rand() % 2 == 0 ? 1 : -1;
-        m->speed.x = WALKER_SPEED * m->direction;
+    case MONSTER_WALKER:
+
+        m->direction = rng_range(&l->rng, 2) == 0 ? 1 : -1;
+        l->speedX[i] = WALKER_SPEED * m->direction;
         break;
 
-    case 1:
+    case MONSTER_FLIER:
 
-        m->spcTimer = (float) (rand() % 1000) / 1000.0f * M_PI * 2;
-        m->direction = rand() % 2 == 0 ? 1 : -1;
-        m->target.x = FLIER_SPEED * m->direction;
+        l->timer[i] = rng_float(&l->rng) * M_PI * 2;
+        m->direction = rng_range(&l->rng, 2) == 0 ? 1 : -1;
+        l->targetX[i] = FLIER_SPEED * m->direction;
         break;
 
-    case 2:
-        m->spcSwitch = true;
+    case MONSTER_SLIME:
+        l->spcSwitch[i] = true;
         break;
 
-    case 3:
-        m->spcTimer = (float) (rand() % 1000) / 1000.0f * M_PI * 2;
+    case MONSTER_SPIKEY:
+        l->timer[i] = rng_float(&l->rng) * M_PI * 2;
         break;
 
-    case 4:
+    case MONSTER_HEDGEHOG:
         break;
 
-    case 5:
+    case MONSTER_FISH:
 
-        m->target.x = FISH_ACC * (m->pos.x > 128.f ? -1 : 1);
-        m->spcSwitch = false;
+        l->targetX[i] = FISH_ACC * (l->x[i] > 128.f ? -1 : 1);
+        l->spcSwitch[i] = false;
         break;
 
     default:
@@ -85,222 +117,259 @@ static void set_monster(MONSTER* m) {
 }
 
 
-// Unique movement
-static void unique_movement(MONSTER* m, float tm) {
-
-    const float DELTA = 16.0f;
+// Walker kernel
+static void update_walkers(MONSTER_LIST* l, const int* slots, int n, float tm) {
 
-    switch(m->id) {
+    int k, i;
+    for(k = 0; k < n; ++ k) {
 
-    // Walker
-    case 0:
+        i = slots[k];
 
         // Limit collisions
-        if(m->speed.x < 0.0f && m->pos.x-8.0f < m->leftLimit) {
+        if(l->speedX[i] < 0.0f && l->x[i]-8.0f < l->leftLimit[i]) {
 
-            m->speed.x *= -1;
-            m->pos.x = m->leftLimit +8.0f;
+            l->speedX[i] *= -1;
+            l->x[i] = l->leftLimit[i] +8.0f;
         }
-        else if(m->speed.x > 0.0f && m->pos.x+8.0f > m->rightLimit) {
+        else if(l->speedX[i] > 0.0f && l->x[i]+8.0f > l->rightLimit[i]) {
 
-            m->speed.x *= -1;
-            m->pos.x = m->rightLimit -8.0f;
+            l->speedX[i] *= -1;
+            l->x[i] = l->rightLimit[i] -8.0f;
         }
-        break;
 
-    // Flier
-    case 1:
+        // Animate
+        spr_animate(&l->cold[i].spr, MONSTER_WALKER,0,3,6, tm);
+        l->cold[i].flip = l->speedX[i] > 0.0f ? FLIP_H : FLIP_NONE;
+    }
+}
+
+
+// Flier kernel
+static void update_fliers(MONSTER_LIST* l, const int* slots, int n, float tm) {
+
+    int k, i;
+    for(k = 0; k < n; ++ k) {
+
+        i = slots[k];
 
         // Update speed
-        if(m->target.x > m->speed.x) {
+        if(l->targetX[i] > l->speedX[i]) {
 
-            m->speed.x += FLIER_ACC * tm;
-            if(m->speed.x > m->target.x)
-                m->speed.x = m->target.x;
+            l->speedX[i] += FLIER_ACC * tm;
+            if(l->speedX[i] > l->targetX[i])
+                l->speedX[i] = l->targetX[i];
         }
-        else if(m->target.x < m->speed.x) {
+        else if(l->targetX[i] < l->speedX[i]) {
 
-            m->speed.x -= FLIER_ACC * tm;
-            if(m->speed.x < m->target.x)
-                m->speed.x = m->target.x;
+            l->speedX[i] -= FLIER_ACC * tm;
+            if(l->speedX[i] < l->targetX[i])
+                l->speedX[i] = l->targetX[i];
         }
 
         // Limit collisions
-        if( (m->target.x < 0.0f && m->pos.x-8.0f < m->leftLimit)
-        || (m->target.x > 0.0f && m->pos.x+8.0f > m->rightLimit) ) {
+        if( (l->targetX[i] < 0.0f && l->x[i]-8.0f < l->leftLimit[i])
+        || (l->targetX[i] > 0.0f && l->x[i]+8.0f > l->rightLimit[i]) ) {
 
-            m->target.x *= -1;
+            l->targetX[i] *= -1;
         }
 
         // "Waves"
-        m->spcTimer += FLIER_WAVE_SPEED * tm;
-        m->pos.y = m->startPos.y + sinf(m->spcTimer) * FLIER_AMPLITUDE;
+        l->timer[i] += FLIER_WAVE_SPEED * tm;
+        l->y[i] = l->startY[i] + table_sin(l->timer[i]) * FLIER_AMPLITUDE;
 
-        break;
+        // Animate
+        spr_animate(&l->cold[i].spr, MONSTER_FLIER,0,3, 5, tm);
+        l->cold[i].flip = FLIP_NONE;
+    }
+}
+
+
+// Slime kernel
+static void update_slimes(MONSTER_LIST* l, const int* slots, int n, float tm) {
+
+    const float DELTA = 16.0f;
+
+    int k, i;
+    MONSTER* m;
+    for(k = 0; k < n; ++ k) {
 
-    // Slime
-    case 2:
+        i = slots[k];
+        m = &l->cold[i];
 
-        if(m->spcSwitch) {
+        if(l->spcSwitch[i]) {
 
-            m->spcTimer -= 1.0f * tm;
-            if(m->spcTimer <= 0.0f) {
+            l->timer[i] -= 1.0f * tm;
+            if(l->timer[i] <= 0.0f) {
 
-                m->spcTimer = (float) (JUMP_WAIT_MIN + (rand() % (JUMP_WAIT_MAX-JUMP_WAIT_MIN)) );
+                l->timer[i] = (float) (JUMP_WAIT_MIN + rng_range(&l->rng, JUMP_WAIT_MAX-JUMP_WAIT_MIN) );
 
                 // Calculate speeds
-                float direction = rand() % 2 == 0 ? 1 : -1;
-                if(m->pos.x - m->leftLimit < DELTA)
+                float direction = rng_range(&l->rng, 2) == 0 ? 1 : -1;
+                if(l->x[i] - l->leftLimit[i] < DELTA)
                     direction = 1;
                 
-                else if(m->rightLimit - m->pos.x < DELTA)
+                else if(l->rightLimit[i] - l->x[i] < DELTA)
                     direction = -1;
 
-                m->speed.x = SLIME_SPEED_X * direction;
-                m->speed.y = SLIME_JUMP_MIN + (float)(rand() % 1000) / 1000.0f * (SLIME_JUMP_MAX-SLIME_JUMP_MIN);
+                l->speedX[i] = SLIME_SPEED_X * direction;
+                l->speedY[i] = SLIME_JUMP_MIN + rng_float(&l->rng) * (SLIME_JUMP_MAX-SLIME_JUMP_MIN);
                 
 
-                m->spcSwitch = false;
+                l->spcSwitch[i] = false;
             }
         }
         else {
 
             // Limit collisions
-            if( (m->speed.x < 0.0f && m->pos.x-8.0f < m->leftLimit)
-            || (m->speed.x > 0.0f && m->pos.x+8.0f > m->rightLimit) ) {
+            if( (l->speedX[i] < 0.0f && l->x[i]-8.0f < l->leftLimit[i])
+            || (l->speedX[i] > 0.0f && l->x[i]+8.0f > l->rightLimit[i]) ) {
 
-                m->speed.x = 0.0f;
+                l->speedX[i] = 0.0f;
             }
 
             // Gravity
-            m->speed.y += SLIME_GRAVITY * tm;
-            if(m->speed.y >= SLIME_GRAVITY_MAX) {
+            l->speedY[i] += SLIME_GRAVITY * tm;
+            if(l->speedY[i] >= SLIME_GRAVITY_MAX) {
 
-                m->speed.y = SLIME_GRAVITY_MAX;
+                l->speedY[i] = SLIME_GRAVITY_MAX;
             }
 
             // Ground collision (pseudo)
-            if(m->pos.y > m->startPos.y) {
+            if(l->y[i] > l->startY[i]) {
 
-                m->pos.y = m->startPos.y;
-                m->speed.y = 0.0f;
-                m->speed.x = 0.0f;
-                m->spcSwitch = true;
+                l->y[i] = l->startY[i];
+                l->speedY[i] = 0.0f;
+                l->speedX[i] = 0.0f;
+                l->spcSwitch[i] = true;
             }
         }
 
-        break;
-
-    // Spikey
-    case 3:
+        // Animate
+        m->spr.row = MONSTER_SLIME;
 
-        m->spcTimer += SPIKEY_WAVE_SPEED * tm;
-        m->pos.y = m->startPos.y + sinf(m->spcTimer) * SPIKEY_AMPLITUDE;
+        if(l->spcSwitch[i])
+            m->spr.frame = 0;
 
-        break;
+        else {
+            
+            m->spr.frame = l->speedY[i] < 0.0f ? 1 : 2;
+            m->flip = l->speedX[i] > 0.0f ? FLIP_H : FLIP_NONE;
+        }
+    }
+}
 
-    // Hedgehog
-    case 4:
-        break;
 
-    // Fish
-    case 5:
+// Spikey kernel
+static void update_spikeys(MONSTER_LIST* l, const int* slots, int n, float tm) {
 
-        if(!m->spcSwitch) break;
+    int k, i;
+    for(k = 0; k < n; ++ k) {
 
-        // Update speed
-        if(m->target.x > 0.0f && m->speed.x < FISH_TARGET) {
+        i = slots[k];
 
-            m->speed.x += m->target.x * tm;
-            if(m->speed.x > FISH_TARGET)
-                m->speed.x = FISH_TARGET;
-        }
-        else if(m->target.x < 0.0f && m->speed.x > -FISH_TARGET) {
+        l->timer[i] += SPIKEY_WAVE_SPEED * tm;
+        l->y[i] = l->startY[i] + table_sin(l->timer[i]) * SPIKEY_AMPLITUDE;
 
-            m->speed.x += m->target.x * tm;
-            if(m->speed.x < -FISH_TARGET)
-                m->speed.x = -FISH_TARGET;
-        }
+        // Animate
+        spr_animate(&l->cold[i].spr, MONSTER_SPIKEY,0,3, 5, tm);
+        l->cold[i].flip = FLIP_NONE;
+    }
+}
 
-        // Outside the screen (horizontally)
-        if(m->pos.x > 256.0f + 32.0f || m->pos.x < -32.0f) {
 
-            m->exist = false;
-            m->dying = false;
-        }
+// Hedgehog kernel
+static void update_hedgehogs(MONSTER_LIST* l, const int* slots, int n, float tm) {
 
-        break;
+    int k, i;
+    for(k = 0; k < n; ++ k) {
 
-    default:
+        i = slots[k];
 
-        break;
+        // Animate
+        spr_animate(&l->cold[i].spr, MONSTER_HEDGEHOG,0,3, 8, tm);
+        l->cold[i].flip = FLIP_NONE;
     }
 }
 
 
-// Move monster
-static void move_monster(MONSTER* m, float tm) {
+// Fish kernel
+static void update_fish(MONSTER_LIST* l, const int* slots, int n, float tm) {
+
+    int k, i;
+    for(k = 0; k < n; ++ k) {
+
+        i = slots[k];
+
+        if(l->spcSwitch[i]) {
 
-    // Move axes
-    m->pos.x += m->speed.x * tm;
-    m->pos.y += m->speed.y * tm;
+            // Update speed
+            if(l->targetX[i] > 0.0f && l->speedX[i] < FISH_TARGET) {
+
+                l->speedX[i] += l->targetX[i] * tm;
+                if(l->speedX[i] > FISH_TARGET)
+                    l->speedX[i] = FISH_TARGET;
+            }
+            else if(l->targetX[i] < 0.0f && l->speedX[i] > -FISH_TARGET) {
+
+                l->speedX[i] += l->targetX[i] * tm;
+                if(l->speedX[i] < -FISH_TARGET)
+                    l->speedX[i] = -FISH_TARGET;
+            }
 
-    // Unique movement
-    unique_movement(m, tm);
+            // Outside the screen (horizontally)
+            if(l->x[i] > 256.0f + 32.0f || l->x[i] < -32.0f) {
 
-    // If "too high", die
-    if(m->pos.y+1 < get_global_camera()->pos.y) {
+                l->exist[i] = false;
+                l->cold[i].dying = false;
+            }
+        }
 
-        m->exist = false;
-        m->deathTimer = -1.0f;
+        // Animate
+        spr_animate(&l->cold[i].spr, MONSTER_FISH,0,3,4, tm);
+        l->cold[i].flip = l->targetX[i] > 0.0f ? FLIP_H : FLIP_NONE;
     }
 }
 
 
-// Animate
-static void animate_monster(MONSTER* m, float tm) {
+// Move all the monsters. Speeds are zero for the slots
+// that do not move, so no checks are needed
+static void move_monsters(MONSTER_LIST* l, float tm) {
 
-    switch(m->id) {
-
-    case 0:
-        spr_animate(&m->spr, m->id,0,3,6, tm);
-        m->flip = m->speed.x > 0.0f ? FLIP_H : FLIP_NONE;
-        break;
+    int i = 0;
+    for(; i < MONSTER_COUNT; ++ i) {
 
-    case 3:
-    case 1:
+        l->x[i] += l->speedX[i] * tm;
+        l->y[i] += l->speedY[i] * tm;
+    }
+}
 
-        spr_animate(&m->spr, m->id,0,3, 5, tm);
-        m->flip = FLIP_NONE;
-        break;
 
-    case 2:
+// Group the existing monsters by type (counting sort)
+static void group_by_type(MONSTER_LIST* l, int* slots, int* start) {
 
-        m->spr.row = m->id;
+    int count[MONSTER_TYPE_COUNT] = {0};
+    int pos[MONSTER_TYPE_COUNT];
+    int k, i, t;
 
-        if(m->spcSwitch)
-            m->spr.frame = 0;
+    for(k = 0; k < l->activeCount; ++ k) {
 
-        else {
-            
-            m->spr.frame = m->speed.y < 0.0f ? 1 : 2;
-            m->flip = m->speed.x > 0.0f ? FLIP_H : FLIP_NONE;
-        }
-        break;
+        i = l->active[k];
+        if(l->exist[i])
+            ++ count[l->id[i]];
+    }
 
-    case 4:
-        spr_animate(&m->spr, m->id,0,3, 8, tm);
-        m->flip = FLIP_NONE;
-        break;
+    start[0] = 0;
+    for(t = 0; t < MONSTER_TYPE_COUNT; ++ t) {
 
-    case 5:
+        start[t+1] = start[t] + count[t];
+        pos[t] = start[t];
+    }
 
-        spr_animate(&m->spr, m->id,0,3,4, tm);
-        m->flip = m->target.x > 0.0f ? FLIP_H : FLIP_NONE;
-        break;
+    for(k = 0; k < l->activeCount; ++ k) {
 
-    default:
-        break;
+        i = l->active[k];
+        if(l->exist[i])
+            slots[pos[l->id[i]] ++] = i;
     }
 }
 
@@ -308,8 +377,8 @@ static void animate_monster(MONSTER* m, float tm) {
 // Draw fading
 static void draw_fading(int sx, int sy, int x, int y, int fade, int flip) {
 
-    draw_bitmap_region_fading(bmpMonsters,sx,sy,
-                32,32,x,y, flip, fade, get_alpha());
+    batch_add_region_fading(bmpMonsters,sx,sy,
+                32,32,x,y, flip, fade, get_alpha(), LAYER_MONSTER);
 }
 
 
@@ -324,17 +393,59 @@ static void do_splash(MONSTER* m, float x, float y) {
 
 
 // Die
-static void monster_die(MONSTER* m, bool stomped) {
+static void monster_die(GAME_STATE* s, int i, bool stomped, VEC2 deathSpeed) {
 
-    m->exist = false;
+    MONSTER_LIST* l = &s->monsters;
+    MONSTER* m = &l->cold[i];
+
+    l->exist[i] = false;
     m->deathTimer = DEATH_MAX;
     m->dying = true;
     m->stomped = stomped;
 
-    play_sample(sHit, 0.80f);
+    // Dying monsters move with the death speed
+    m->deathSpeed = deathSpeed;
+    l->speedX[i] = deathSpeed.x;
+    l->speedY[i] = deathSpeed.y;
+
+    game_state_play_sample(s, sHit, 0.80f);
 
     // Add score
-    status_add_score();
+    status_add_score(&s->status);
+}
+
+
+// Update a dying monster
+static void update_dying(MONSTER_LIST* l, int i, float tm) {
+
+    MONSTER* m = &l->cold[i];
+
+    // Update death timer
+    if(m->deathTimer > 0.0f) {
+
+        m->deathTimer -= 1.0f * tm;
+
+        if(!m->stomped) {
+
+            m->deathSpeed.y += DEATH_GRAVITY * tm;
+            l->speedY[i] = m->deathSpeed.y;
+        }
+
+        // Stop moving
+        if(m->deathTimer <= 0.0f) {
+
+            l->speedX[i] = 0.0f;
+            l->speedY[i] = 0.0f;
+        }
+    }
+
+    // Animate splash
+    if(m->splash.frame < 5)
+        spr_animate(&m->splash, 0,0,5,4, tm);
+
+    // If splash ended & death timer <= 0, no more dying
+    if(m->splash.frame >= 5 && m->deathTimer <= 0.0f)
+        m->dying = false;
 }
 
 
@@ -346,152 +457,226 @@ void init_monsters(ASSET_PACK* ass) {
     bmpSplash = (_BITMAP*)assets_get(ass, "splash");
 
     sHit = (SAMPLE*)assets_get(ass, "hit");
+    set_sample_voices(sHit, 1, 3);
+
+    init_sine_table();
 }
 
 
-// Create a monster
-MONSTER create_monster(VEC2 pos, float left, float right, int id) {
-
-    MONSTER m;
-    m.pos = pos;
-    m.id = id;
-    m.deathTimer = 0.0f;
-    m.speed = vec2(0, 0);
-    m.spr = create_sprite(32, 32);
-    m.splash = create_sprite(32, 32);
-    m.exist = true;
-    m.dying = false;
-    m.flip = FLIP_NONE;
-    m.leftLimit = left;
-    m.rightLimit = right;
-    m.startPos = pos;
-    if(m.rightLimit > 256)
-        m.rightLimit = 256;
+// Seed the monster random numbers
+void monsters_seed(MONSTER_LIST* l, Uint64 seed) {
 
-    // Set id-depending values
-    set_monster(&m);
+    rng_seed(&l->rng, seed, RNG_STREAM_MONSTERS);
+}
+
+
+// Clear a monster list
+void monster_list_clear(MONSTER_LIST* l) {
 
-    return m;
+    int i = 0;
+    for(; i < MONSTER_COUNT; ++ i) {
+
+        l->exist[i] = false;
+        l->speedX[i] = 0.0f;
+        l->speedY[i] = 0.0f;
+        l->cold[i].dying = false;
+        l->cold[i].deathTimer = -1.0f;
+        l->activePos[i] = -1;
+    }
+    l->activeCount = 0;
+
+    pool_reset(&l->pool, l->next, l->generation, MONSTER_COUNT);
 }
 
 
-// Update a monster
-void monster_update(MONSTER* m, float tm) {
+// Add a monster
+POOL_HANDLE monster_add(MONSTER_LIST* l, VEC2 pos, float left, float right, int id) {
+
+    int i = pool_alloc(&l->pool, l->next);
+    if(i == -1) return POOL_HANDLE_NONE;
+
+    MONSTER* m = &l->cold[i];
+
+    l->x[i] = pos.x;
+    l->y[i] = pos.y;
+    l->speedX[i] = 0.0f;
+    l->speedY[i] = 0.0f;
+    l->targetX[i] = 0.0f;
+    l->startY[i] = pos.y;
+    l->timer[i] = 0.0f;
+    l->leftLimit[i] = left;
+    l->rightLimit[i] = right;
+    if(l->rightLimit[i] > 256)
+        l->rightLimit[i] = 256;
+    l->id[i] = id;
+    l->exist[i] = true;
+    l->spcSwitch[i] = false;
+
+    m->deathTimer = 0.0f;
+    m->deathSpeed = vec2(0, 0);
+    m->direction = 0;
+    m->spr = create_sprite(32, 32);
+    m->splash = create_sprite(32, 32);
+    m->splashPos = vec2(0, 0);
+    m->dying = false;
+    m->stomped = false;
+    m->flip = FLIP_NONE;
 
-    if(m->exist == false) {
+    // Set id-depending values
+    set_monster(l, i);
 
-        if(!m->dying) return;
+    activate(l, i);
 
-        // Update death timer
-        if(m->deathTimer > 0.0f) {
+    return pool_handle(l->generation, i);
+}
 
-            m->deathTimer -= 1.0f * tm;
 
-            m->pos.x += m->deathSpeed.x *tm;
-            m->pos.y += m->deathSpeed.y *tm;
+// Update monsters
+void monsters_update(MONSTER_LIST* l, CAMERA* cam, float tm) {
 
-            if(!m->stomped)
-                m->deathSpeed.y += DEATH_GRAVITY * tm;
-        }
+    // Update kernels, by type
+    static void (*KERNELS[MONSTER_TYPE_COUNT]) (MONSTER_LIST*, const int*, int, float) = {
 
-        // Animate splash
-        if(m->splash.frame < 5)
-            spr_animate(&m->splash, 0,0,5,4, tm);
+        update_walkers, update_fliers, update_slimes,
+        update_spikeys, update_hedgehogs, update_fish,
+    };
 
-        // If splash ended & death timer <= 0, no more dying
-        if(m->splash.frame >= 5 && m->deathTimer <= 0.0f)
-            m->dying = false;
+    int slots[MONSTER_COUNT];
+    int start[MONSTER_TYPE_COUNT +1];
+    int i, k, t;
 
-        return;
+    // Move
+    move_monsters(l, tm);
+
+    // Unique movement & animation, one type at a time
+    group_by_type(l, slots, start);
+    for(t = 0; t < MONSTER_TYPE_COUNT; ++ t) {
+
+        if(start[t+1] > start[t])
+            KERNELS[t](l, slots + start[t], start[t+1] - start[t], tm);
     }
 
-    // Move
-    move_monster(m, tm);
+    // Dying & death checks. Iterated backwards so removing
+    // does not skip anything
+    float camY = cam->pos.y;
+    for(k = l->activeCount-1; k >= 0; -- k) {
+
+        i = l->active[k];
+
+        if(l->exist[i]) {
+
+            // If "too high", die
+            if(l->y[i]+1 < camY) {
+
+                l->exist[i] = false;
+                l->cold[i].deathTimer = -1.0f;
+            }
+        }
+        else if(l->cold[i].dying) {
+
+            update_dying(l, i, tm);
+        }
 
-    // Animate
-    animate_monster(m, tm);
+        if(!l->exist[i] && !l->cold[i].dying)
+            deactivate(l, i);
+    }
 }
 
 
-// Draw a monster
-void monster_draw(MONSTER* m) {
+// Draw monsters (adds them to the sprite batch)
+void monsters_draw(MONSTER_LIST* l) {
 
-    // Rendering position
-    int x = (int)floorf(m->pos.x-16.0f);
-    int y = (int)floorf(m->pos.y-28.0f) +1;
+    int i, k, x, y, sx, sy, fade;
+    MONSTER* m;
 
-    // Splash position
-    int sx = (int)floorf(m->splashPos.x-16.0f);
-    int sy = (int)floorf(m->splashPos.y-16.0f);
+    for(k = 0; k < l->activeCount; ++ k) {
 
-    if(!m->exist) {
-        
-        if(!m->dying) return;
+        i = l->active[k];
+        m = &l->cold[i];
 
-        // Fading
-        if(m->deathTimer > 0.0f) {
+        // Rendering position
+        x = (int)floorf(l->x[i]-16.0f);
+        y = (int)floorf(l->y[i]-28.0f) +1;
 
-            int fade = 1+ (int)roundf(m->deathTimer / DEATH_MAX * 8.0f);
-            draw_fading(m->spr.frame*32.0f , m->id*32.0f,x,y,fade, m->flip);
+        if(!l->exist[i]) {
+            
+            if(!m->dying) continue;
 
-        }   
+            // Splash position
+            sx = (int)floorf(m->splashPos.x-16.0f);
+            sy = (int)floorf(m->splashPos.y-16.0f);
 
-        // Splash
-        spr_draw(&m->splash, bmpSplash, sx, sy, FLIP_NONE);
+            // Fading
+            if(m->deathTimer > 0.0f) {
 
-        return;
-    }
+                fade = 1+ (int)roundf(m->deathTimer / DEATH_MAX * 8.0f);
+                draw_fading(m->spr.frame*32.0f , l->id[i]*32.0f,x,y,fade, m->flip);
+
+            }   
 
-    // Draw
-    spr_draw(&m->spr,bmpMonsters, x,y, m->flip);
+            // Splash
+            spr_batch(&m->splash, bmpSplash, sx, sy, FLIP_NONE, LAYER_SPLASH);
+
+            continue;
+        }
+
+        // Draw
+        spr_batch(&m->spr,bmpMonsters, x,y, m->flip, LAYER_MONSTER);
+    }
 }
 
 
 // Monster-to-goat collision
-void monster_goat_collision(MONSTER* m, GOAT* g) {
+void monster_goat_collision(GAME_STATE* s, int i) {
 
     const float GOAT_JUMP_BACK = -2.0f;
     const float DELTA = 48.0f;
 
-    if(!m->exist) return;
+    MONSTER_LIST* l = &s->monsters;
+    GOAT* g = &s->player;
+
+    if(!l->exist[i]) return;
+
+    MONSTER* m = &l->cold[i];
+    float mx = l->x[i];
+    float my = l->y[i];
 
     // If fish
-    if(m->id == 5 && !m->spcSwitch) {
+    if(l->id[i] == MONSTER_FISH && !l->spcSwitch[i]) {
 
-        if(fabs(g->pos.y-m->pos.y) < DELTA && !g->canJump)
-            m->spcSwitch = true;
+        if(fabs(g->pos.y-my) < DELTA && !g->canJump)
+            l->spcSwitch[i] = true;
     }
 
-    // If "spikey" (id 3)
-    if(m->id == 3) {
+    // If "spikey"
+    if(l->id[i] == MONSTER_SPIKEY) {
 
-        goat_hurt_collision(g,m->pos.x-19,m->pos.y-16,28,16);
+        goat_hurt_collision(s,mx-19,my-16,28,16);
     }
 
     // Ram collision
     if(g->dashing) {
 
         // If coming from the correct direction
-        if( (g->speed.x > 0.0f && g->pos.x < m->pos.x) 
-        || (g->speed.x < 0.0f && g->pos.x > m->pos.x)) {
+        if( (g->speed.x > 0.0f && g->pos.x < mx) 
+        || (g->speed.x < 0.0f && g->pos.x > mx)) {
 
 
             // If inside the collision area
-            if(g->pos.x+12.0f >= m->pos.x-8.0f && g->pos.x-12.0f <= m->pos.x+8.0f
-            && g->pos.y >= m->pos.y-16 && g->pos.y-16.0f <= m->pos.y ) {
+            if(g->pos.x+12.0f >= mx-8.0f && g->pos.x-12.0f <= mx+8.0f
+            && g->pos.y >= my-16 && g->pos.y-16.0f <= my ) {
 
                 float speedx = g->speed.x;
 
-                monster_die(m, false);
-
-                m->deathSpeed.x = speedx * DEATH_SPEED_X_MUL;
-                m->deathSpeed.y = DEATH_SPEED_Y;
+                monster_die(s, i, false, 
+                    vec2(speedx * DEATH_SPEED_X_MUL, DEATH_SPEED_Y));
 
                 g->speed.x = 0.0f;
                 goat_stop_dashing(g);
                 
-                do_splash(m,m->pos.x, g->pos.y -10.0f);
-                add_gem_with_gravity(m->pos.x,m->pos.y-12.0f,speedx* GEM_SPEED_X_MUL,GEM_SPEED_Y);
+                do_splash(m,mx, g->pos.y -10.0f);
+                gem_add_with_gravity(&s->gems, vec2(mx,my-12.0f), 
+                    vec2(speedx* GEM_SPEED_X_MUL,GEM_SPEED_Y));
 
                 return;
             }
@@ -499,26 +684,25 @@ void monster_goat_collision(MONSTER* m, GOAT* g) {
         }
     }
 
-    // If hedgehog (id 4)
-    if(m->id == 4) {
+    // If hedgehog
+    if(l->id[i] == MONSTER_HEDGEHOG) {
 
-        goat_hurt_collision(g,m->pos.x-11,m->pos.y-26,22,12);
+        goat_hurt_collision(s,mx-11,my-26,22,12);
     }
 
 
     // If in the same horizontal area
-    if(g->pos.x+8.0f >= m->pos.x-8.0f && g->pos.x-8.0f <= m->pos.x+8.0f) {
+    if(g->pos.x+8.0f >= mx-8.0f && g->pos.x-8.0f <= mx+8.0f) {
 
         // If the goat is jumping over the monster
-        if(g->speed.y > 0.0f && g->pos.y > m->pos.y-26.0f && g->pos.y < m->pos.y-16.0f) {
+        if(g->speed.y > 0.0f && g->pos.y > my-26.0f && g->pos.y < my-16.0f) {
 
-            monster_die(m, true);
-            m->deathSpeed = vec2(0, 0);
+            monster_die(s, i, true, vec2(0, 0));
 
             g->speed.y = GOAT_JUMP_BACK;
 
-            do_splash(m, g->pos.x, m->pos.y-18);
-            add_gem_with_gravity(m->pos.x,m->pos.y-12.0f,0.0f,-0.5f);
+            do_splash(m, g->pos.x, my-18);
+            gem_add_with_gravity(&s->gems, vec2(mx,my-12.0f), vec2(0.0f,-0.5f));
 
             return;
         }
@@ -526,46 +710,49 @@ void monster_goat_collision(MONSTER* m, GOAT* g) {
     }
 
     // Hurt collision
-    goat_hurt_collision(g, m->pos.x-8.0f,m->pos.y-16.0f,16.0f,16.0f);
+    goat_hurt_collision(s, mx-8.0f,my-16.0f,16.0f,16.0f);
 }
 
 
 // Monster-to-monster collision
-void monster_to_monster_collision(MONSTER* m1, MONSTER* m2) {
+void monster_to_monster_collision(MONSTER_LIST* l, int i1, int i2) {
 
-    if(m1->id == 5 || m2->id == 5 || m1->exist == false || m2->exist == false)
+    if(l->id[i1] == MONSTER_FISH || l->id[i2] == MONSTER_FISH || l->exist[i1] == false || l->exist[i2] == false)
         return;
 
+    float* sx = l->speedX;
+    float* tx = l->targetX;
+
     // Check if vertically overlap
-    if(m1->pos.y > m2->pos.y-24 && m1->pos.y-24 < m2->pos.y) {
+    if(l->y[i1] > l->y[i2]-24 && l->y[i1]-24 < l->y[i2]) {
 
         // Right-to-left
         // TODO: Get rid of the repeating code
-        if(m1->pos.x > m2->pos.x && m1->speed.x < 0.0f && m1->pos.x < m2->pos.x+16.0f) {
+        if(l->x[i1] > l->x[i2] && sx[i1] < 0.0f && l->x[i1] < l->x[i2]+16.0f) {
 
-            m1->speed.x *= -1;
-            if(m2->speed.x > 0.0f)
-                m2->speed.x *= -1;
+            sx[i1] *= -1;
+            if(sx[i2] > 0.0f)
+                sx[i2] *= -1;
 
-            if(m1->target.x < 0.0f)
-                m1->target.x *= -1;
+            if(tx[i1] < 0.0f)
+                tx[i1] *= -1;
 
-            if(m2->target.x > 0.0f)
-                m2->target.x *= -1;
+            if(tx[i2] > 0.0f)
+                tx[i2] *= -1;
         }
         // Left-to-right
         else 
-        if(m1->pos.x < m2->pos.x && m1->speed.x > 0.0f && m1->pos.x > m2->pos.x-16.0f) {
+        if(l->x[i1] < l->x[i2] && sx[i1] > 0.0f && l->x[i1] > l->x[i2]-16.0f) {
 
-            m1->speed.x *= -1;
-            if(m2->speed.x < 0.0f)
-                m2->speed.x *= -1;
+            sx[i1] *= -1;
+            if(sx[i2] < 0.0f)
+                sx[i2] *= -1;
 
-            if(m1->target.x > 0.0f)
-                m1->target.x *= -1;
+            if(tx[i1] > 0.0f)
+                tx[i1] *= -1;
 
-            if(m2->target.x < 0.0f)
-                m2->target.x *= -1;
+            if(tx[i2] < 0.0f)
+                tx[i2] *= -1;
         }
     }
 }
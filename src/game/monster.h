@@ -8,54 +8,109 @@
 #include "../include/renderer.h"
 #include "../include/system.h"
 
+#include "context.h"
 #include "goat.h"
+#include "camera.h"
 
-// Monster type
+#include "../engine/pool.h"
+#include "../engine/rng.h"
+
+// Monster capacity. Can be raised at compile time,
+// for example -DMONSTER_COUNT=512 for stress tests
+#ifndef MONSTER_COUNT
+#define MONSTER_COUNT 16
+#endif
+
+// Monster types
+enum {
+
+    MONSTER_WALKER = 0,
+    MONSTER_FLIER = 1,
+    MONSTER_SLIME = 2,
+    MONSTER_SPIKEY = 3,
+    MONSTER_HEDGEHOG = 4,
+    MONSTER_FISH = 5,
+
+    MONSTER_TYPE_COUNT = 6,
+};
+
+// Monster cold data
 typedef struct {
 
-    VEC2 pos;
-    VEC2 startPos;
-    VEC2 speed;
     VEC2 deathSpeed;
-    VEC2 target;
-
-    float spcTimer;
-    bool spcSwitch;
-    
-    int id;
-    int flip;
     int direction;
+    int flip;
     SPRITE spr;
 
     SPRITE splash;
     VEC2 splashPos;
 
-    float leftLimit;
-    float rightLimit;
-
-    bool exist;
     bool stomped;
     bool dying;
     float deathTimer;
 }
 MONSTER;
 
+// Monster list. Hot data is stored as a structure of
+// arrays indexed by slot, the live slots (existing
+// or dying) are listed densely in active
+typedef struct {
+
+    // Hot data
+    float x[MONSTER_COUNT];
+    float y[MONSTER_COUNT];
+    float speedX[MONSTER_COUNT];
+    float speedY[MONSTER_COUNT];
+    float targetX[MONSTER_COUNT];
+    float startY[MONSTER_COUNT];
+    float timer[MONSTER_COUNT];
+    float leftLimit[MONSTER_COUNT];
+    float rightLimit[MONSTER_COUNT];
+    int id[MONSTER_COUNT];
+    bool exist[MONSTER_COUNT];
+    bool spcSwitch[MONSTER_COUNT];
+
+    // Cold data
+    MONSTER cold[MONSTER_COUNT];
+
+    // Live slots
+    int active[MONSTER_COUNT];
+    int activePos[MONSTER_COUNT]; // Position in active, -1 if free
+    int activeCount;
+
+    // Slot pool
+    POOL pool;
+    int next[MONSTER_COUNT];
+    Uint16 generation[MONSTER_COUNT];
+
+    // Random numbers
+    RNG rng;
+}
+MONSTER_LIST;
+
 // Initialize monsters
 void init_monsters(ASSET_PACK* ass);
 
-// Create a monster
-MONSTER create_monster(VEC2 pos, float left, float right, int id);
+// Seed the monster random numbers
+void monsters_seed(MONSTER_LIST* l, Uint64 seed);
+
+// Clear a monster list
+void monster_list_clear(MONSTER_LIST* l);
+
+// Add a monster. Returns a handle, or POOL_HANDLE_NONE
+// if the list is full
+POOL_HANDLE monster_add(MONSTER_LIST* l, VEC2 pos, float left, float right, int id);
 
-// Update a monster
-void monster_update(MONSTER* m, float tm);
+// Update monsters
+void monsters_update(MONSTER_LIST* l, CAMERA* cam, float tm);
 
-// Draw a monster
-void monster_draw(MONSTER* m);
+// Draw monsters (adds them to the sprite batch)
+void monsters_draw(MONSTER_LIST* l);
 
 // Monster-to-goat collision
-void monster_goat_collision(MONSTER* m, GOAT* g);
+void monster_goat_collision(GAME_STATE* s, int i);
 
 // Monster-to-monster collision
-void monster_to_monster_collision(MONSTER* m1, MONSTER* m2);
+void monster_to_monster_collision(MONSTER_LIST* l, int i1, int i2);
 
 #endif // __MONSTER__
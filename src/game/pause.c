@@ -78,7 +78,7 @@ static void draw_pause_text(int x, int y, int yoff) {
         if(i == 3 && !audioState)
             text = AUDIO_TEXT_OFF;
 
-        draw_text( (cursor.moving || (cursor.pos != i)) ? bmpFont : bmpFont2, 
+        draw_text_cached( (cursor.moving || (cursor.pos != i)) ? bmpFont : bmpFont2, 
             text,x,y +yoff*i,-7,0,false);
     }
 }
@@ -0,0 +1,324 @@
+// GOAT
+// Rewind (source)
+// (c) 2018 Jani Nykänen
+
+#include "rewind.h"
+
+#include "savestate.h"
+
+#include "../include/std.h"
+
+// Shorter zero runs are kept inside literal runs
+#define MIN_ZERO_RUN 4
+// Longest run in a group (16-bit lengths)
+#define MAX_RUN 0xFFFF
+
+// Worst case size of an encoded frame
+#define MAX_ENCODED_SIZE (SAVESTATE_DATA_SIZE * 3 + 4)
+
+// Any frame must fit in the buffer
+_Static_assert(MAX_ENCODED_SIZE <= REWIND_BUFFER_SIZE,
+    "REWIND_BUFFER_SIZE is too small for the savestate");
+
+// Recorded frame
+typedef struct {
+
+    int offset; // Position in the byte buffer
+    int length;
+    bool keyframe;
+}
+REWIND_FRAME;
+
+// Frames, a ring. The oldest frame is always a keyframe
+static REWIND_FRAME frames[REWIND_FRAME_COUNT];
+static int first;
+static int count;
+
+// Compressed frames
+static Uint8 buffer[REWIND_BUFFER_SIZE];
+// Write position
+static int head;
+
+// Latest keyframe, the base of the deltas
+static Uint8 keyframe[SAVESTATE_DATA_SIZE];
+// Frames since the latest keyframe, -1 if a keyframe
+// is needed
+static int sinceKey = -1;
+
+// Scratch buffers
+static SAVESTATE current;
+static Uint8 encoded[MAX_ENCODED_SIZE];
+
+// Decoded keyframe cache, for stepping back without
+// decoding the keyframe every time
+static Uint8 cachedKey[SAVESTATE_DATA_SIZE];
+static int cachedKeyOffset = -1;
+
+
+// Encode the XOR of two buffers. The delta is stored as
+// (zero run, literal run, literals) groups, run lengths
+// being 16-bit. Longer runs are split into several
+// groups. Returns the length
+static int encode(const Uint8* data, const Uint8* base, Uint8* out) {
+
+    const int SIZE = (int)SAVESTATE_DATA_SIZE;
+
+    int len = 0;
+    int i = 0;
+    int start, lit, zeroes, j;
+
+    while(i < SIZE) {
+
+        // Zero run
+        start = i;
+        while(i < SIZE && data[i] == (base != NULL ? base[i] : 0))
+            ++ i;
+        zeroes = i - start;
+
+        // Zero runs that do not fit in one group
+        while(zeroes > MAX_RUN) {
+
+            out[len ++] = (Uint8)(MAX_RUN & 0xFF);
+            out[len ++] = (Uint8)(MAX_RUN >> 8);
+            out[len ++] = 0;
+            out[len ++] = 0;
+            zeroes -= MAX_RUN;
+        }
+
+        // Literal run, until a long enough zero run. The
+        // rest of a longer one goes to the next group
+        start = i;
+        j = i;
+        while(j < SIZE && j - start < MAX_RUN) {
+
+            if(data[j] == (base != NULL ? base[j] : 0)) {
+
+                // Count zeroes ahead
+                lit = j;
+                while(lit < SIZE && lit - j < MIN_ZERO_RUN 
+                    && data[lit] == (base != NULL ? base[lit] : 0))
+                    ++ lit;
+
+                if(lit - j >= MIN_ZERO_RUN || lit == SIZE)
+                    break;
+
+                j = lit;
+            }
+            else {
+
+                ++ j;
+            }
+        }
+        if(j - start > MAX_RUN)
+            j = start + MAX_RUN;
+        lit = j - start;
+
+        out[len ++] = (Uint8)(zeroes & 0xFF);
+        out[len ++] = (Uint8)(zeroes >> 8);
+        out[len ++] = (Uint8)(lit & 0xFF);
+        out[len ++] = (Uint8)(lit >> 8);
+        for(j = 0; j < lit; ++ j) {
+
+            out[len ++] = data[start+j] ^ (base != NULL ? base[start+j] : 0);
+        }
+
+        i = start + lit;
+    }
+
+    return len;
+}
+
+
+// Decode a delta, XORing it onto the output
+static void decode(const Uint8* in, int len, Uint8* out) {
+
+    int p = 0;
+    int pos = 0;
+    int lit, j;
+
+    while(p < len) {
+
+        pos += in[p] | (in[p+1] << 8);
+        lit = in[p+2] | (in[p+3] << 8);
+        p += 4;
+
+        for(j = 0; j < lit; ++ j) {
+
+            out[pos+j] ^= in[p+j];
+        }
+        pos += lit;
+        p += lit;
+    }
+}
+
+
+// Drop the oldest frame, and the deltas that
+// depended on it
+static void drop_oldest() {
+
+    do {
+
+        if(frames[first].offset == cachedKeyOffset)
+            cachedKeyOffset = -1;
+
+        first = (first+1) % REWIND_FRAME_COUNT;
+        -- count;
+    }
+    while(count > 0 && !frames[first].keyframe);
+
+    if(count == 0)
+        head = 0;
+}
+
+
+// Find room for a frame in the buffer, dropping old
+// frames if needed. Returns the position, or -1 if
+// the keyframe of a delta had to be dropped
+static int make_room(int len, bool key) {
+
+    int tail;
+
+    if(count == REWIND_FRAME_COUNT)
+        drop_oldest();
+
+    while(count > 0) {
+
+        tail = frames[first].offset;
+        if(head >= tail) {
+
+            // Used: [tail, head)
+            if(head + len <= REWIND_BUFFER_SIZE)
+                return head;
+            if(len < tail)
+                return 0;
+        }
+        else {
+
+            // Used: [tail, end) and [0, head)
+            if(head + len < tail)
+                return head;
+        }
+
+        drop_oldest();
+    }
+
+    // A delta without its keyframe is useless
+    if(!key)
+        return -1;
+
+    return 0;
+}
+
+
+// Forget all the recorded frames
+void rewind_clear() {
+
+    first = 0;
+    count = 0;
+    head = 0;
+    sinceKey = -1;
+    cachedKeyOffset = -1;
+}
+
+
+// Record a frame
+void rewind_record(GAME_STATE* s) {
+
+    savestate_capture(&current, s);
+
+    if(sinceKey >= REWIND_KEYFRAME_INTERVAL-1)
+        sinceKey = -1;
+
+    bool key = sinceKey == -1;
+    int len = encode(current.data, key ? NULL : keyframe, encoded);
+
+    int pos = make_room(len, key);
+    if(pos == -1) {
+
+        // The keyframe was dropped, start over
+        key = true;
+        len = encode(current.data, NULL, encoded);
+        pos = make_room(len, key);
+    }
+
+    memcpy(buffer + pos, encoded, len);
+    head = pos + len;
+
+    frames[(first + count) % REWIND_FRAME_COUNT] = (REWIND_FRAME){pos, len, key};
+    ++ count;
+
+    if(key) {
+
+        memcpy(keyframe, current.data, SAVESTATE_DATA_SIZE);
+        sinceKey = 0;
+    }
+    else {
+
+        ++ sinceKey;
+    }
+}
+
+
+// Step one frame back
+bool rewind_step(GAME_STATE* s) {
+
+    if(count == 0) return false;
+
+    int last = (first + count-1) % REWIND_FRAME_COUNT;
+    REWIND_FRAME* f = &frames[last];
+
+    // Find the keyframe of the frame
+    int k = last;
+    while(!frames[k].keyframe)
+        k = (k + REWIND_FRAME_COUNT-1) % REWIND_FRAME_COUNT;
+
+    // Decode the keyframe, unless cached
+    if(cachedKeyOffset != frames[k].offset) {
+
+        memset(cachedKey, 0, SAVESTATE_DATA_SIZE);
+        decode(buffer + frames[k].offset, frames[k].length, cachedKey);
+        cachedKeyOffset = frames[k].offset;
+    }
+
+    memcpy(current.data, cachedKey, SAVESTATE_DATA_SIZE);
+    if(!f->keyframe)
+        decode(buffer + f->offset, f->length, current.data);
+
+    // The header is valid, a frame has been recorded
+    savestate_restore(&current, s);
+
+    // Remove the frame
+    head = f->offset;
+    -- count;
+    if(count == 0)
+        head = 0;
+
+    // The keyframe is gone, or the state differs from
+    // what the latest deltas were based on
+    if(f->keyframe)
+        cachedKeyOffset = -1;
+    sinceKey = -1;
+
+    return true;
+}
+
+
+// Get the recorded frame count
+int rewind_get_frame_count() {
+
+    return count;
+}
+
+
+// Get the bytes used by the recorded frames
+int rewind_get_bytes_used() {
+
+    int bytes = 0;
+    int i = 0;
+    for(; i < count; ++ i) {
+
+        bytes += frames[(first + i) % REWIND_FRAME_COUNT].length;
+    }
+
+    return bytes;
+}
@@ -0,0 +1,38 @@
+// GOAT
+// Rewind (header)
+// (c) 2018 Jani Nykänen
+
+#ifndef __REWIND__
+#define __REWIND__
+
+#include "state.h"
+
+// Recorded frames, at most (20 seconds at 30 fps)
+#define REWIND_FRAME_COUNT 600
+
+// A full keyframe is stored every this many frames,
+// the others are deltas against the latest keyframe
+#define REWIND_KEYFRAME_INTERVAL 30
+
+// Byte buffer for the compressed frames. The oldest
+// frames are dropped when it is full. Must hold a few
+// uncompressed states
+#define REWIND_BUFFER_SIZE (2 * 1024 * 1024)
+
+// Forget all the recorded frames
+void rewind_clear();
+
+// Record a frame
+void rewind_record(GAME_STATE* s);
+
+// Step one frame back. The frame is removed from the
+// buffer. Returns false if there was nothing to rewind
+bool rewind_step(GAME_STATE* s);
+
+// Get the recorded frame count
+int rewind_get_frame_count();
+
+// Get the bytes used by the recorded frames
+int rewind_get_bytes_used();
+
+#endif // __REWIND__
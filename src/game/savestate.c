@@ -0,0 +1,115 @@
+// GOAT
+// Savestate (source)
+// (c) 2018 Jani Nykänen
+
+#include "savestate.h"
+
+#include "../engine/error.h"
+
+#include "../include/std.h"
+
+
+// Compute the checksum of the data (FNV-1a)
+static Uint32 checksum(SAVESTATE* ss) {
+
+    Uint32 h = 2166136261u;
+    size_t i = 0;
+    for(; i < SAVESTATE_DATA_SIZE; ++ i) {
+
+        h ^= ss->data[i];
+        h *= 16777619u;
+    }
+
+    return h;
+}
+
+
+// Is the header valid for this build
+static bool header_valid(SAVESTATE_HEADER* h) {
+
+    return h->magic == SAVESTATE_MAGIC 
+        && h->version == SAVESTATE_VERSION
+        && h->size == (Uint32)SAVESTATE_DATA_SIZE;
+}
+
+
+// Capture a game state
+void savestate_capture(SAVESTATE* ss, GAME_STATE* s) {
+
+    ss->header.magic = SAVESTATE_MAGIC;
+    ss->header.version = SAVESTATE_VERSION;
+    ss->header.size = (Uint32)SAVESTATE_DATA_SIZE;
+    ss->header.checksum = 0;
+
+    memcpy(ss->data, s, SAVESTATE_DATA_SIZE);
+}
+
+
+// Restore a game state
+int savestate_restore(SAVESTATE* ss, GAME_STATE* s) {
+
+    if(!header_valid(&ss->header)) {
+
+        error_throw("Savestate does not match the game version!", NULL);
+        return 1;
+    }
+
+    bool headless = s->headless;
+    memcpy(s, ss->data, SAVESTATE_DATA_SIZE);
+    s->headless = headless;
+
+    // The grid is not saved
+    spatial_init(&s->spatial);
+
+    return 0;
+}
+
+
+// Write a savestate to a file
+int savestate_write(SAVESTATE* ss, const char* path) {
+
+    FILE* f = fopen(path, "wb");
+    if(f == NULL) {
+
+        error_throw("Failed to create a file in ", path);
+        return 1;
+    }
+
+    ss->header.checksum = checksum(ss);
+    bool ok = fwrite(&ss->header, sizeof(SAVESTATE_HEADER), 1, f) == 1
+        && fwrite(ss->data, SAVESTATE_DATA_SIZE, 1, f) == 1;
+
+    if(fclose(f) != 0 || !ok) {
+
+        error_throw("Failed to write a savestate to ", path);
+        return 1;
+    }
+
+    return 0;
+}
+
+
+// Read a savestate from a file
+int savestate_read(SAVESTATE* ss, const char* path) {
+
+    FILE* f = fopen(path, "rb");
+    if(f == NULL) {
+
+        error_throw("Failed to open a file in ", path);
+        return 1;
+    }
+
+    bool ok = fread(&ss->header, sizeof(SAVESTATE_HEADER), 1, f) == 1
+        && header_valid(&ss->header)
+        && fread(ss->data, SAVESTATE_DATA_SIZE, 1, f) == 1
+        && ss->header.checksum == checksum(ss);
+    fclose(f);
+
+    if(!ok) {
+
+        error_throw("Invalid savestate in ", path);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,53 @@
+// GOAT
+// Savestate (header)
+// (c) 2018 Jani Nykänen
+
+#ifndef __SAVESTATE__
+#define __SAVESTATE__
+
+#include "state.h"
+
+#include <stddef.h>
+
+// Savestate magic ("GOAT") & version. Bump the version
+// whenever GAME_STATE changes
+#define SAVESTATE_MAGIC 0x54414F47
+#define SAVESTATE_VERSION 1
+
+// Saved bytes of a game state
+#define SAVESTATE_DATA_SIZE offsetof(GAME_STATE, spatial)
+
+// Savestate header
+typedef struct {
+
+    Uint32 magic;
+    Uint32 version;
+    Uint32 size;
+    Uint32 checksum; // Only set for files
+}
+SAVESTATE_HEADER;
+
+// Savestate. The game state is flat, so the data is
+// a straight copy of it
+typedef struct {
+
+    SAVESTATE_HEADER header;
+    Uint8 data[SAVESTATE_DATA_SIZE];
+}
+SAVESTATE;
+
+// Capture a game state
+void savestate_capture(SAVESTATE* ss, GAME_STATE* s);
+
+// Restore a game state. The headless flag of the
+// target is kept. Returns 1 if the savestate does not
+// match this build
+int savestate_restore(SAVESTATE* ss, GAME_STATE* s);
+
+// Write a savestate to a file
+int savestate_write(SAVESTATE* ss, const char* path);
+
+// Read a savestate from a file
+int savestate_read(SAVESTATE* ss, const char* path);
+
+#endif // __SAVESTATE__
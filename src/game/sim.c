@@ -0,0 +1,218 @@
+// GOAT
+// Headless simulation (source)
+// (c) 2018 Jani Nykänen
+
+#include "sim.h"
+
+#include "bot.h"
+
+#include "../engine/mathext.h"
+#include "../engine/error.h"
+
+#include "../lib/tinycthread.h"
+
+#include "../include/std.h"
+
+// Defaults for the command line
+static const Uint32 DEFAULT_MAX_FRAMES = 60 * 60 * 10;
+
+// Shared batch data
+typedef struct {
+
+    SIM_BATCH* batch;
+    SIM_RESULT* results;
+
+    mtx_t lock;
+    int nextRun;
+}
+SIM_JOB;
+
+
+// Let the bot play
+static void bot_policy(GAME_STATE* s, void* param) {
+
+    bot_think(s, &s->input);
+}
+
+
+// Get the next run of a job, -1 if none left
+static int next_run(SIM_JOB* job) {
+
+    int run = -1;
+
+    mtx_lock(&job->lock);
+    if(job->nextRun < job->batch->runCount)
+        run = job->nextRun ++;
+    mtx_unlock(&job->lock);
+
+    return run;
+}
+
+
+// Worker thread. Each worker owns one game state
+// and runs games until none are left
+static int worker_thread(void* arg) {
+
+    SIM_JOB* job = (SIM_JOB*)arg;
+    SIM_BATCH* b = job->batch;
+
+    GAME_STATE* s = (GAME_STATE*)malloc(sizeof(GAME_STATE));
+    if(s == NULL) return 1;
+    s->headless = true;
+
+    int run;
+    while((run = next_run(job)) != -1) {
+
+        sim_run(s, b->firstSeed + (Uint64)run, b->maxFrames, 
+            b->policy, b->param, &job->results[run]);
+    }
+
+    free(s);
+
+    return 0;
+}
+
+
+// Run a headless game
+void sim_run(GAME_STATE* s, Uint64 seed, Uint32 maxFrames, 
+    SIM_POLICY policy, void* param, SIM_RESULT* res) {
+
+    game_state_reset(s, seed);
+    while(s->frame < maxFrames && !status_is_game_over(&s->status)) {
+
+        if(policy != NULL)
+            policy(s, param);
+
+        game_state_update(s, 1.0f);
+    }
+
+    res->seed = seed;
+    res->score = s->status.score;
+    res->coins = s->status.coins;
+    res->frames = s->frame;
+    res->speedUps = s->upCounter;
+    res->gameOver = status_is_game_over(&s->status);
+}
+
+
+// Run a batch of headless games
+int sim_run_batch(SIM_BATCH* b, SIM_RESULT* results) {
+
+    thrd_t threads[SIM_MAX_THREADS];
+    SIM_JOB job;
+    int count = b->threads;
+    int i;
+    int ret = 0;
+
+    if(count <= 0)
+        count = SDL_GetCPUCount();
+    count = max_2(1, min_2(count, min_2(SIM_MAX_THREADS, b->runCount)));
+
+    // The lookup tables must exist before the
+    // threads start
+    init_sine_table();
+
+    job.batch = b;
+    job.results = results;
+    job.nextRun = 0;
+    if(mtx_init(&job.lock, mtx_plain) != thrd_success) {
+
+        error_throw("Failed to create a batch lock!", NULL);
+        return 1;
+    }
+
+    // Start the workers
+    for(i = 0; i < count; ++ i) {
+
+        if(thrd_create(&threads[i], worker_thread, &job) != thrd_success) {
+
+            // Work with what we have
+            count = i;
+            break;
+        }
+    }
+
+    // No threads, work on this one
+    if(count == 0 && worker_thread(&job) != 0) {
+
+        error_mem_alloc();
+        ret = 1;
+    }
+
+    // Wait for the workers
+    int res;
+    for(i = 0; i < count; ++ i) {
+
+        thrd_join(threads[i], &res);
+        if(res != 0) {
+
+            error_mem_alloc();
+            ret = 1;
+        }
+    }
+
+    mtx_destroy(&job.lock);
+
+    return ret;
+}
+
+
+// Run a batch from the command line
+int sim_main(int argc, char** argv) {
+
+    SIM_BATCH b;
+    b.runCount = argc > 2 ? (int)strtol(argv[2], NULL, 10) : 0;
+    b.firstSeed = argc > 3 ? (Uint64)strtoull(argv[3], NULL, 10) : 1;
+    b.maxFrames = argc > 4 ? (Uint32)strtoul(argv[4], NULL, 10) : DEFAULT_MAX_FRAMES;
+    b.threads = argc > 5 ? (int)strtol(argv[5], NULL, 10) : 0;
+    b.policy = argc > 6 && strtol(argv[6], NULL, 10) != 0 ? bot_policy : NULL;
+    b.param = NULL;
+
+    if(b.runCount <= 0) {
+
+        printf("Usage: %s --batch <runs> [first seed] [max frames] [threads] [bot]\n", argv[0]);
+        return 1;
+    }
+
+    SIM_RESULT* results = (SIM_RESULT*)malloc(sizeof(SIM_RESULT) * b.runCount);
+    if(results == NULL) {
+
+        printf("Error: Memory allocation error!\n");
+        return 1;
+    }
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    if(sim_run_batch(&b, results) == 1) {
+
+        printf("Error: %s\n", error_get_message());
+        free(results);
+        return 1;
+    }
+    double secs = (double)(SDL_GetPerformanceCounter() - start) 
+        / (double)SDL_GetPerformanceFrequency();
+
+    // Print the results
+    printf("seed,score,coins,frames,ups,over\n");
+    double scoreSum = 0.0;
+    Uint64 frameSum = 0;
+    unsigned int best = 0;
+    int i = 0;
+    for(; i < b.runCount; ++ i) {
+
+        printf("%llu,%u,%d,%u,%d,%d\n", (unsigned long long)results[i].seed,
+            results[i].score, results[i].coins, results[i].frames, 
+            results[i].speedUps, results[i].gameOver ? 1 : 0);
+
+        scoreSum += results[i].score;
+        frameSum += results[i].frames;
+        if(results[i].score > best)
+            best = results[i].score;
+    }
+    printf("# %d runs, %llu frames in %.2f s, mean score %.1f, best %u\n",
+        b.runCount, (unsigned long long)frameSum, secs, 
+        scoreSum / b.runCount, best);
+
+    free(results);
+
+    return 0;
+}
@@ -0,0 +1,54 @@
+// GOAT
+// Headless simulation (header)
+// (c) 2018 Jani Nykänen
+
+#ifndef __SIM__
+#define __SIM__
+
+#include "state.h"
+
+// Max worker threads
+#define SIM_MAX_THREADS 64
+
+// Input policy. Fills s->input before each step
+typedef void (*SIM_POLICY) (GAME_STATE* s, void* param);
+
+// Result of a run
+typedef struct {
+
+    Uint64 seed;
+    unsigned int score;
+    int coins;
+    Uint32 frames;
+    int speedUps;
+    bool gameOver;
+}
+SIM_RESULT;
+
+// Batch settings
+typedef struct {
+
+    Uint64 firstSeed; // Run i uses the seed firstSeed+i
+    int runCount;
+    Uint32 maxFrames; // Frames per run, at most
+    int threads; // 0 means "one thread per CPU"
+
+    SIM_POLICY policy; // NULL means "no input"
+    void* param;
+}
+SIM_BATCH;
+
+// Run a headless game until it is over, or maxFrames
+// have been simulated
+void sim_run(GAME_STATE* s, Uint64 seed, Uint32 maxFrames, 
+    SIM_POLICY policy, void* param, SIM_RESULT* res);
+
+// Run a batch of headless games on a thread pool.
+// Results are stored in run order. Returns 1 on error
+int sim_run_batch(SIM_BATCH* b, SIM_RESULT* results);
+
+// Run a batch from the command line:
+// --batch <runs> [first seed] [max frames] [threads] [bot]
+int sim_main(int argc, char** argv);
+
+#endif // __SIM__
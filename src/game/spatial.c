@@ -0,0 +1,107 @@
+// GOAT
+// Spatial hash (source)
+// (c) 2018 Jani Nykänen
+
+#include "spatial.h"
+
+#include "../include/std.h"
+
+
+
+// Get a cell coordinate
+static int get_cell(float p) {
+
+    return (int)floorf(p / SPATIAL_CELL_SIZE);
+}
+
+
+// Hash a cell
+static int hash_cell(int cx, int cy) {
+
+    Uint32 h = ((Uint32)cx * 73856093u) ^ ((Uint32)cy * 19349663u);
+    return (int)(h & (SPATIAL_BUCKET_COUNT-1));
+}
+
+
+// Initialize a grid
+void spatial_init(SPATIAL* sp) {
+
+    int i = 0;
+    for(; i < SPATIAL_BUCKET_COUNT; ++ i)
+        sp->buckets[i] = -1;
+
+    sp->entryCount = 0;
+}
+
+
+// Clear the grid
+void spatial_clear(SPATIAL* sp) {
+
+    // Only the used buckets need to be cleared
+    int i = 0;
+    for(; i < sp->entryCount; ++ i)
+        sp->buckets[hash_cell(sp->entries[i].cx, sp->entries[i].cy)] = -1;
+
+    sp->entryCount = 0;
+}
+
+
+// Add an object to the grid
+void spatial_add(SPATIAL* sp, int index, VEC2 pos) {
+
+    if(sp->entryCount >= SPATIAL_MAX_OBJECTS) return;
+
+    SPATIAL_ENTRY* e = &sp->entries[sp->entryCount];
+    e->index = index;
+    e->cx = get_cell(pos.x);
+    e->cy = get_cell(pos.y);
+    e->pos = pos;
+
+    int b = hash_cell(e->cx, e->cy);
+    e->next = sp->buckets[b];
+    sp->buckets[b] = sp->entryCount;
+
+    ++ sp->entryCount;
+}
+
+
+// Find the objects in an area
+int spatial_query(SPATIAL* sp, VEC2 pos, float rx, float ry, int* out, int max) {
+
+    int cx0 = get_cell(pos.x - rx);
+    int cx1 = get_cell(pos.x + rx);
+    int cy0 = get_cell(pos.y - ry);
+    int cy1 = get_cell(pos.y + ry);
+
+    int count = 0;
+    int cx, cy, i, j, v;
+    SPATIAL_ENTRY* e;
+
+    for(cy = cy0; cy <= cy1; ++ cy) {
+
+        for(cx = cx0; cx <= cx1; ++ cx) {
+
+            for(i = sp->buckets[hash_cell(cx, cy)]; i != -1; i = e->next) {
+
+                e = &sp->entries[i];
+
+                // Other cells may share the bucket
+                if(e->cx != cx || e->cy != cy)
+                    continue;
+
+                if(fabsf(e->pos.x - pos.x) > rx || fabsf(e->pos.y - pos.y) > ry
+                 || count >= max)
+                    continue;
+
+                // Keep the indices sorted
+                v = e->index;
+                for(j = count; j > 0 && out[j-1] > v; -- j)
+                    out[j] = out[j-1];
+                out[j] = v;
+                ++ count;
+            }
+        }
+    }
+
+    return count;
+}
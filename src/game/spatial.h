@@ -0,0 +1,55 @@
+// GOAT
+// Spatial hash (header)
+// (c) 2018 Jani Nykänen
+
+#ifndef __SPATIAL__
+#define __SPATIAL__
+
+#include "../engine/vector.h"
+
+#include "monster.h"
+
+// Max objects in the grid
+#define SPATIAL_MAX_OBJECTS MONSTER_COUNT
+
+// Cell size in pixels
+#define SPATIAL_CELL_SIZE 32
+
+// Bucket count (power of two)
+#define SPATIAL_BUCKET_COUNT 1024
+
+// Grid entry
+typedef struct {
+
+    int index;
+    int cx;
+    int cy;
+    VEC2 pos;
+    int next;
+}
+SPATIAL_ENTRY;
+
+// Spatial hash grid
+typedef struct {
+
+    int buckets[SPATIAL_BUCKET_COUNT]; // Bucket heads, -1 if empty
+    SPATIAL_ENTRY entries[SPATIAL_MAX_OBJECTS];
+    int entryCount;
+}
+SPATIAL;
+
+// Initialize a grid
+void spatial_init(SPATIAL* sp);
+
+// Clear the grid
+void spatial_clear(SPATIAL* sp);
+
+// Add an object to the grid
+void spatial_add(SPATIAL* sp, int index, VEC2 pos);
+
+// Find the objects in the area [pos-r, pos+r]. Stores
+// their indices to out in ascending order, returns
+// the count
+int spatial_query(SPATIAL* sp, VEC2 pos, float rx, float ry, int* out, int max);
+
+#endif // __SPATIAL__
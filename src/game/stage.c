@@ -4,19 +4,18 @@
 
 #include "stage.h"
 
-#include "camera.h"
-#include "game.h"
-#include "status.h"
+#include "state.h"
 
 #include "../include/renderer.h"
 #include "../include/std.h"
 #include "../include/utility.h"
 
 // Constants
-#define PLATFORM_COUNT 5
-#define TILE_COUNT 16
 static const float CLOUD_SPEED = 0.5f;
 static const float PLATFORM_INTERVAL = 64.0f;
+// Objects further than this from a platform vertically
+// cannot collide with it
+static const float COLLISION_MARGIN = 16.0f;
 
 // Bitmaps
 static _BITMAP* bmpSky;
@@ -24,31 +23,63 @@ static _BITMAP* bmpClouds;
 static _BITMAP* bmpMountains;
 static _BITMAP* bmpPlatforms;
 
-// Cloud position
+// Cloud position. Only for the looks, so it is
+// shared by all the game instances
 static float cloudPos;
 
-// Platform type
-typedef struct {
 
-    float y;
-    int tiles[TILE_COUNT];
-    int decorations[TILE_COUNT];
-    int flip[TILE_COUNT]; // Decoration flips
-    bool exist;
-    bool scored;
+// Compute the merged solid runs of a platform
+static void compute_runs(PLATFORM* p) {
+
+    int i = 0;
+    p->runCount = 0;
+    for(; i < TILE_COUNT; ++ i) {
+
+        if(p->tiles[i] == 0) {
+
+            p->tileRun[i] = -1;
+            continue;
+        }
+
+        // Start a new run
+        if(i == 0 || p->tiles[i-1] == 0) {
+
+            p->runStart[p->runCount] = i;
+            p->runLength[p->runCount] = 0;
+            ++ p->runCount;
+        }
+
+        ++ p->runLength[p->runCount-1];
+        p->tileRun[i] = p->runCount-1;
+    }
 }
-PLATFORM;
 
-// Platforms
-static PLATFORM platforms[PLATFORM_COUNT];
-// Platform timer
-static float platTimer;
+
+// Get the solid runs touching the tile at x or its
+// neighbours, in ascending order. Returns the count
+static int get_runs_near(PLATFORM* p, float x, int* out) {
+
+    int t = (int)floorf(x / 16.0f);
+    int count = 0;
+    int i, r;
+
+    for(i = t-1; i <= t+1; ++ i) {
+
+        if(i < 0 || i >= TILE_COUNT) continue;
+
+        r = p->tileRun[i];
+        if(r != -1 && (count == 0 || out[count-1] != r))
+            out[count ++] = r;
+    }
+
+    return count;
+}
 
 
 // Create the first platform
-static void create_first_platform() {
+static void create_first_platform(STAGE* st) {
 
-    PLATFORM* p = &platforms[0];
+    PLATFORM* p = &st->platforms[0];
     int i = 0;
     for(; i < TILE_COUNT; ++ i) {
 
@@ -58,38 +89,41 @@ static void create_first_platform() {
     p->y = 192 +48;
     p->exist = true;
     p->scored = true;
+
+    compute_runs(p);
 }
 
 
 // Add gems to a platform
-static void add_gems_to_platform(float y) {
+static void add_gems_to_platform(GAME_STATE* s, float y) {
 
     const int MAX_GEM = 4;
 
     int i = 0;
-    float camY = floorf(get_global_camera()->pos.y);
+    float camY = floorf(s->cam.pos.y);
 
     // How many
-    int count = rand() % MAX_GEM;
+    int count = rng_range(&s->stage.rng, MAX_GEM);
     if(count > 0) {
 
         // Position
-        int pos = rand() % (10 - count-1);
+        int pos = rng_range(&s->stage.rng, 10 - count-1);
         for(i = 0; i < count; ++ i, ++ pos) {
 
             // Add a gem
-            add_gem(8.0f + pos*24.0f + 12.0f,camY + y- 24.0f);
+            gem_add(&s->gems, vec2(8.0f + pos*24.0f + 12.0f,camY + y- 24.0f));
         }
     }
 }
 
 
 // Add a monster to a platform
-static void add_monster_to_platform(int sx, int leftx, int len, int y, bool ground) {
+static void add_monster_to_platform(GAME_STATE* s, int sx, int leftx, int len, int y, bool ground) {
 
+    RNG* rng = &s->stage.rng;
     int maxID = 2;
     int monsterProb = 4;
-    int upCount = get_speed_up_count();
+    int upCount = s->upCounter;
 
     if(upCount >= 1) {
 
@@ -111,13 +145,13 @@ static void add_monster_to_platform(int sx, int leftx, int len, int y, bool grou
     if(upCount >= 7)
         -- monsterProb;
 
-    if(rand() % monsterProb != 0) return;
+    if(rng_range(rng, monsterProb) != 0) return;
 
     bool groundType[] = {true, false, true, false, true};
     float yPositions[] = {0.0f, -14.0f, 0.0f, -14.0f, 0.0f};
 
     // Get random monster ID
-    int id = rand() % maxID;
+    int id = rng_range(rng, maxID);
 
     // If the enemy type is not suitable, get another one
     if(groundType[id] != ground) {
@@ -137,36 +171,37 @@ static void add_monster_to_platform(int sx, int leftx, int len, int y, bool grou
         }
     }
 
-    int x = sx + rand() % (len-1);
-    float ypos = floorf(get_global_camera()->pos.y) + (float)y + yPositions[id];
+    int x = sx + rng_range(rng, len-1);
+    float ypos = floorf(s->cam.pos.y) + (float)y + yPositions[id];
     float left = leftx*16.0f;
     float right = sx*16.0f + len*16.0f;
 
-    add_monster(x*16.0f +8.0f, ypos, left, right, id);
+    monster_add(&s->monsters, vec2(x*16.0f +8.0f, ypos), left, right, id);
 }
 
 
 // Add a fish
-static void add_fish_to_platform(int y) {
+static void add_fish_to_platform(GAME_STATE* s, int y) {
 
-    int upCount = get_speed_up_count();
+    RNG* rng = &s->stage.rng;
+    int upCount = s->upCounter;
     if(upCount < 2) return;
 
     int fishProb =  max_2(2, 8 - upCount);
     
-    if(rand() % fishProb != 0) return;
+    if(rng_range(rng, fishProb) != 0) return;
 
-    int dir = rand() % 2 == 0 ? 1 : -1;
+    int dir = rng_range(rng, 2) == 0 ? 1 : -1;
     float x = 128.0f - dir*128.0f;
-    float ypos = (float)y + floorf(get_global_camera()->pos.y) - 28.0f;
+    float ypos = (float)y + floorf(s->cam.pos.y) - 28.0f;
 
-    add_monster(x, ypos, 0, 256, 5);
+    monster_add(&s->monsters, vec2(x, ypos), 0, 256, MONSTER_FISH);
 
 }
 
 
 // Create a new platform
-static void create_platform() {
+static void create_platform(GAME_STATE* s) {
 
     const int MAX_HOLE_START = 4;
     const int MAX_HOLE_LENGTH = 5;
@@ -179,6 +214,10 @@ static void create_platform() {
     const int LOW_PROB = 3;
     const int SMALL_PROB = 2;
 
+    PLATFORM* platforms = s->stage.platforms;
+    RNG* rng = &s->stage.rng;
+    RNG* rngDecor = &s->stage.rngDecor;
+
     // Find the first platform that is not in the game
     int i = 0;
     for(; i < PLATFORM_COUNT; ++ i) {
@@ -195,11 +234,11 @@ static void create_platform() {
     for(i = 0; i < TILE_COUNT; ++ i) {
 
         platforms[p].decorations[i] = -1;
-        platforms[p].flip[i] = rand() % 2;
+        platforms[p].flip[i] = rng_range(rngDecor, 2);
     }
 
     // Add holes
-    int count = (rand() % 2 == 0) ? 1 : (rand() % MAX_HOLE_START +2);
+    int count = (rng_range(rng, 2) == 0) ? 1 : (rng_range(rng, MAX_HOLE_START) +2);
     bool isHole =false;
     int bridgeBuilt =0;
     int decorationPos = 0;
@@ -215,14 +254,14 @@ static void create_platform() {
 
             // Calculate hole/platform size
             if(isHole)
-                count = rand() % MAX_HOLE_LENGTH + 2;
+                count = rng_range(rng, MAX_HOLE_LENGTH) + 2;
             
             else {
 
                 if(bridgeBuilt != 1)
                     notHoleStart = i;
                 
-                count = rand() % MAX_GROUND_LENGTH + 1;
+                count = rng_range(rng, MAX_GROUND_LENGTH) + 1;
             }
             
             // If bridge ending, set bridge state to 2 
@@ -233,7 +272,7 @@ static void create_platform() {
             else {
 
                 if(count < MAX_GROUND_LENGTH && 
-                    isHole && bridgeBuilt == 0 && rand() % BRIDGE_PROB == 0) {
+                    isHole && bridgeBuilt == 0 && rng_range(rng, BRIDGE_PROB) == 0) {
 
                     bridgeBuilt = 1;
                 }
@@ -241,36 +280,36 @@ static void create_platform() {
 
             // Add monsters
             if(i < TILE_COUNT-2 && count >= 2)
-                add_monster_to_platform(i, notHoleStart, count, Y_POS, !isHole || bridgeBuilt == 1);
+                add_monster_to_platform(s, i, notHoleStart, count, Y_POS, !isHole || bridgeBuilt == 1);
 
             // Add decorations
             if(!isHole) {
 
                 // Add big element
-                if(count >= 4 && rand() % BIG_PROB == 0) {
+                if(count >= 4 && rng_range(rngDecor, BIG_PROB) == 0) {
 
-                    decorationPos = i + rand() % (count - 4 +2);
+                    decorationPos = i + rng_range(rngDecor, count - 4 +2);
                     if(decorationPos <= TILE_COUNT-4) {
     
-                        platforms[p].decorations[decorationPos] = 6 + rand() % 3;
+                        platforms[p].decorations[decorationPos] = 6 + rng_range(rngDecor, 3);
                         created = true;
                     }
                 }
                 else if(count >= 3) {
                     
-                    decorationPos = i + rand() % (count-3 +2);
+                    decorationPos = i + rng_range(rngDecor, count-3 +2);
                     if(decorationPos <= TILE_COUNT-3) {
 
                         // Or tall element
-                        if(rand() % TALL_PROB == 0) {
+                        if(rng_range(rngDecor, TALL_PROB) == 0) {
 
-                            platforms[p].decorations[decorationPos] = 3 + rand() % 3;
+                            platforms[p].decorations[decorationPos] = 3 + rng_range(rngDecor, 3);
                             created = true;
                         }
                         // Or low element
-                        else if(rand() % LOW_PROB == 0) {
+                        else if(rng_range(rngDecor, LOW_PROB) == 0) {
 
-                            platforms[p].decorations[decorationPos] = 9 + rand() % 3;
+                            platforms[p].decorations[decorationPos] = 9 + rng_range(rngDecor, 3);
                             created = true;
                         }
 
@@ -278,13 +317,13 @@ static void create_platform() {
 
                 }
                 // Or small element
-                if(!created && rand() % SMALL_PROB == 0) {
+                if(!created && rng_range(rngDecor, SMALL_PROB) == 0) {
 
-                    decorationPos = i + rand() % (count);
+                    decorationPos = i + rng_range(rngDecor, count);
                     if(decorationPos > TILE_COUNT-1)
                             decorationPos = TILE_COUNT-1;
 
-                    platforms[p].decorations[decorationPos] = rand() % 3;
+                    platforms[p].decorations[decorationPos] = rng_range(rngDecor, 3);
                 }
             }
         }
@@ -298,27 +337,29 @@ static void create_platform() {
     platforms[p].y = Y_POS;
     platforms[p].exist = true;
 
+    compute_runs(&platforms[p]);
+
     // Add gems
-    add_gems_to_platform(Y_POS);
+    add_gems_to_platform(s, Y_POS);
 
     // Maybe add a fish
-    add_fish_to_platform(Y_POS);
+    add_fish_to_platform(s, Y_POS);
 
 }
 
 
 // Update all platforms
-static void update_platforms(float globalSpeed, float tm) {
+static void update_platforms(STAGE* st, float globalSpeed, float tm) {
 
     int i = 0;
     PLATFORM* p;
     for(; i < PLATFORM_COUNT; ++ i) {
 
-        if(platforms[i].exist == false)
+        if(st->platforms[i].exist == false)
             continue;
 
         // Update platform
-        p = &platforms[i];
+        p = &st->platforms[i];
         p->y -= globalSpeed * tm;
         if(p->y < -16.0f) {
 
@@ -443,63 +484,82 @@ static void draw_platform(PLATFORM* p) {
 
 
 // Draw all platforms
-static void draw_platforms() {
+static void draw_platforms(STAGE* st) {
 
     int i = 0;
     for(; i < PLATFORM_COUNT; ++ i) {
 
-        if(platforms[i].exist == false)
+        if(st->platforms[i].exist == false)
             continue;
 
         // Draw platform
-        draw_platform(&platforms[i]);
+        draw_platform(&st->platforms[i]);
     }
 }
 
 
 // Goat-to-platform collision
 // TODO: Merge this and the following method
-static void goat_platform_collision(GOAT* g, PLATFORM* p) {
+static void goat_platform_collision(GAME_STATE* s, PLATFORM* p) {
 
     if(p->exist == false) return;
 
-    float camY = get_global_camera()->pos.y;
+    if(p->runCount == 0) return;
 
-    int i = 0;
-    for(; i < TILE_COUNT; ++ i) {
-
-        if(p->tiles[i] != 0) {
+    GOAT* g = &s->player;
+    float camY = s->cam.pos.y;
+    float y = p->y + camY;
 
-            goat_floor_collision(g, i*16,p->y + camY, 16);
+    if(fmaxf(g->oldY, g->pos.y) >= y - COLLISION_MARGIN 
+     && fminf(g->oldY, g->pos.y) <= y + COLLISION_MARGIN) {
 
-            // If below the platform and not scored, score
-            if(g->pos.y > p->y+camY+16 && !p->scored) {
+        int runs[3];
+        int count = get_runs_near(p, g->pos.x, runs);
+        int i = 0;
+        for(; i < count; ++ i) {
 
-                status_add_score();
-                p->scored = true;
-            }
+            goat_floor_collision(g, p->runStart[runs[i]]*16, y, p->runLength[runs[i]]*16);
         }
     }
+
+    // If below the platform and not scored, score
+    if(g->pos.y > y+16 && !p->scored) {
+
+        status_add_score(&s->status);
+        p->scored = true;
+    }
 }
 
 
 // Gem-to-platform collision
-static void gem_platform_collision(GEM* g, PLATFORM* p) {
+static void gem_platform_collision(GEM_LIST* l, int g, PLATFORM* p, float camY) {
 
     if(p->exist == false) return;
 
-    float camY = get_global_camera()->pos.y;
+    float y = p->y + camY;
 
-    int i = 0;
-    for(; i < TILE_COUNT; ++ i) {
+    if(fmaxf(l->oldY[g], l->y[g]) < y - COLLISION_MARGIN 
+     || fminf(l->oldY[g], l->y[g]) > y + COLLISION_MARGIN)
+        return;
 
-        if(p->tiles[i] != 0) {
+    int runs[3];
+    int count = get_runs_near(p, l->x[g], runs);
+    int i = 0;
+    for(; i < count; ++ i) {
 
-            gem_floor_collision(g, i*16,p->y + camY, 16);
-        }
+        gem_floor_collision(l, g, p->runStart[runs[i]]*16, y, p->runLength[runs[i]]*16);
     }
 }
 
+
+// Seed the stage random numbers
+void stage_seed(STAGE* st, Uint64 seed) {
+
+    rng_seed(&st->rng, seed, RNG_STREAM_STAGE);
+    rng_seed(&st->rngDecor, seed, RNG_STREAM_DECORATION);
+}
+
+
 // Initialize stage
 int stage_init(ASSET_PACK* ass) {
 
@@ -509,40 +569,34 @@ int stage_init(ASSET_PACK* ass) {
     bmpMountains = (_BITMAP*)assets_get(ass, "mountains");
     bmpPlatforms = (_BITMAP*)assets_get(ass, "platforms");
 
-    // Set seed
-    srand(time(NULL));
-
     cloudPos = 0.0f;
-    // Reset
-    stage_reset();
 
     return 0;
 }
 
 
 // Update stage
-void stage_update(float globalSpeed, float tm) {
+void stage_update(GAME_STATE* s, float tm) {
 
-    // Make the clouds move again
-    cloudPos -= CLOUD_SPEED * tm;
-    if(cloudPos <= -(float)bmpClouds->width) {
+    STAGE* st = &s->stage;
 
-        cloudPos += (int)bmpClouds->width;
-    }
+    // Make the clouds move again
+    if(!s->headless)
+        stage_update_bg_only(tm);
 
     // Create platforms (if not game over)
-    if(!status_is_game_over()) {
+    if(!status_is_game_over(&s->status)) {
         
-        platTimer += 1.0f * tm * globalSpeed;
-        if(platTimer >= PLATFORM_INTERVAL) {
+        st->platTimer += 1.0f * tm * s->globalSpeed;
+        if(st->platTimer >= PLATFORM_INTERVAL) {
 
-            platTimer -= PLATFORM_INTERVAL;
-            create_platform();
+            st->platTimer -= PLATFORM_INTERVAL;
+            create_platform(s);
         }
     }
 
     // Update platforms
-    update_platforms(globalSpeed, tm);
+    update_platforms(st, s->globalSpeed, tm);
 }
 
 
@@ -559,7 +613,7 @@ void stage_update_bg_only(float tm) {
 
 
 // Draw stage
-void stage_draw() {
+void stage_draw(STAGE* st) {
 
     int i = 0;
     int cpos = (int)round(cloudPos);
@@ -577,47 +631,48 @@ void stage_draw() {
     draw_bitmap(bmpMountains,0,192 -96, 0);
 
     // Draw platforms
-    draw_platforms();
+    draw_platforms(st);
 }
 
 
 // Stage-to-goat collision
 // TODO: Merge this and the following
-void stage_goat_collision(GOAT* g) {
+void stage_goat_collision(GAME_STATE* s) {
 
     int i = 0;
     for(; i < PLATFORM_COUNT; ++ i) {
 
-        goat_platform_collision(g, &platforms[i]);
+        goat_platform_collision(s, &s->stage.platforms[i]);
     }
 }
 
 
 // Stage-to-gem collision
-void stage_gem_collision(GEM* g) {
+void stage_gem_collision(GAME_STATE* s, int g) {
 
-    if(g->hasGravity == false) return;
+    GEM_LIST* l = &s->gems;
+    if(!l->exist[g] || !l->hasGravity[g]) return;
 
     int i = 0;
     for(; i < PLATFORM_COUNT; ++ i) {
 
-        gem_platform_collision(g, &platforms[i]);
+        gem_platform_collision(l, g, &s->stage.platforms[i], s->cam.pos.y);
     }
 }
 
 
 // Reset the stage
-void stage_reset() {
+void stage_reset(STAGE* st) {
 
     // Set default values
-    platTimer = 0.0f;
+    st->platTimer = 0.0f;
 
     int i = 0;
     for(; i < PLATFORM_COUNT; ++ i) {
 
-        platforms[i].exist = false;
+        st->platforms[i].exist = false;
     }
 
     // Create the first platform
-    create_first_platform();
+    create_first_platform(st);
 }
@@ -7,28 +7,70 @@
 
 #include "../include/system.h"
 
+#include "context.h"
 #include "goat.h"
 #include "gem.h"
 
+#include "../engine/rng.h"
+
+// Constants
+#define PLATFORM_COUNT 5
+#define TILE_COUNT 16
+
+// Platform type
+typedef struct {
+
+    float y;
+    int tiles[TILE_COUNT];
+    int decorations[TILE_COUNT];
+    int flip[TILE_COUNT]; // Decoration flips
+
+    // Merged solid runs, and the run of each tile
+    // (-1 if a hole)
+    int runStart[TILE_COUNT];
+    int runLength[TILE_COUNT];
+    int runCount;
+    int tileRun[TILE_COUNT];
+
+    bool exist;
+    bool scored;
+}
+PLATFORM;
+
+// Stage type
+typedef struct {
+
+    PLATFORM platforms[PLATFORM_COUNT];
+    float platTimer;
+
+    // Random numbers, layout & decorations
+    RNG rng;
+    RNG rngDecor;
+}
+STAGE;
+
 // Initialize stage
 int stage_init(ASSET_PACK* ass);
 
+// Seed the stage random numbers
+void stage_seed(STAGE* st, Uint64 seed);
+
 // Update stage
-void stage_update(float globalSpeed, float tm);
+void stage_update(GAME_STATE* s, float tm);
 
 // Update stage (bg only)
 void stage_update_bg_only(float tm);
 
 // Draw stage
-void stage_draw();
+void stage_draw(STAGE* st);
 
 // Stage-to-goat collision
-void stage_goat_collision(GOAT* g);
+void stage_goat_collision(GAME_STATE* s);
 
 // Stage-to-gem collision
-void stage_gem_collision(GEM* g);
+void stage_gem_collision(GAME_STATE* s, int g);
 
 // Reset the stage
-void stage_reset();
+void stage_reset(STAGE* st);
 
 #endif // __STAGE__
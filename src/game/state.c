@@ -0,0 +1,152 @@
+// GOAT
+// Game state (source)
+// (c) 2018 Jani Nykänen
+
+#include "state.h"
+
+#include "../include/std.h"
+#include "../include/audio.h"
+
+// Constants
+static const float INITIAL_GLOBAL_SPEED = 0.5f;
+static const float SPEED_UP_INTERVAL = 20.0f * 60.f;
+static const float SPEED_UP = 0.1f;
+static const int MAX_UP = SPEED_UP_MAX;
+// Monster collision area
+static const float MONSTER_COLLISION_X = 16.0f;
+static const float MONSTER_COLLISION_Y = 24.0f;
+
+
+// Monster-to-monster collisions. Only the monsters
+// near each other are tested
+static void monster_collisions(GAME_STATE* s) {
+
+    MONSTER_LIST* l = &s->monsters;
+    int near[MONSTER_COUNT];
+
+    int i, j, k, count;
+
+    // Fill the grid
+    spatial_clear(&s->spatial);
+    for(k = 0; k < l->activeCount; ++ k) {
+
+        i = l->active[k];
+        if(l->exist[i] && l->id[i] != MONSTER_FISH)
+            spatial_add(&s->spatial, i, vec2(l->x[i], l->y[i]));
+    }
+
+    // Test nearby pairs
+    for(k = 0; k < l->activeCount; ++ k) {
+
+        i = l->active[k];
+        if(!l->exist[i] || l->id[i] == MONSTER_FISH)
+            continue;
+
+        count = spatial_query(&s->spatial, vec2(l->x[i], l->y[i]), 
+            MONSTER_COLLISION_X, MONSTER_COLLISION_Y, near, MONSTER_COUNT);
+        for(j = 0; j < count; ++ j) {
+
+            if(near[j] == i) continue;
+            monster_to_monster_collision(l, i, near[j]);
+        }
+    }
+}
+
+
+// Update speed
+static void update_speed(GAME_STATE* s, float tm) {
+
+    if(s->upCounter >= MAX_UP) return;
+
+    s->speedCounter += 1.0f * tm;
+    if(s->speedCounter >= SPEED_UP_INTERVAL) {
+
+        s->speedCounter -= SPEED_UP_INTERVAL;
+        s->globalSpeed += SPEED_UP;
+
+        ++ s->upCounter;
+    }
+}
+
+
+// Reset a game state
+void game_state_reset(GAME_STATE* s, Uint64 seed) {
+
+    // Clear everything, so that two states with the
+    // same history are equal byte by byte
+    bool headless = s->headless;
+    memset(s, 0, sizeof(GAME_STATE));
+    s->headless = headless;
+    s->seed = seed;
+
+    // Set default values
+    s->globalSpeed = INITIAL_GLOBAL_SPEED;
+    s->cam = create_camera();
+
+    // (Re)create game objects
+    s->player = create_goat(vec2(128.0f,-4.0f));
+    gem_list_clear(&s->gems);
+    monster_list_clear(&s->monsters);
+    spatial_init(&s->spatial);
+
+    // Seed the random number streams
+    stage_seed(&s->stage, seed);
+    gems_seed(&s->gems, seed);
+    monsters_seed(&s->monsters, seed);
+
+    // Reset components
+    stage_reset(&s->stage);
+    reset_status(&s->status);
+}
+
+
+// Update a game state
+void game_state_update(GAME_STATE* s, float tm) {
+
+    int i = 0;
+    int k = 0;
+
+    // Update stage
+    stage_update(s, tm);
+
+    // Update player
+    goat_update(s, tm);
+    stage_goat_collision(s);
+
+    // Update gems
+    gems_update(&s->gems, &s->cam, tm);
+    for(k = 0; k < s->gems.activeCount; ++ k) {
+
+        i = s->gems.active[k];
+        gem_goat_collision(s, i);
+        stage_gem_collision(s, i);
+    }
+
+    // Update monsters
+    monsters_update(&s->monsters, &s->cam, tm);
+    for(k = 0; k < s->monsters.activeCount; ++ k) {
+
+        monster_goat_collision(s, s->monsters.active[k]);
+    }
+    monster_collisions(s);
+
+    // Update status
+    status_update(&s->status, tm);
+
+    // Move camera
+    move_camera(&s->cam, s->globalSpeed, tm);
+
+    // Update global speed
+    update_speed(s, tm);
+
+    ++ s->frame;
+}
+
+
+// Play a sample, unless the game is headless
+void game_state_play_sample(GAME_STATE* s, SAMPLE* smp, float vol) {
+
+    if(s->headless) return;
+
+    play_sample(smp, vol);
+}
@@ -0,0 +1,93 @@
+// GOAT
+// Game state (header)
+// (c) 2018 Jani Nykänen
+
+#ifndef __STATE__
+#define __STATE__
+
+#include "context.h"
+#include "camera.h"
+#include "stage.h"
+#include "goat.h"
+#include "gem.h"
+#include "monster.h"
+#include "status.h"
+#include "spatial.h"
+
+#include "../engine/rng.h"
+
+#include "../include/system.h"
+#include "../include/audio.h"
+
+// Speed-ups in a game
+#define SPEED_UP_MAX 10
+
+// Random number streams. Level generation has its own
+// stream, so cosmetic random calls do not change levels
+enum {
+
+    RNG_STREAM_STAGE = 1,
+    RNG_STREAM_DECORATION = 2,
+    RNG_STREAM_MONSTERS = 3,
+    RNG_STREAM_GEMS = 4,
+    RNG_STREAM_FX = 5,
+};
+
+// Game buttons
+enum {
+
+    GAME_BUTTON_JUMP = 0,
+    GAME_BUTTON_DASH = 1,
+
+    GAME_BUTTON_COUNT = 2,
+};
+
+// Input of a game instance
+typedef struct {
+
+    VEC2 stick;
+    int buttons[GAME_BUTTON_COUNT]; // STATE_UP, STATE_PRESSED...
+}
+GAME_INPUT;
+
+// Game state. Everything a running game needs, with
+// no pointers, so any number of games can be stepped
+// side by side
+struct _GAME_STATE {
+
+    Uint64 seed;
+    Uint32 frame;
+    bool headless; // No sounds & no background
+
+    // Global speed
+    float globalSpeed;
+    float speedCounter;
+    int upCounter;
+
+    // Input for the next step
+    GAME_INPUT input;
+
+    // Components
+    CAMERA cam;
+    STAGE stage;
+    GOAT player;
+    GEM_LIST gems;
+    MONSTER_LIST monsters;
+    STATUS status;
+
+    // Monster collision grid, rebuilt every step. Not
+    // a part of savestates, so it must stay the last
+    SPATIAL spatial;
+};
+
+// Reset a game state and seed it. The headless
+// flag is kept
+void game_state_reset(GAME_STATE* s, Uint64 seed);
+
+// Update a game state
+void game_state_update(GAME_STATE* s, float tm);
+
+// Play a sample, unless the game is headless
+void game_state_play_sample(GAME_STATE* s, SAMPLE* smp, float vol);
+
+#endif // __STATE__
@@ -15,45 +15,30 @@ static float HIDE_MAX = 30.0f;
 static float APPEAR_MAX = 60.0f;
 static float CONTROL_MAX = 180.0f;
 
-// Status variables
-static int health;
-static float healthFadeTimer;
-static int healthFade;
-static unsigned int score;
-static int coins;
-static bool isGameOver;
-
 // _BITMAP
 static _BITMAP* bmpHUD;
 static _BITMAP* bmpFont;
 static _BITMAP* bmpFontBig;
 static _BITMAP* bmpControls;
 
-// Hide timer
-static float hideTimer;
-// Appear timer
-static float appearTimer;
-// Control timer
-static float controlTimer;
-
 
 // Get score string
-static void get_score_string(char* buf, int bufLen) {
+static void get_score_string(STATUS* st, char* buf, int bufLen) {
 
     char zeroes[6];
 
     // Add zeroes
     int i = 4;
     int p = 0;
-    for(; score < (unsigned int)pow(10, i); -- i ) {
+    for(; st->score < (unsigned int)pow(10, i); -- i ) {
 
         zeroes[p ++] = '0';
     }
     zeroes[p] = '\0';
 
     // Create score string
-    if(score > 0)
-        snprintf(buf, bufLen, "%s%d", zeroes, score);
+    if(st->score > 0)
+        snprintf(buf, bufLen, "%s%d", zeroes, st->score);
 
     else
         snprintf(buf, bufLen, "%s", zeroes); 
@@ -68,60 +53,57 @@ void init_status(ASSET_PACK* ass) {
     bmpFont = (_BITMAP*)assets_get(ass, "font");
     bmpFontBig = (_BITMAP*)assets_get(ass, "fontBig");
     bmpControls = (_BITMAP*)assets_get(ass, "controls");
-
-    // (Re)set variables
-    reset_status();
 }
 
 
 // Reset status
-void reset_status() {
-
-    health = HEALTH_MAX;
-    healthFadeTimer = 0.0f;
-    healthFade = 0;
-    score = 0;
-    coins = 0;
-    isGameOver = false;
-    hideTimer = 0.0f;
-    appearTimer = 0.0f;
-    controlTimer = 0.0f;
+void reset_status(STATUS* st) {
+
+    st->health = HEALTH_MAX;
+    st->healthFadeTimer = 0.0f;
+    st->healthFade = 0;
+    st->score = 0;
+    st->coins = 0;
+    st->isGameOver = false;
+    st->hideTimer = 0.0f;
+    st->appearTimer = 0.0f;
+    st->controlTimer = 0.0f;
 }
 
 
 // Update status
-void status_update(float tm) {
+void status_update(STATUS* st, float tm) {
 
     // Update control timer
-    if(controlTimer < CONTROL_MAX) {
+    if(st->controlTimer < CONTROL_MAX) {
 
-        controlTimer += 1.0f * tm;
+        st->controlTimer += 1.0f * tm;
     }
 
     // Update fading health
-    if(healthFade != 0) {
+    if(st->healthFade != 0) {
 
-        healthFadeTimer -= 1.0f * tm;
-        if(healthFadeTimer <= 0.0f)
-            healthFade = 0;
+        st->healthFadeTimer -= 1.0f * tm;
+        if(st->healthFadeTimer <= 0.0f)
+            st->healthFade = 0;
     }
 
     // Update hide timer (if game over)
-    if(isGameOver && hideTimer < HIDE_MAX) {
+    if(st->isGameOver && st->hideTimer < HIDE_MAX) {
 
-        hideTimer += 1.0f * tm;
+        st->hideTimer += 1.0f * tm;
     }
 
     // Update appear timer
-    if(appearTimer < APPEAR_MAX) {
+    if(st->appearTimer < APPEAR_MAX) {
 
-        appearTimer += 1.0f * tm;
+        st->appearTimer += 1.0f * tm;
     }
 }
 
 
 // Draw status
-void status_draw() {
+void status_draw(STATUS* st) {
 
     const int HEART_X = 0;
     const int HEART_Y = 0;
@@ -137,11 +119,11 @@ void status_draw() {
     char str[16];
 
     // If game over & hiding
-    if(isGameOver) {
+    if(st->isGameOver) {
 
-        if(hideTimer < HIDE_MAX) {
+        if(st->hideTimer < HIDE_MAX) {
 
-            int p = -(int)floorf(hideTimer / HIDE_MAX * 32.0f);
+            int p = -(int)floorf(st->hideTimer / HIDE_MAX * 32.0f);
             translate(0, p);
         }
         else
@@ -149,13 +131,13 @@ void status_draw() {
     }
 
     // If appear timer
-    if(appearTimer < APPEAR_MAX) {
+    if(st->appearTimer < APPEAR_MAX) {
 
-        int p = -32.0 + (int)floorf(appearTimer / APPEAR_MAX * 32.0f);
+        int p = -32.0 + (int)floorf(st->appearTimer / APPEAR_MAX * 32.0f);
             translate(0, p);
     }
 
-    int hmax = healthFade == 2 ? health-2 : health-1;
+    int hmax = st->healthFade == 2 ? st->health-2 : st->health-1;
 
     // Draw hearts
     for(; i < HEALTH_MAX; ++ i) {
@@ -167,52 +149,52 @@ void status_draw() {
     }
 
     // Draw a fading heart
-    if(healthFade != 0) {
+    if(st->healthFade != 0) {
 
         int fade = 0;
-        if(healthFade == 1)
-            fade = 1 + (int)floorf(healthFadeTimer / HEALTH_FADE_MAX * FADE_COUNT);
+        if(st->healthFade == 1)
+            fade = 1 + (int)floorf(st->healthFadeTimer / HEALTH_FADE_MAX * FADE_COUNT);
 
         else
-            fade = 1 + FADE_COUNT - (int)floorf(healthFadeTimer / HEALTH_FADE_MAX * FADE_COUNT);
+            fade = 1 + FADE_COUNT - (int)floorf(st->healthFadeTimer / HEALTH_FADE_MAX * FADE_COUNT);
 
         sx = 24;
 
-        int hpos = healthFade == 1 ? health : health-1;
+        int hpos = st->healthFade == 1 ? st->health : st->health-1;
 
         draw_bitmap_region_fading(bmpHUD, sx,0,24,24, 
             HEART_X + HEART_DELTA*(hpos), HEART_Y, 0, fade, get_alpha() );
     }
 
     // Draw score
-    get_score_string(str, 16);
-    draw_text(bmpFont, " SCORE:", 128, SCORE_TEXT_Y, -6, 0, true);
-    draw_text(bmpFontBig, str, 128, SCORE_Y, -16, 0, true);
+    get_score_string(st, str, 16);
+    draw_text_cached(bmpFont, " SCORE:", 128, SCORE_TEXT_Y, -6, 0, true);
+    draw_text_cached(bmpFontBig, str, 128, SCORE_Y, -16, 0, true);
 
     // Draw coins
     int coinX;
-    if(coins < 10)
+    if(st->coins < 10)
         coinX = 256-48;
 
-    else if(coins < 100)
+    else if(st->coins < 100)
         coinX = 256-60;
 
     else
         coinX = 256-72;
 
-    snprintf(str, 16, "~%d", coins);
-    draw_text(bmpFontBig, str, coinX, COIN_TEXT_Y, -16, 0, false);
+    snprintf(str, 16, "~%d", st->coins);
+    draw_text_cached(bmpFontBig, str, coinX, COIN_TEXT_Y, -16, 0, false);
     draw_bitmap_region(bmpHUD,48,0,24,24, coinX -16, COIN_Y, 0);
 
     // Draw controls
-    if(controlTimer < CONTROL_MAX) {
+    if(st->controlTimer < CONTROL_MAX) {
 
         translate(0, 0);
 
         int x = 0;
-        if(controlTimer >= CONTROL_MAX -30.0f) {
+        if(st->controlTimer >= CONTROL_MAX -30.0f) {
 
-            x = -(int)floorf( (controlTimer-(CONTROL_MAX-30.0f)) / 30.0f * 72.0f);
+            x = -(int)floorf( (st->controlTimer-(CONTROL_MAX-30.0f)) / 30.0f * 72.0f);
         }
         draw_bitmap(bmpControls, x, 0, 0);
     }
@@ -221,63 +203,63 @@ void status_draw() {
 
 
 // Reduce health
-void status_reduce_health() {
+void status_reduce_health(STATUS* st) {
 
-    if(health <= 0) return;
+    if(st->health <= 0) return;
 
-    if(-- health == 0) {
+    if(-- st->health == 0) {
 
-        isGameOver = true;
+        st->isGameOver = true;
         return;
     }
     
-    healthFadeTimer = HEALTH_FADE_MAX;
-    healthFade = 1;
+    st->healthFadeTimer = HEALTH_FADE_MAX;
+    st->healthFade = 1;
 
 }
 
 
 // Add health
-void status_add_health() {
+void status_add_health(STATUS* st) {
 
-    if(health == HEALTH_MAX) return;
+    if(st->health == HEALTH_MAX) return;
 
-    health ++;
-    healthFadeTimer = HEALTH_FADE_MAX;
-    healthFade = 2;
+    st->health ++;
+    st->healthFadeTimer = HEALTH_FADE_MAX;
+    st->healthFade = 2;
 }
 
 
 // Add a coin
-void status_add_coin() {
+void status_add_coin(STATUS* st) {
 
-    ++ coins;
+    ++ st->coins;
 }
 
 
 // Add score
-void status_add_score() {
+void status_add_score(STATUS* st) {
 
-    score += SCORE_BASE + coins;
+    st->score += SCORE_BASE + st->coins;
 }
 
 
 // Is the game over
-bool status_is_game_over() {
+bool status_is_game_over(STATUS* st) {
 
-    return isGameOver;
+    return st->isGameOver;
 }
 
 
 // Get score string
-void status_get_score_string(char* buf, int len) {
+void status_get_score_string(STATUS* st, char* buf, int len) {
 
-    snprintf(buf, len, "SCORE: %d", (int)score);
+    snprintf(buf, len, "SCORE: %d", (int)st->score);
 }
 
 
 // Get score
-unsigned int status_get_score() {
+unsigned int status_get_score(STATUS* st) {
 
-    return score;
+    return st->score;
 }
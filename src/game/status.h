@@ -7,37 +7,56 @@
 
 #include "../include/system.h"
 
+// Status type
+typedef struct {
+
+    int health;
+    float healthFadeTimer;
+    int healthFade;
+    unsigned int score;
+    int coins;
+    bool isGameOver;
+
+    // Hide timer
+    float hideTimer;
+    // Appear timer
+    float appearTimer;
+    // Control timer
+    float controlTimer;
+}
+STATUS;
+
 // Initialize status
 void init_status(ASSET_PACK* ass);
 
 // Reset status
-void reset_status();
+void reset_status(STATUS* st);
 
 // Update status
-void status_update(float tm);
+void status_update(STATUS* st, float tm);
 
 // Draw status
-void status_draw();
+void status_draw(STATUS* st);
 
 // Reduce health
-void status_reduce_health();
+void status_reduce_health(STATUS* st);
 
 // Add health
-void status_add_health();
+void status_add_health(STATUS* st);
 
 // Add a coin
-void status_add_coin();
+void status_add_coin(STATUS* st);
 
 // Add score
-void status_add_score();
+void status_add_score(STATUS* st);
 
 // Is the game over
-bool status_is_game_over();
+bool status_is_game_over(STATUS* st);
 
 // Get score string
-void status_get_score_string(char* buf, int len);
+void status_get_score_string(STATUS* st, char* buf, int len);
 
 // Get score
-unsigned int status_get_score();
+unsigned int status_get_score(STATUS* st);
 
 #endif // __STATUS__
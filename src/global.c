@@ -7,6 +7,8 @@
 #include "vpad.h"
 #include "cursor.h"
 
+#include "leaderboard/queue.h"
+
 #include "include/std.h"
 #include "include/renderer.h"
 #include "include/system.h"
@@ -68,6 +70,14 @@ static int global_init() {
     set_global_music_volume(c.musicVol);
     set_global_sample_volume(c.sampleVol);
 
+    // Menu sounds are never dropped
+    const char* MENU_SAMPLES[] = {"accept", "select", "reject", "pause"};
+    int i = 0;
+    for(; i < 4; ++ i) {
+
+        set_sample_voices((SAMPLE*)assets_get(globalAssets, MENU_SAMPLES[i]), 3, 1);
+    }
+
     return 0;
 }
 
@@ -78,6 +88,9 @@ static void global_update(float tm) {
     // Update virtual gamepad
     vpad_update();
 
+    // Send the queued scores
+    lb_queue_update();
+
     // Update fading
     if(fadeMode != 0) {
 
@@ -118,7 +131,7 @@ static void global_draw() {
             dvalue = (int)((1.0f-fadeTimer/FADE_MAX) * 14.0f);
         }
 
-        darken(dvalue);
+        set_palette_darkness(dvalue);
     }
 }
 
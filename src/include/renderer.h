@@ -7,3 +7,5 @@
 #include "../engine/frame.h"
 #include "../engine/bitmap.h"
 #include "../engine/sprite.h"
+#include "../engine/textcache.h"
+#include "../engine/batch.h"
@@ -0,0 +1,265 @@
+// GOAT
+// Leaderboard client bench (source)
+// (c) 2018 Jani Nykänen
+
+#include "bench.h"
+
+#include "leaderboard.h"
+
+#include "../engine/error.h"
+
+#include "../include/std.h"
+#include "../include/system.h"
+
+// Max timed requests
+#define MAX_REQUESTS 10000
+// Address buffer size
+#define ADDR_BUFFER_SIZE 256
+
+// Defaults for the command line
+static const int DEFAULT_REQUESTS = 100;
+
+// Actions
+enum {
+
+    ACTION_GET = 0,
+    ACTION_SET = 1,
+    ACTION_SETMANY = 2,
+    ACTION_REFRESH = 3,
+    ACTION_BUSY = 4,
+};
+
+// Scenario
+typedef struct {
+
+    const char* name;
+    const char* path; // Picks the fault mode of the server
+    int action;
+    int expected;
+    int rows; // Expected entries, -1 if any
+    bool timed; // Repeated for the latency
+}
+SCENARIO;
+
+// Scenarios
+static const SCENARIO SCENARIOS[] = {
+
+    {"get", "", ACTION_GET, LB_REQUEST_DONE, -1, true},
+    {"set", "", ACTION_SET, LB_REQUEST_DONE, -1, true},
+    {"setmany", "", ACTION_SETMANY, LB_REQUEST_DONE, -1, true},
+    {"refresh", "", ACTION_REFRESH, LB_REQUEST_NOT_MODIFIED, -1, true},
+    {"busy", "", ACTION_BUSY, LB_REQUEST_DONE, -1, false},
+    {"slow", "/slow", ACTION_GET, LB_REQUEST_DONE, -1, false},
+    {"truncate", "/truncate", ACTION_GET, LB_REQUEST_FAILED, -1, false},
+    {"oversize", "/oversize", ACTION_GET, LB_REQUEST_DONE, 200, false},
+    {"many", "/many", ACTION_GET, LB_REQUEST_DONE, 20, false},
+    {"large", "/large", ACTION_GET, LB_REQUEST_DONE, 1000, true},
+    {"error", "/error", ACTION_GET, LB_REQUEST_FAILED, -1, false},
+    {"nobatch", "/nobatch", ACTION_SETMANY, LB_REQUEST_REJECTED, -1, false},
+    {"portal", "/portal", ACTION_SETMANY, LB_REQUEST_FAILED, -1, false},
+    {"stall", "/stall", ACTION_GET, LB_REQUEST_FAILED, -1, false},
+};
+static const int SCENARIO_COUNT = sizeof(SCENARIOS) / sizeof(SCENARIO);
+
+// State names
+static const char* STATE_NAMES[] = {
+
+    "none", "pending", "done", "failed", "rejected", "not modified"
+};
+
+// Leaderboard
+static LEADERBOARD target;
+// Latencies of a scenario (ms)
+static double latencies[MAX_REQUESTS];
+// Longest poll (ms)
+static double maxPoll;
+
+
+// Get the time in milliseconds
+static double get_time() {
+
+    return (double)SDL_GetPerformanceCounter() * 1000.0
+        / (double)SDL_GetPerformanceFrequency();
+}
+
+
+// Are the entries what the server sent. The names and
+// scores come in pairs, the scores in order
+static bool rows_intact(const SCENARIO* sc) {
+
+    int i = 0;
+    for(; i < target.count; ++ i) {
+
+        if(target.entries[i].name[0] == '\0'
+         || (i > 0 && target.entries[i].score > target.entries[i-1].score))
+            return false;
+    }
+    return sc->rows < 0 || target.count == sc->rows;
+}
+
+
+// Start the request of an action
+static int start_action(int action, int index) {
+
+    LB_ENTRY entries[LB_BATCH_MAX];
+    int i;
+
+    switch(action) {
+
+    case ACTION_SET:
+    case ACTION_BUSY:
+        return lb_add_score_async(&target, "BENCH", index);
+
+    case ACTION_SETMANY:
+        for(i = 0; i < LB_BATCH_MAX; ++ i) {
+
+            snprintf(entries[i].name, _NAME_LENGTH, "BENCH%d", i);
+            entries[i].score = index*LB_BATCH_MAX + i;
+        }
+        return lb_add_scores_async(&target, entries, LB_BATCH_MAX);
+
+    case ACTION_REFRESH:
+        return lb_refresh_async(&target, lb_get_etag());
+
+    default:
+        return lb_get_async(&target);
+    }
+}
+
+
+// Drive the request until it is done, like the game
+// does (once per "frame"). Returns the final state
+static int finish_action() {
+
+    int ret;
+    double t;
+    while(true) {
+
+        t = get_time();
+        ret = lb_poll();
+        t = get_time() - t;
+        if(t > maxPoll) maxPoll = t;
+
+        if(ret != LB_REQUEST_PENDING) return ret;
+        SDL_Delay(1);
+    }
+}
+
+
+// Run an action once. Returns the final state
+static int run_action(int action, int index, double* latency) {
+
+    double start = get_time();
+
+    if(start_action(action, index) == 1)
+        return LB_REQUEST_FAILED;
+
+    // A second request must be refused while the
+    // first one is in progress
+    if(action == ACTION_BUSY && lb_get_async(&target) == 0) {
+
+        lb_cancel();
+        return LB_REQUEST_NONE;
+    }
+
+    int ret = finish_action();
+    *latency = get_time() - start;
+
+    return ret;
+}
+
+
+// Compare latencies
+static int compare_latency(const void* a, const void* b) {
+
+    double d = *(const double*)a - *(const double*)b;
+    return d < 0.0 ? -1 : (d > 0.0 ? 1 : 0);
+}
+
+
+// Run a scenario. Returns true if it passed
+static bool run_scenario(const SCENARIO* sc, const char* address, int requests) {
+
+    char addr[ADDR_BUFFER_SIZE];
+    snprintf(addr, ADDR_BUFFER_SIZE, "%s%s", address, sc->path);
+
+    target.count = 0;
+    maxPoll = 0.0;
+
+    if(lb_init_http(addr) == 1) {
+
+        printf("%s,init failed: %s\n", sc->name, error_get_message());
+        return false;
+    }
+
+    // Get a tag to refresh with
+    double latency = 0.0;
+    if(sc->action == ACTION_REFRESH)
+        run_action(ACTION_GET, 0, &latency);
+
+    int count = sc->timed ? requests : 1;
+    int ret = LB_REQUEST_NONE;
+    bool ok = true;
+    int i = 0;
+    for(; i < count && ok; ++ i) {
+
+        ret = run_action(sc->action, i, &latencies[i]);
+
+        // Other clients may change the scores between
+        // refreshes, then a new board is the right answer
+        if(sc->action == ACTION_REFRESH && ret == LB_REQUEST_DONE)
+            ret = sc->expected;
+
+        ok = ret == sc->expected && rows_intact(sc);
+    }
+    count = i;
+
+    lb_destroy_http();
+
+    // Print the results
+    qsort(latencies, count, sizeof(double), compare_latency);
+    double sum = 0.0;
+    for(i = 0; i < count; ++ i) {
+
+        sum += latencies[i];
+    }
+
+    printf("%s,%s,%s,%s,%d,%d,%.2f,%.2f,%.2f,%.2f\n",
+        sc->name, STATE_NAMES[sc->expected], STATE_NAMES[ret],
+        ok ? "ok" : (rows_intact(sc) ? "FAIL" : "FAIL (rows)"),
+        target.count, count, sum / count, latencies[count/2], latencies[(count*99)/100], maxPoll);
+
+    if(ret == LB_REQUEST_FAILED || ret == LB_REQUEST_REJECTED)
+        printf("#   %s\n", error_get_message());
+
+    return ok;
+}
+
+
+// Run the bench from the command line
+int lb_bench_main(int argc, char** argv) {
+
+    if(argc < 3) {
+
+        printf("Usage: %s --lb-bench <address> [requests]\n", argv[0]);
+        return 1;
+    }
+    const char* address = argv[2];
+    int requests = argc > 3 ? (int)strtol(argv[3], NULL, 10) : DEFAULT_REQUESTS;
+    if(requests < 1) requests = 1;
+    if(requests > MAX_REQUESTS) requests = MAX_REQUESTS;
+
+    printf("scenario,expected,got,result,rows,requests,mean ms,median ms,p99 ms,max poll ms\n");
+
+    int failed = 0;
+    int i = 0;
+    for(; i < SCENARIO_COUNT; ++ i) {
+
+        if(!run_scenario(&SCENARIOS[i], address, requests))
+            ++ failed;
+    }
+    lb_free(&target);
+    printf("# %d scenarios, %d failed\n", SCENARIO_COUNT, failed);
+
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,14 @@
+// GOAT
+// Leaderboard client bench (header)
+// (c) 2018 Jani Nykänen
+
+#ifndef __LB_BENCH__
+#define __LB_BENCH__
+
+// Run the client against a leaderboard server (see
+// tools/lbserver.c for one) from the command line:
+// --lb-bench <address> [requests]
+// Returns 1 if any scenario fails
+int lb_bench_main(int argc, char** argv);
+
+#endif // __LB_BENCH__
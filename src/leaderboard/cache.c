@@ -0,0 +1,151 @@
+// GOAT
+// Leaderboard cache (source)
+// (c) 2018 Jani Nykänen
+
+#include "cache.h"
+
+#include "../engine/error.h"
+
+#include "../include/std.h"
+
+// Cache file header
+typedef struct {
+
+    Uint32 magic;
+    Uint32 version;
+    Uint32 size;
+    Uint32 checksum;
+}
+HEADER;
+
+// Cache file data, followed by the entries
+typedef struct {
+
+    char etag[LB_ETAG_SIZE];
+    Sint64 time;
+    Uint32 count;
+}
+DATA;
+
+
+// Continue a checksum (FNV-1a)
+static Uint32 checksum(Uint32 h, const void* p, size_t size) {
+
+    const Uint8* data = (const Uint8*)p;
+    size_t i = 0;
+    for(; i < size; ++ i) {
+
+        h ^= data[i];
+        h *= 16777619u;
+    }
+
+    return h;
+}
+
+
+// Store a leaderboard to the cache
+int lb_cache_set(LB_CACHE* c, LEADERBOARD* lb, const char* etag) {
+
+    if(lb_copy(&c->lb, lb) == 1) {
+
+        c->valid = false;
+        return 1;
+    }
+    snprintf(c->etag, LB_ETAG_SIZE, "%s", etag);
+    c->time = (Sint64)time(NULL);
+    c->valid = true;
+
+    return 0;
+}
+
+
+// Write the cache to a file
+int lb_cache_write(LB_CACHE* c, const char* path) {
+
+    DATA d;
+    HEADER h;
+
+    memset(&d, 0, sizeof(DATA));
+    snprintf(d.etag, LB_ETAG_SIZE, "%s", c->etag);
+    d.time = c->time;
+    d.count = (Uint32)c->lb.count;
+
+    size_t size = sizeof(LB_ENTRY) * c->lb.count;
+    h.magic = LB_CACHE_MAGIC;
+    h.version = LB_CACHE_VERSION;
+    h.size = (Uint32)(sizeof(DATA) + size);
+    h.checksum = checksum(checksum(2166136261u, &d, sizeof(DATA)),
+        c->lb.entries, size);
+
+    FILE* f = fopen(path, "wb");
+    if(f == NULL) {
+
+        error_throw("Failed to create a file in ", path);
+        return 1;
+    }
+
+    bool ok = fwrite(&h, sizeof(HEADER), 1, f) == 1
+        && fwrite(&d, sizeof(DATA), 1, f) == 1
+        && (size == 0 || fwrite(c->lb.entries, size, 1, f) == 1);
+
+    if(fclose(f) != 0 || !ok) {
+
+        error_throw("Failed to write the leaderboard cache to ", path);
+        return 1;
+    }
+
+    return 0;
+}
+
+
+// Read the cache from a file
+int lb_cache_read(LB_CACHE* c, const char* path) {
+
+    DATA d;
+    HEADER h;
+
+    c->valid = false;
+
+    FILE* f = fopen(path, "rb");
+    if(f == NULL) {
+
+        error_throw("Failed to open a file in ", path);
+        return 1;
+    }
+
+    bool ok = fread(&h, sizeof(HEADER), 1, f) == 1
+        && h.magic == LB_CACHE_MAGIC
+        && h.version == LB_CACHE_VERSION
+        && fread(&d, sizeof(DATA), 1, f) == 1
+        && d.count <= LB_ROWS_MAX
+        && h.size == (Uint32)(sizeof(DATA) + sizeof(LB_ENTRY) * d.count);
+
+    // Read the entries
+    LB_ENTRY e;
+    c->lb.count = 0;
+    Uint32 i = 0;
+    for(; ok && i < d.count; ++ i) {
+
+        ok = fread(&e, sizeof(LB_ENTRY), 1, f) == 1;
+
+        // Make sure the name ends
+        e.name[_NAME_LENGTH-1] = '\0';
+        ok = ok && lb_add_entry(&c->lb, e.name, e.score) == 0;
+    }
+    fclose(f);
+
+    if(!ok || h.checksum != checksum(checksum(2166136261u, &d, sizeof(DATA)),
+        c->lb.entries, sizeof(LB_ENTRY) * c->lb.count)) {
+
+        c->lb.count = 0;
+        error_throw("Invalid leaderboard cache in ", path);
+        return 1;
+    }
+    d.etag[LB_ETAG_SIZE-1] = '\0';
+
+    snprintf(c->etag, LB_ETAG_SIZE, "%s", d.etag);
+    c->time = d.time;
+    c->valid = true;
+
+    return 0;
+}
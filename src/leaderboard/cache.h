@@ -0,0 +1,39 @@
+// GOAT
+// Leaderboard cache (header)
+// (c) 2018 Jani Nykänen
+
+#ifndef __LB_CACHE__
+#define __LB_CACHE__
+
+#include <SDL2/SDL.h>
+
+#include "leaderboard.h"
+
+#include <stdbool.h>
+
+// Cache file magic ("GLBC") & version
+#define LB_CACHE_MAGIC 0x43424C47
+#define LB_CACHE_VERSION 2
+
+// Cached leaderboard
+typedef struct {
+
+    LEADERBOARD lb;
+    char etag[LB_ETAG_SIZE]; // Empty if the server sent none
+    Sint64 time; // When fetched or confirmed (Unix time)
+    bool valid;
+}
+LB_CACHE;
+
+// Store a copy of a leaderboard to the cache.
+// Returns 1 on error
+int lb_cache_set(LB_CACHE* c, LEADERBOARD* lb, const char* etag);
+
+// Write the cache to a file
+int lb_cache_write(LB_CACHE* c, const char* path);
+
+// Read the cache from a file. The cache is invalid
+// if this fails
+int lb_cache_read(LB_CACHE* c, const char* path);
+
+#endif // __LB_CACHE__
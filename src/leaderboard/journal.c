@@ -0,0 +1,314 @@
+// GOAT
+// Score journal (source)
+// (c) 2018 Jani Nykänen
+
+#include "journal.h"
+
+#include "../engine/error.h"
+
+#include "../include/std.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <stddef.h>
+
+// Record magic ("JRNL")
+#define RECORD_MAGIC 0x4C4E524A
+
+// Record types
+enum {
+
+    RECORD_ADD = 1,
+    RECORD_ACK = 2,
+};
+
+// Record. Fixed size, so a torn write at the end of
+// the file is easy to spot
+typedef struct {
+
+    Uint32 magic;
+    Uint32 type;
+    Uint32 seq;
+    Sint32 score;
+    LB_NAME name;
+    Uint32 checksum;
+}
+RECORD;
+
+
+// Compute the checksum of a record (FNV-1a)
+static Uint32 checksum(RECORD* r) {
+
+    const Uint8* data = (const Uint8*)r;
+    Uint32 h = 2166136261u;
+    size_t i = 0;
+    for(; i < offsetof(RECORD, checksum); ++ i) {
+
+        h ^= data[i];
+        h *= 16777619u;
+    }
+
+    return h;
+}
+
+
+// Make a record
+static RECORD make_record(Uint32 type, Uint32 seq, const LB_ENTRY* e) {
+
+    RECORD r;
+    memset(&r, 0, sizeof(RECORD));
+
+    r.magic = RECORD_MAGIC;
+    r.type = type;
+    r.seq = seq;
+    if(e != NULL) {
+
+        r.score = e->score;
+        snprintf(r.name, _NAME_LENGTH, "%s", e->name);
+    }
+    r.checksum = checksum(&r);
+
+    return r;
+}
+
+
+// Flush a file to the disk
+static int sync_file(FILE* f) {
+
+    if(fflush(f) != 0) return 1;
+
+#ifdef _WIN32
+    return _commit(_fileno(f)) == 0 ? 0 : 1;
+#else
+    return fsync(fileno(f)) == 0 ? 0 : 1;
+#endif
+}
+
+
+// Remove a pending score
+static void remove_pending(JOURNAL* j, Uint32 seq) {
+
+    int i = 0;
+    for(; i < j->pendingCount; ++ i) {
+
+        if(j->pending[i].seq != seq) continue;
+
+        memmove(&j->pending[i], &j->pending[i+1],
+            sizeof(JOURNAL_ENTRY) * (j->pendingCount-1 - i));
+        -- j->pendingCount;
+        return;
+    }
+}
+
+
+// Rewrite the file with the pending scores only. The new
+// file is synced before it replaces the old one, so a
+// crash leaves one of them intact
+static int rewrite(JOURNAL* j) {
+
+    char tmpPath[JOURNAL_PATH_SIZE + 4];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", j->path);
+
+    if(j->f != NULL) {
+
+        fclose(j->f);
+        j->f = NULL;
+    }
+
+    FILE* f = fopen(tmpPath, "wb");
+    if(f == NULL) {
+
+        error_throw("Failed to create a file in ", tmpPath);
+        return 1;
+    }
+
+    RECORD r;
+    bool ok = true;
+    int i = 0;
+    for(; i < j->pendingCount && ok; ++ i) {
+
+        r = make_record(RECORD_ADD, j->pending[i].seq, &j->pending[i].entry);
+        ok = fwrite(&r, sizeof(RECORD), 1, f) == 1;
+    }
+    ok = ok && sync_file(f) == 0;
+
+    if(fclose(f) != 0 || !ok) {
+
+        error_throw("Failed to write the journal to ", tmpPath);
+        return 1;
+    }
+
+    // Windows does not replace files on rename
+#ifdef _WIN32
+    remove(j->path);
+#endif
+    if(rename(tmpPath, j->path) != 0) {
+
+        error_throw("Failed to replace the journal in ", j->path);
+        return 1;
+    }
+
+    j->f = fopen(j->path, "ab");
+    if(j->f == NULL) {
+
+        error_throw("Failed to open a file in ", j->path);
+        return 1;
+    }
+
+    return 0;
+}
+
+
+// Replay a journal file. Returns true if the file
+// should be rewritten
+static bool replay(JOURNAL* j, FILE* f) {
+
+    RECORD r;
+    JOURNAL_ENTRY* e;
+    bool dirty = false;
+
+    while(true) {
+
+        if(fread(&r, sizeof(RECORD), 1, f) != 1) {
+
+            // A partial record is a torn write
+            dirty = dirty || !feof(f) || ftell(f) % sizeof(RECORD) != 0;
+            break;
+        }
+
+        // Anything after a broken record is unreliable
+        if(r.magic != RECORD_MAGIC || r.checksum != checksum(&r)) {
+
+            dirty = true;
+            break;
+        }
+
+        if(r.seq >= j->nextSeq)
+            j->nextSeq = r.seq + 1;
+
+        if(r.type == RECORD_ACK) {
+
+            remove_pending(j, r.seq);
+            dirty = true;
+        }
+        else if(r.type == RECORD_ADD && j->pendingCount < JOURNAL_MAX) {
+
+            e = &j->pending[j->pendingCount ++];
+            e->seq = r.seq;
+            e->entry.score = r.score;
+            snprintf(e->entry.name, _NAME_LENGTH, "%s", r.name);
+        }
+    }
+
+    return dirty;
+}
+
+
+// Open a journal
+int journal_open(JOURNAL* j, const char* path) {
+
+    j->f = NULL;
+    j->pendingCount = 0;
+    j->nextSeq = 1;
+    snprintf(j->path, JOURNAL_PATH_SIZE, "%s", path);
+
+    // Replay
+    bool dirty = false;
+    FILE* f = fopen(path, "rb");
+    if(f != NULL) {
+
+        dirty = replay(j, f);
+        fclose(f);
+    }
+
+    if(dirty)
+        return rewrite(j);
+
+    j->f = fopen(path, "ab");
+    if(j->f == NULL) {
+
+        error_throw("Failed to open a file in ", path);
+        return 1;
+    }
+
+    return 0;
+}
+
+
+// Add a score
+int journal_append(JOURNAL* j, const char* name, int score, Uint32* seq) {
+
+    if(j->pendingCount >= JOURNAL_MAX) {
+
+        error_throw("The score journal\nis full!", NULL);
+        return 1;
+    }
+
+    JOURNAL_ENTRY* e = &j->pending[j->pendingCount];
+    e->seq = j->nextSeq;
+    e->entry.score = score;
+    snprintf(e->entry.name, _NAME_LENGTH, "%s", name);
+
+    // Write ahead
+    if(j->f != NULL) {
+
+        RECORD r = make_record(RECORD_ADD, e->seq, &e->entry);
+        if(fwrite(&r, sizeof(RECORD), 1, j->f) != 1 || sync_file(j->f) != 0) {
+
+            error_throw("Failed to write the journal to ", j->path);
+            return 1;
+        }
+    }
+
+    ++ j->pendingCount;
+    ++ j->nextSeq;
+    if(seq != NULL)
+        *seq = e->seq;
+
+    return 0;
+}
+
+
+// Acknowledge scores
+int journal_ack(JOURNAL* j, const Uint32* seqs, int count) {
+
+    RECORD r;
+    bool ok = true;
+    int i = 0;
+    for(; i < count; ++ i) {
+
+        remove_pending(j, seqs[i]);
+
+        if(j->f != NULL && ok) {
+
+            r = make_record(RECORD_ACK, seqs[i], NULL);
+            ok = fwrite(&r, sizeof(RECORD), 1, j->f) == 1;
+        }
+    }
+    if(j->f == NULL) return 0;
+
+    // Nothing left, start a new file
+    if(j->pendingCount == 0)
+        return rewrite(j);
+
+    if(!ok || sync_file(j->f) != 0) {
+
+        error_throw("Failed to write the journal to ", j->path);
+        return 1;
+    }
+
+    return 0;
+}
+
+
+// Close a journal
+void journal_close(JOURNAL* j) {
+
+    if(j->f != NULL)
+        fclose(j->f);
+    j->f = NULL;
+}
@@ -0,0 +1,56 @@
+// GOAT
+// Score journal (header)
+// (c) 2018 Jani Nykänen
+
+#ifndef __JOURNAL__
+#define __JOURNAL__
+
+#include <SDL2/SDL.h>
+
+#include "leaderboard.h"
+
+#include <stdio.h>
+
+// Max pending scores
+#define JOURNAL_MAX 256
+// Path buffer size
+#define JOURNAL_PATH_SIZE 128
+
+// Pending score
+typedef struct {
+
+    Uint32 seq;
+    LB_ENTRY entry;
+}
+JOURNAL_ENTRY;
+
+// Journal. Scores are appended to a file (and synced)
+// before they are sent, and acknowledged once the
+// server has them. Replaying the file gives the scores
+// that are still pending
+typedef struct {
+
+    FILE* f; // NULL if memory only
+    char path[JOURNAL_PATH_SIZE];
+
+    JOURNAL_ENTRY pending[JOURNAL_MAX]; // Oldest first
+    int pendingCount;
+    Uint32 nextSeq;
+}
+JOURNAL;
+
+// Open a journal and replay it. If the file cannot be
+// used, the journal works in memory only and 1 is
+// returned
+int journal_open(JOURNAL* j, const char* path);
+
+// Add a score. Returns 1 on error
+int journal_append(JOURNAL* j, const char* name, int score, Uint32* seq);
+
+// Acknowledge scores. Returns 1 on error
+int journal_ack(JOURNAL* j, const Uint32* seqs, int count);
+
+// Close a journal
+void journal_close(JOURNAL* j);
+
+#endif // __JOURNAL__
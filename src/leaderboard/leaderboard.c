@@ -4,104 +4,164 @@
 
 #include "leaderboard.h"
 
+#include "parser.h"
+#include "store.h"
+
 #include <curl/curl.h>
 
+#include <ctype.h>
+
 #include "../include/std.h"
 #include "../include/system.h"
 
-// Return buffer size
-#define RET_BUFFER_SIZE 1024
-// Word length
-#define WORD_LENGTH 32
 // Check value modulo
 #define CHECK_MOD 1023
 // Check value multiplier
 #define CHECK_MUL 255
+// URL buffer size
+#define URL_SIZE 1024
+
+// Initial entry capacity
+static const int ENTRY_CAPACITY = 16;
 
-// Word type
-typedef char _WORD[WORD_LENGTH];
+// Timeouts (in milliseconds)
+static const long CONNECT_TIMEOUT = 5000;
+static const long REQUEST_TIMEOUT = 10000;
+// Time a blocking request waits for the socket at once
+static const int WAIT_TIMEOUT = 100;
 
-// Handle
+// HTTP status codes
+static const long HTTP_NOT_MODIFIED = 304;
+static const long HTTP_ERROR = 400;
+
+// Handle. Kept for all the requests, so the
+// connection is reused
 static CURL* handle;
+// Multi handle, drives the requests
+static CURLM* multi;
+// Request state
+static int state;
+// Leaderboard of the current request
+static LEADERBOARD* target;
+// URL of the current request
+static char url[URL_SIZE];
+// Extra headers of the current request
+static struct curl_slist* headers;
+// ETag of the last response
+static char etag[LB_ETAG_SIZE];
 // Address
 static char* address;
 // Address length
 static size_t addrLength;
 
-// Return buffer
-static char buffer[RET_BUFFER_SIZE];
-// Buffer pointer
-static size_t bufptr;
+// Response parser
+static LB_PARSER parser;
+// Leaderboard being received. Swapped with the target
+// when done, so a failed request leaves it intact
+static LEADERBOARD incoming;
 
+// Offline store
+static LB_STORE store;
+// Is the offline store used
+static bool offline;
+// View of the requests
+static int view;
 
-// Clear buffer
-static void clear_buffer() {
 
-    memset(buffer,'\0', RET_BUFFER_SIZE);
-}
+// Make room for an entry
+static int reserve(LEADERBOARD* lb, int count) {
+
+    if(count <= lb->capacity) return 0;
 
+    if(count > LB_ROWS_MAX) {
 
-// Get the next word from the buffer, starting from certain index
-size_t next_word(int index, _WORD w) {
+        error_throw("The leaderboard is\ntoo large!", NULL);
+        return 1;
+    }
 
-    // Clear word
-    memset(w, '\0', WORD_LENGTH);
+    int cap = lb->capacity > 0 ? lb->capacity : ENTRY_CAPACITY;
+    while(cap < count) cap *= 2;
 
-    // Copy characters
-    int i = (int)index;
-    int windex = 0;
-    for(; i < RET_BUFFER_SIZE && buffer[i] != '\0' && buffer[i] != '\n'; ++ i) {
+    LB_ENTRY* entries = (LB_ENTRY*)realloc(lb->entries, sizeof(LB_ENTRY) * cap);
+    if(entries == NULL) {
 
-        w[windex ++] = buffer[i];
+        error_mem_alloc();
+        return 1;
     }
+    lb->entries = entries;
+    lb->capacity = cap;
 
-    if(buffer[i] == '\0' || i == RET_BUFFER_SIZE-1)
-        return -1;
-
-    return i+1;
+    return 0;
 }
 
 
-// Receive
+// Receive. The chunks are parsed as they come, only
+// a partial line is kept between them
 static size_t receive(void* data, size_t size, size_t mem, void* user) {
 
-    // Data in characters
-    char* chr = (char*)data;
-    size_t len = size * mem;
+    // Stops the transfer
+    if(lb_parser_feed(&parser, (const char*)data, size * mem) == 1)
+        return 0;
 
-    // Copy received data to the buffer
-    int i = 0;
-    for(; i < len; ++ i) {
+    return size * mem;
+}
 
-        // TODO: Better error handling
-        if(bufptr >= RET_BUFFER_SIZE) {
 
-            error_throw("Buffer overflow", NULL);
-            return 0;
-        }
+// Receive a header
+static size_t receive_header(char* data, size_t size, size_t mem, void* user) {
+
+    const char* NAME = "etag:";
 
-        buffer[bufptr ++] = chr[i];
+    size_t len = size * mem;
+    size_t n = strlen(NAME);
+    size_t i;
+
+    if(len <= n) return len;
+    for(i = 0; i < n; ++ i) {
+
+        if(tolower((unsigned char)data[i]) != NAME[i])
+            return len;
     }
 
+    // Store the value, without the spaces around it
+    while(i < len && data[i] == ' ') ++ i;
+    while(len > i && isspace((unsigned char)data[len-1])) -- len;
+    snprintf(etag, LB_ETAG_SIZE, "%.*s", (int)(len - i), data + i);
+
     return size * mem;
 }
 
 
-// Send a request
-static int send_request(const char* req) {
+// Start a request
+static int start_request(LEADERBOARD* lb, const char* req, const char* ifNoneMatch) {
+
+    if(state == LB_REQUEST_PENDING) {
+
+        error_throw("A request is already\nin progress!", NULL);
+        return 1;
+    }
 
     // Set URL
-    char fullAddress[1024];
-    snprintf(fullAddress, 1024, "%s/?%s", address, req);
-    curl_easy_setopt(handle, CURLOPT_URL, fullAddress);
+    snprintf(url, URL_SIZE, "%s/?%s", address, req);
+    curl_easy_setopt(handle, CURLOPT_URL, url);
+
+    // Ask for the body only if it has changed
+    curl_slist_free_all(headers);
+    headers = NULL;
+    if(ifNoneMatch != NULL && ifNoneMatch[0] != '\0') {
 
-    // Clear buffer
-    bufptr = 0;
-    clear_buffer();
+        char line[LB_ETAG_SIZE + 16];
+        snprintf(line, sizeof(line), "If-None-Match: %s", ifNoneMatch);
+        headers = curl_slist_append(NULL, line);
+    }
+    curl_easy_setopt(handle, CURLOPT_HTTPHEADER, headers);
+
+    lb_parser_start(&parser, &incoming);
+    etag[0] = '\0';
 
-    // Send request & handle data
-    CURLcode success = curl_easy_perform(handle);
-    if(success != CURLE_OK) {
+    // Start
+    CURLMcode success = curl_multi_add_handle(multi, handle);
+    if(success != CURLM_OK) {
 
         char errCode[16];
         snprintf(errCode, 16, "%d", (int)success);
@@ -109,58 +169,224 @@ static int send_request(const char* req) {
         return 1;
     }
 
+    target = lb;
+    state = LB_REQUEST_PENDING;
+
     return 0;
 }
 
 
-// Get leaderboards
-static void get_lb(LEADERBOARD* lb, int index) {
+// Read the response of a finished request. Returns
+// the state of the request
+static int read_response() {
 
-    int i = 0;
-    int lbi = 0;
-    _WORD w;
+    switch(lb_parser_finish(&parser)) {
 
-    // Get names & scores
-    while(index != -1) {
+    case LB_PARSE_OK:
+        break;
 
-        index = next_word(index, w);
+    // Only an explicit "false" is a refusal
+    case LB_PARSE_REFUSED:
+        return LB_REQUEST_REJECTED;
 
-        if(strcmp(w, "") == 0)
-            continue;
+    // A proxy or a login page, worth a retry
+    default:
+        return LB_REQUEST_FAILED;
+    }
 
-        // Store data
-        if(i % 2 == 0) {
+    // Keep the old memory for the next response
+    LEADERBOARD old = *target;
+    *target = incoming;
+    incoming = old;
 
-            strcpy(lb->names[lbi], w);
-        }
-        else {
+    return LB_REQUEST_DONE;
+}
+
+
+// Finish the current request
+static void finish_request(CURLcode result) {
+
+    curl_multi_remove_handle(multi, handle);
+
+    // The parser ran out of memory, the reason is
+    // already in the error message
+    if(parser.failed) {
+
+        state = LB_REQUEST_FAILED;
+        target = NULL;
+        return;
+    }
+
+    if(result != CURLE_OK) {
+
+        char errCode[16];
+        snprintf(errCode, 16, "%d", (int)result);
+        error_throw("Failed to send an\nhttp request!\nError code:", errCode);
+        state = LB_REQUEST_FAILED;
+        target = NULL;
+        return;
+    }
+
+    long code = 0;
+    curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &code);
+
+    if(code == HTTP_NOT_MODIFIED) {
+
+        state = LB_REQUEST_NOT_MODIFIED;
+    }
+    // Server errors are worth a retry, unlike a refusal
+    else if(code >= HTTP_ERROR) {
+
+        char errCode[16];
+        snprintf(errCode, 16, "%ld", code);
+        error_throw("The server failed!\nHTTP status:", errCode);
+        state = LB_REQUEST_FAILED;
+    }
+    else {
+
+        state = read_response();
+    }
+
+    target = NULL;
+}
+
+
+// Answer a request from the offline store. There is
+// nothing to wait for, the next poll gives the result
+static int offline_request(LEADERBOARD* lb, const LB_ENTRY* entries, int count,
+    const char* ifNoneMatch) {
+
+    // Nothing is kept if this fails, so a retry adds
+    // the batch only once
+    if(count > 0 && lb_store_add(&store, entries, count) == 1) {
+
+        state = LB_REQUEST_FAILED;
+        return 0;
+    }
+
+    lb_store_get_tag(&store, view, etag, LB_ETAG_SIZE);
+    if(ifNoneMatch != NULL && strcmp(ifNoneMatch, etag) == 0) {
+
+        state = LB_REQUEST_NOT_MODIFIED;
+        return 0;
+    }
+
+    if(lb_store_get(&store, view, &incoming) == 1) {
+
+        state = LB_REQUEST_FAILED;
+        return 0;
+    }
+
+    LEADERBOARD old = *lb;
+    *lb = incoming;
+    incoming = old;
+    state = LB_REQUEST_DONE;
+
+    return 0;
+}
+
+
+// Block until the current request is done
+static int wait_request() {
+
+    int ret;
+    while((ret = lb_poll()) == LB_REQUEST_PENDING) {
+
+        curl_multi_wait(multi, NULL, 0, WAIT_TIMEOUT, NULL);
+    }
+
+    return ret == LB_REQUEST_DONE ? 0 : 1;
+}
+
+
+// Add an entry to a leaderboard
+int lb_add_entry(LEADERBOARD* lb, const char* name, int score) {
+
+    if(reserve(lb, lb->count + 1) == 1)
+        return 1;
+
+    // Zeroed, so the bytes after the name are known
+    LB_ENTRY* e = &lb->entries[lb->count ++];
+    memset(e, 0, sizeof(LB_ENTRY));
+    snprintf(e->name, _NAME_LENGTH, "%s", name);
+    e->score = score;
+
+    return 0;
+}
+
+
+// Copy a leaderboard
+int lb_copy(LEADERBOARD* dest, const LEADERBOARD* src) {
+
+    if(reserve(dest, src->count) == 1)
+        return 1;
+
+    if(src->count > 0)
+        memcpy(dest->entries, src->entries, sizeof(LB_ENTRY) * src->count);
+    dest->count = src->count;
+
+    return 0;
+}
 
-            lb->scores[lbi] = (int)strtol(w, NULL, 10);
-            ++ lbi;
-        }
 
-        ++ i;
+// Get the number of pages
+int lb_page_count(const LEADERBOARD* lb) {
+
+    return (lb->count + MEMBER_MAX-1) / MEMBER_MAX;
+}
+
+
+// Get a page of entries
+const LB_ENTRY* lb_get_page(const LEADERBOARD* lb, int page, int* count) {
+
+    int start = page * MEMBER_MAX;
+    if(page < 0 || start >= lb->count) {
+
+        *count = 0;
+        return NULL;
     }
+
+    *count = lb->count - start < MEMBER_MAX ? lb->count - start : MEMBER_MAX;
+    return &lb->entries[start];
+}
+
+
+// Free the entries of a leaderboard
+void lb_free(LEADERBOARD* lb) {
+
+    free(lb->entries);
+    lb->entries = NULL;
+    lb->count = 0;
+    lb->capacity = 0;
 }
 
 
 // Initialize http request system
 int lb_init_http(const char* addr) {
 
-    // Create handle
+    // Create handles
     handle = curl_easy_init();
-    if(handle == NULL) {
+    multi = curl_multi_init();
+    if(handle == NULL || multi == NULL) {
 
         error_throw("Could not create a handle!", NULL);
         return 1;
     }
 
-    // Set receiver
+    // Set receivers
     curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, receive);
+    curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, receive_header);
+
+    // Never hang when the server stalls, and keep
+    // the connection alive between the requests
+    curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT_MS, CONNECT_TIMEOUT);
+    curl_easy_setopt(handle, CURLOPT_TIMEOUT_MS, REQUEST_TIMEOUT);
+    curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
 
     // Copy address
     addrLength = strlen(addr);
-    address = (char*)malloc(sizeof(char) * addrLength);
+    address = (char*)malloc(sizeof(char) * (addrLength+1));
     if(address == NULL) {
 
         error_mem_alloc();
@@ -168,62 +394,201 @@ int lb_init_http(const char* addr) {
     }
     strcpy(address, addr);
 
+    state = LB_REQUEST_NONE;
+    target = NULL;
+
     return 0;
 }
 
 
-// Get leaderboard
-int lb_get(LEADERBOARD* lb) {
+// Destroy http request system
+void lb_destroy_http() {
 
-    // Send request
-    if(send_request("&mode=get") == 1) {
+    lb_cancel();
 
-        return 1;
-    }
+    curl_multi_cleanup(multi);
+    curl_easy_cleanup(handle);
+    curl_slist_free_all(headers);
+    free(address);
+    lb_free(&incoming);
+
+    multi = NULL;
+    handle = NULL;
+    headers = NULL;
+    address = NULL;
+}
 
-    // Get words
-    _WORD w;
-    int index = 0;
 
-    // Get first word
-    index = next_word(index, w);
-    if(strcmp(w,"true") != 0) {
+// Initialize the offline backend
+int lb_init_offline(const char* path) {
 
-        error_throw("Expected true, got ", w);
-        return 1;
-    }
+    // Keep going without the file, the scores are
+    // still kept for this session
+    if(lb_store_open(&store, path) == 1)
+        printf("Warning: %s\n", error_get_message());
 
-    // Get leaderboards
-    get_lb(lb, index);
+    offline = true;
+    view = LB_VIEW_ALL;
+    state = LB_REQUEST_NONE;
+    target = NULL;
 
     return 0;
 }
 
 
-// Add score
-int lb_add_score(LEADERBOARD* lb, const char* name, int score) {
-    
-    // Send request
+// Destroy the offline backend
+void lb_destroy_offline() {
+
+    lb_store_close(&store);
+    lb_free(&incoming);
+    offline = false;
+}
+
+
+// Set the view of the next requests
+bool lb_set_view(int v) {
+
+    if(!offline || v < 0 || v >= LB_VIEW_COUNT)
+        return false;
+
+    view = v;
+    return true;
+}
+
+
+// Start fetching the leaderboard
+int lb_get_async(LEADERBOARD* lb) {
+
+    if(offline)
+        return offline_request(lb, NULL, 0, NULL);
+
+    return start_request(lb, "&mode=get", NULL);
+}
+
+
+// Start refreshing a leaderboard
+int lb_refresh_async(LEADERBOARD* lb, const char* tag) {
+
+    if(offline)
+        return offline_request(lb, NULL, 0, tag);
+
+    return start_request(lb, "&mode=get", tag);
+}
+
+
+// Start sending a score
+int lb_add_score_async(LEADERBOARD* lb, const char* name, int score) {
+
+    if(offline) {
+
+        LB_ENTRY e;
+        snprintf(e.name, _NAME_LENGTH, "%s", name);
+        e.score = score;
+        return offline_request(lb, &e, 1, NULL);
+    }
+
     char str[1024];
     snprintf(str, 1024, "&mode=set&name=%s&score=%d&check=%d", name, score, 
         (score * CHECK_MUL) % CHECK_MOD);
-    if(send_request(str) == 1) {
 
+    return start_request(lb, str, NULL);
+}
+
+
+// Start sending a batch of scores
+int lb_add_scores_async(LEADERBOARD* lb, const LB_ENTRY* entries, int count) {
+
+    if(offline)
+        return offline_request(lb, entries, count, NULL);
+
+    char str[1024];
+    int len = snprintf(str, 1024, "&mode=setmany&count=%d", count);
+
+    int i = 0;
+    for(; i < count && len < 1024; ++ i) {
+
+        len += snprintf(str + len, 1024 - len, "&name%d=%s&score%d=%d&check%d=%d",
+            i, entries[i].name, i, entries[i].score, 
+            i, (entries[i].score * CHECK_MUL) % CHECK_MOD);
+    }
+    if(len >= 1024) {
+
+        error_throw("Too many scores in a batch!", NULL);
         return 1;
     }
 
-    // Get first word
-    _WORD w;
-    int index = 0;
-    index = next_word(index, w);
-    if(strcmp(w,"true") != 0) {
+    return start_request(lb, str, NULL);
+}
 
-        error_throw("Expected true, got ", w);
-        return 1;
+
+// Drive the current request
+int lb_poll() {
+
+    // Offline requests are done already
+    if(state == LB_REQUEST_PENDING) {
+
+        int running = 0;
+        curl_multi_perform(multi, &running);
+
+        // Check if done
+        int left = 0;
+        CURLMsg* msg;
+        while((msg = curl_multi_info_read(multi, &left)) != NULL) {
+
+            if(msg->msg == CURLMSG_DONE && msg->easy_handle == handle)
+                finish_request(msg->data.result);
+        }
     }
 
-    // Get leaderboards
-    get_lb(lb, index);
+    // Report the result once
+    int ret = state;
+    if(state != LB_REQUEST_PENDING)
+        state = LB_REQUEST_NONE;
 
-    return 0;
+    return ret;
+}
+
+
+// Get the ETag of the last response
+const char* lb_get_etag() {
+
+    return etag;
+}
+
+
+// Is a request in progress
+bool lb_is_busy() {
+
+    return state == LB_REQUEST_PENDING;
+}
+
+
+// Cancel the current request
+void lb_cancel() {
+
+    if(state != LB_REQUEST_PENDING) return;
+
+    curl_multi_remove_handle(multi, handle);
+    state = LB_REQUEST_NONE;
+    target = NULL;
+}
+
+
+// Get leaderboard
+int lb_get(LEADERBOARD* lb) {
+
+    if(lb_get_async(lb) == 1)
+        return 1;
+
+    return wait_request();
+}
+
+
+// Add score
+int lb_add_score(LEADERBOARD* lb, const char* name, int score) {
+
+    if(lb_add_score_async(lb, name, score) == 1)
+        return 1;
+
+    return wait_request();
 }
@@ -8,26 +8,131 @@
 // Leaderboard name length
 #define _NAME_LENGTH 32
 
-// Max amount of members
+// Members shown on a page
 #define MEMBER_MAX 10
 
+// Max amount of members, a server sending more
+// is broken
+#define LB_ROWS_MAX 100000
+
+// Max scores sent in one request
+#define LB_BATCH_MAX 8
+
+// ETag buffer size
+#define LB_ETAG_SIZE 64
+
+#include <stdbool.h>
+
 typedef char LB_NAME[_NAME_LENGTH];
 
-// Leaderboard type
+// Score entry
+typedef struct {
+
+    LB_NAME name;
+    int score;
+}
+LB_ENTRY;
+
+// Leaderboard type. The entries grow as needed, and the
+// memory is kept for the next response. A zeroed
+// leaderboard is empty
 typedef struct {
 
-    LB_NAME names[MEMBER_MAX];
-    int scores[MEMBER_MAX];
+    LB_ENTRY* entries;
+    int count;
+    int capacity;
 }
 LEADERBOARD;
 
+// Request states
+enum {
+
+    LB_REQUEST_NONE = 0,
+    LB_REQUEST_PENDING = 1,
+    LB_REQUEST_DONE = 2,
+    LB_REQUEST_FAILED = 3,
+    LB_REQUEST_REJECTED = 4, // The server answered "false"
+    LB_REQUEST_NOT_MODIFIED = 5, // Refresh, nothing changed
+};
+
+// Views (offline only)
+enum {
+
+    LB_VIEW_ALL = 0,
+    LB_VIEW_DAY = 1,
+    LB_VIEW_WEEK = 2,
+    LB_VIEW_COUNT = 3,
+};
+
+// Add an entry to a leaderboard. Returns 1 on error
+int lb_add_entry(LEADERBOARD* lb, const char* name, int score);
+
+// Copy a leaderboard. Returns 1 on error
+int lb_copy(LEADERBOARD* dest, const LEADERBOARD* src);
+
+// Get the number of pages
+int lb_page_count(const LEADERBOARD* lb);
+
+// Get a page of entries (MEMBER_MAX at most). The
+// amount is stored to count
+const LB_ENTRY* lb_get_page(const LEADERBOARD* lb, int page, int* count);
+
+// Free the entries of a leaderboard
+void lb_free(LEADERBOARD* lb);
+
 // Initialize http request system
 int lb_init_http(const char* address);
 
-// Get leaderboard
+// Destroy http request system
+void lb_destroy_http();
+
+// Initialize the offline backend. Scores are kept in
+// a local store, and the requests are done at once
+int lb_init_offline(const char* path);
+
+// Destroy the offline backend
+void lb_destroy_offline();
+
+// Set the view of the next requests. Returns false
+// if the backend has no views
+bool lb_set_view(int view);
+
+// Start fetching the leaderboard. The result replaces
+// lb when the request is done, a failed request leaves
+// it as it was. Returns 1 on error
+int lb_get_async(LEADERBOARD* lb);
+
+// Start refreshing a leaderboard. The server is asked
+// to answer "not modified" if its ETag matches the tag
+// (empty means "no tag"). Returns 1 on error
+int lb_refresh_async(LEADERBOARD* lb, const char* tag);
+
+// Start sending a score. Returns 1 on error
+int lb_add_score_async(LEADERBOARD* lb, const char* name, int score);
+
+// Start sending a batch of scores. Needs a server
+// that knows "setmany". Returns 1 on error
+int lb_add_scores_async(LEADERBOARD* lb, const LB_ENTRY* entries, int count);
+
+// Drive the current request, call once per frame.
+// Returns the request state. The result is returned
+// once, then the state is back to none. On failure,
+// the reason is in the error message
+int lb_poll();
+
+// Get the ETag of the last response, empty if none
+const char* lb_get_etag();
+
+// Is a request in progress
+bool lb_is_busy();
+
+// Cancel the current request
+void lb_cancel();
+
+// Get leaderboard (blocks until done)
 int lb_get(LEADERBOARD* lb);
 
-// Add score
+// Add score (blocks until done)
 int lb_add_score(LEADERBOARD* lb, const char* name, int score);
 
 #endif // __LEADERBOARDS__
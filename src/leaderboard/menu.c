@@ -5,6 +5,8 @@
 #include "menu.h"
 
 #include "leaderboard.h"
+#include "queue.h"
+#include "cache.h"
 
 #include "../global.h"
 #include "../vpad.h"
@@ -17,15 +19,29 @@
 #include "../include/renderer.h"
 #include "../include/audio.h"
 
-#include "../lib/tinycthread.h"
-
 // Constants
 static const float DARK_MAX = 4;
 static const int DARK_INTERVAL = 4.0f;
 static const int NP_FLASH_MAX = 20.0f;
+static const float PAGE_DELTA = 0.5f;
 #define NAME_LENGTH 10
 #define ERROR_SIZE 256
 
+// Default leaderboard server
+static const char* DEFAULT_ADDRESS = "http://game-leaderboards.000webhostapp.com";
+// Score journal file
+static const char* JOURNAL_PATH = "scores.journal";
+// Leaderboard cache file
+static const char* CACHE_PATH = "leaderboard.cache";
+// Offline score store
+static const char* STORE_PATH = "scores.log";
+
+// View titles
+static const char* VIEW_TITLES[] = {
+
+    "LEADERBOARD", "TODAY", "THIS WEEK"
+};
+
 // Canvas copy
 static FRAME* canvasCopy;
 // Dark timer
@@ -53,46 +69,32 @@ static int namePointer;
 // Name pointer flash timer
 static int npFlashTimer;
 
-// Thread
-static thrd_t T;
-static mtx_t mutex;
-
 // To-be-sent
 static bool toBeSent;
+// Is our request in progress
+static bool requested;
+// Journal entry of the score being sent (0 if none)
+static Uint32 scoreSeq;
 // Leaderboard
 static LEADERBOARD lb;
-// Result
-static int result;
+// Last leaderboard we got
+static LB_CACHE cache;
+// Is the shown leaderboard to be refreshed
+static bool toBeRefreshed;
+// Is the offline backend used
+static bool offline;
+// Shown page
+static int page;
+// Shown view
+static int view;
+// Is the stick held
+static bool stickHeld;
+// Index of our score in the leaderboard (-1 if none)
+static int ownIndex;
 // Error buffer
 static char errBuffer[ERROR_SIZE];
 
 
-// Send the data
-static int t_send_score() {
-    
-    int res = lb_add_score(&lb, nameBuffer, status_get_score());
-
-    mtx_lock(&mutex);
-    result = res;
-    mtx_unlock(&mutex);
-
-    return 0;
-}
-
-
-// Send the data
-static int t_fetch_score() {
-    
-    int res = lb_get(&lb);
-
-    mtx_lock(&mutex);
-    result = res;
-    mtx_unlock(&mutex);
-
-    return 0;
-}
-
-
 // Draw a box with borders
 static void draw_box(int x, int y, int w, int h) {
 
@@ -156,34 +158,32 @@ static void draw_results(int x, int y, int w, int h, int yoff) {
     // Draw box
     draw_box(x,y,w,h);
 
-    // Draw text
-    draw_text(bmpFont,"LEADERBOARD:",x+w/2,y+2,-7,0, true);
+    // Draw text, with the page if there are more
+    char str[32];
+    int pages = lb_page_count(&lb);
+    if(pages > 1)
+        snprintf(str, 32, "%s %d/%d", VIEW_TITLES[view], page+1, pages);
+    else
+        snprintf(str, 32, "%s:", VIEW_TITLES[view]);
+    draw_text(bmpFont,str,x+w/2,y+2,-7,0, true);
 
-    int i = 0;
-    // If current score in the list
-    int thisIndex = -1;
-    for(; i < MEMBER_MAX; ++ i) {
+    int count = 0;
+    const LB_ENTRY* entries = lb_get_page(&lb, page, &count);
 
-        if(strcmp(lb.names[i],nameBuffer) == 0
-         && lb.scores[i] == (int)status_get_score()) {
+    // If current score on the page
+    int thisIndex = ownIndex - page*MEMBER_MAX;
 
-             thisIndex = i;
-             break;
-        }
-    }
-
-    
     // Names
-    for(i=0; i < MEMBER_MAX; ++ i) {
+    int i = 0;
+    for(; i < count; ++ i) {
         
-        draw_text(i == thisIndex ? bmpFont2 : bmpFont,lb.names[i],x+8,y+16 + i*yoff,-7,0, false);
+        draw_text(i == thisIndex ? bmpFont2 : bmpFont,entries[i].name,x+8,y+16 + i*yoff,-7,0, false);
     }
 
     // Scores
-    char str[16];
-    for(i=0; i < MEMBER_MAX; ++ i) {
+    for(i=0; i < count; ++ i) {
         
-        snprintf(str, 16, "%d", lb.scores[i]);
+        snprintf(str, 16, "%d", entries[i].score);
         draw_text(i == thisIndex ? bmpFont2 : bmpFont,str,x+8 + w/2,y+16 + i*yoff,-7,0, false);
     }
 }
@@ -240,35 +240,161 @@ static void name_input(float tm) {
 }
 
 
+// Show an error
+static void show_error() {
+
+    // Copy error
+    snprintf(errBuffer, ERROR_SIZE, "%s", error_get_message());
+
+    mode = LB_MENU_ERROR;
+    play_sample(sReject, 0.80f);
+}
+
+
+// Leave the menu
+static void leave_menu() {
+
+    if(isTitle)
+        core_swap_scene("title");
+    else
+        core_swap_scene("game");
+}
+
+
+// Find our score in the leaderboard, and show its page
+static void find_own() {
+
+    int score = (int)status_get_score(&game_get_state()->status);
+
+    ownIndex = -1;
+    int i = 0;
+    for(; i < lb.count && nameBuffer[0] != '\0'; ++ i) {
+
+        if(strcmp(lb.entries[i].name, nameBuffer) == 0
+         && lb.entries[i].score == score) {
+
+            ownIndex = i;
+            page = i / MEMBER_MAX;
+            break;
+        }
+    }
+
+    // The board may have shrunk
+    if(page >= lb_page_count(&lb))
+        page = 0;
+}
+
+
+// Remember the shown leaderboard
+static void store_cache() {
+
+    if(lb_cache_set(&cache, &lb, lb_get_etag()) == 1
+     || lb_cache_write(&cache, CACHE_PATH) == 1)
+        printf("Warning: %s\n", error_get_message());
+}
+
+
+// Hand the score over to the background upload
+static void release_score() {
+
+    if(scoreSeq == 0) return;
+
+    lb_queue_release(scoreSeq);
+    scoreSeq = 0;
+}
+
+
+// Forget the score, the server has it (or refused it)
+static void remove_score() {
+
+    if(scoreSeq == 0) return;
+
+    lb_queue_remove(scoreSeq);
+    scoreSeq = 0;
+}
+
+
 // Do sending/fetching
 static void do_sending(float tm, bool send) {
 
-    int state = -1;
+    int ret;
+
+    // Cancel
+    if(vpad_get_button(3) == STATE_PRESSED) {
+
+        if(requested)
+            lb_cancel();
+        requested = false;
+        toBeSent = false;
+        release_score();
+
+        play_sample(sReject, 0.70f);
+        leave_menu();
+        return;
+    }
+
     if(toBeSent) {
 
-        result = -1;
-        thrd_create(&T, send ? t_send_score : t_fetch_score, NULL);
+        // The score goes to the journal first, so it is
+        // not lost if sending fails
+        if(send && scoreSeq == 0
+         && lb_queue_add(nameBuffer, status_get_score(&game_get_state()->status), &scoreSeq) == 1) {
+
+            toBeSent = false;
+            show_error();
+            return;
+        }
+
+        // Wait for the background upload
+        if(lb_is_busy()) return;
         toBeSent = false;
+
+        ret = send 
+            ? lb_add_score_async(&lb, nameBuffer, status_get_score(&game_get_state()->status))
+            : lb_get_async(&lb);
+        if(ret == 1) {
+
+            release_score();
+            show_error();
+            return;
+        }
+        requested = true;
+
+        return;
     }
-    else {
 
-        mtx_lock(&mutex);
-        state = result;
-        mtx_unlock(&mutex);
+    if(!requested) return;
 
-        if(state != -1) {
+    switch(lb_poll()) {
 
-            if(state == 1) {
+    case LB_REQUEST_DONE:
+        requested = false;
+        remove_score();
+        store_cache();
+        find_own();
+        mode = LB_MENU_SHOW;
+        break;
 
-                // Copy error
-                snprintf(errBuffer, ERROR_SIZE, "%s", error_get_message());
+    case LB_REQUEST_REJECTED:
+        requested = false;
+        remove_score();
+        show_error();
+        break;
 
-                mode = LB_MENU_ERROR;
-                play_sample(sReject, 0.80f);
-            }
-            else 
-                mode = LB_MENU_SHOW;
+    case LB_REQUEST_FAILED:
+        requested = false;
+        show_error();
+
+        // Sent later
+        if(scoreSeq != 0) {
+
+            snprintf(errBuffer, ERROR_SIZE, "No connection. The\nscore is saved and\nsent later.");
+            release_score();
         }
+        break;
+
+    default:
+        break;
     }
 }
 
@@ -280,11 +406,7 @@ static void update_error_screen(float tm) {
        vpad_get_button(2) == STATE_PRESSED) {
 
         play_sample(sAccept, 0.80f);
-
-        if(isTitle)
-            core_swap_scene("title");
-        else
-            core_swap_scene("game");
+        leave_menu();
     }
 }
 
@@ -297,12 +419,104 @@ static void go_to_game() {
 }
 
 
+// Refresh the shown leaderboard in the background
+static void update_refresh() {
+
+    if(toBeRefreshed) {
+
+        // Wait for the background upload
+        if(lb_is_busy()) return;
+        toBeRefreshed = false;
+
+        requested = lb_refresh_async(&lb, cache.etag) == 0;
+        return;
+    }
+
+    if(!requested) return;
+
+    switch(lb_poll()) {
+
+    case LB_REQUEST_DONE:
+        requested = false;
+        store_cache();
+        find_own();
+        break;
+
+    case LB_REQUEST_NOT_MODIFIED:
+        requested = false;
+        cache.time = (Sint64)time(NULL);
+        if(lb_cache_write(&cache, CACHE_PATH) == 1)
+            printf("Warning: %s\n", error_get_message());
+        break;
+
+    // Keep showing the cached one
+    case LB_REQUEST_FAILED:
+    case LB_REQUEST_REJECTED:
+        requested = false;
+        break;
+
+    default:
+        break;
+    }
+}
+
+
+// Change the page (left & right) or the view (up &
+// down) with the stick
+static void update_page() {
+
+    VEC2 stick = vpad_get_stick();
+    if(fabsf(stick.x) < PAGE_DELTA && fabsf(stick.y) < PAGE_DELTA) {
+
+        stickHeld = false;
+        return;
+    }
+    if(stickHeld) return;
+    stickHeld = true;
+
+    int pages = lb_page_count(&lb);
+    int old = page;
+    if(stick.x > PAGE_DELTA && page < pages-1)
+        ++ page;
+    else if(stick.x < -PAGE_DELTA && page > 0)
+        -- page;
+
+    if(page != old) {
+
+        play_sample(sAccept, 0.50f);
+        return;
+    }
+
+    // Views are answered at once, no need to wait
+    // for the background upload
+    if(fabsf(stick.y) < PAGE_DELTA || requested || lb_is_busy())
+        return;
+
+    int v = (view + (stick.y > 0.0f ? 1 : LB_VIEW_COUNT-1)) % LB_VIEW_COUNT;
+    if(!lb_set_view(v)) return;
+
+    view = v;
+    page = 0;
+    toBeRefreshed = false;
+    requested = lb_get_async(&lb) == 0;
+    play_sample(sAccept, 0.50f);
+}
+
+
 // Update results screen
 static void update_results_screen(float tm) {
 
+    update_refresh();
+    update_page();
+
     if(vpad_get_button(0) == STATE_PRESSED ||
        vpad_get_button(2) == STATE_PRESSED) {
 
+        if(requested)
+            lb_cancel();
+        requested = false;
+        toBeRefreshed = false;
+
         play_sample(sAccept, 0.80f);
 
         if(isTitle)
@@ -335,19 +549,28 @@ static int lb_menu_init() {
         return 1;
 
     // Initialize leaderboards
-    // http://localhost:8000
-    if(lb_init_http("http://game-leaderboards.000webhostapp.com") == 1) {
+    CONFIG c = core_get_config();
+    offline = c.lbOffline;
+    if(offline) {
+
+        if(lb_init_offline(STORE_PATH) == 1)
+            return 1;
+    }
+    else if(lb_init_http(c.lbAddress[0] != '\0' ? c.lbAddress : DEFAULT_ADDRESS) == 1) {
 
         return 1;
     }
 
-    // Create a mutex
-    if(mtx_init(&mutex, mtx_plain) == thrd_error) {
+    // Read the scores that were not sent yet
+    if(lb_queue_init(JOURNAL_PATH) == 1) {
 
-        error_throw("Failed to create a mutex!", NULL);
         return 1;
     }
 
+    // Read the last leaderboard (if any)
+    if(lb_cache_read(&cache, CACHE_PATH) == 1)
+        error_flush();
+
     return 0;
 }
 
@@ -483,17 +706,33 @@ static void lb_menu_draw() {
 static void lb_menu_destroy() {
 
     // frame_destroy(canvasCopy);
-    // mtx_destroy(&mutex);
+    lb_queue_destroy();
+    if(offline)
+        lb_destroy_offline();
+    else
+        lb_destroy_http();
+    lb_free(&lb);
+    lb_free(&cache.lb);
 }
 
 
 // Swap
 static void lb_menu_on_change() {
 
+    toBeRefreshed = false;
     if(mode == LB_MENU_FETCHING) {
 
         toBeSent = true;
         isTitle = true;
+
+        // Show the cached leaderboard right away,
+        // and refresh it in the background
+        if(cache.valid && lb_copy(&lb, &cache.lb) == 0) {
+
+            mode = LB_MENU_SHOW;
+            toBeSent = false;
+            toBeRefreshed = true;
+        }
     }
     else {
 
@@ -505,6 +744,13 @@ static void lb_menu_on_change() {
     darkCount = 0;
     namePointer = 0;
     memset(nameBuffer,0,NAME_LENGTH);
+    page = 0;
+    stickHeld = true;
+    ownIndex = -1;
+
+    // Always start from the all-time board
+    view = LB_VIEW_ALL;
+    lb_set_view(view);
 
     // Create a copy of the canvas
     frame_copy(get_global_frame(), canvasCopy);
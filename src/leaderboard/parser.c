@@ -0,0 +1,111 @@
+// GOAT
+// Leaderboard response parser (source)
+// (c) 2018 Jani Nykänen
+
+#include "parser.h"
+
+#include "../engine/error.h"
+
+#include "../include/std.h"
+
+
+// Handle a complete line
+static int parse_line(LB_PARSER* p) {
+
+    // Line endings might be "\r\n"
+    if(p->lineLength > 0 && p->line[p->lineLength-1] == '\r')
+        -- p->lineLength;
+    p->line[p->lineLength] = '\0';
+
+    int len = p->lineLength;
+    p->lineLength = 0;
+
+    if(len == 0) return 0;
+    ++ p->lines;
+
+    // The first line says if the server accepted
+    if(p->lines == 1) {
+
+        snprintf(p->first, LB_LINE_SIZE, "%s", p->line);
+        return 0;
+    }
+
+    // Nothing is stored from a refusal
+    if(strcmp(p->first, "true") != 0)
+        return 0;
+
+    // Name & score lines after each other
+    if(p->lines % 2 == 0) {
+
+        snprintf(p->name, _NAME_LENGTH, "%.*s", _NAME_LENGTH-1, p->line);
+        return 0;
+    }
+    return lb_add_entry(p->lb, p->name, (int)strtol(p->line, NULL, 10));
+}
+
+
+// Start parsing a response
+void lb_parser_start(LB_PARSER* p, LEADERBOARD* lb) {
+
+    p->lb = lb;
+    p->lb->count = 0;
+    p->lineLength = 0;
+    p->first[0] = '\0';
+    p->lines = 0;
+    p->name[0] = '\0';
+    p->failed = false;
+}
+
+
+// Parse a chunk
+int lb_parser_feed(LB_PARSER* p, const char* data, size_t len) {
+
+    if(p->failed) return 1;
+
+    size_t i = 0;
+    for(; i < len; ++ i) {
+
+        if(data[i] == '\n') {
+
+            if(parse_line(p) == 1) {
+
+                p->failed = true;
+                return 1;
+            }
+            continue;
+        }
+
+        // Cut long lines, the rest is dropped
+        if(p->lineLength < LB_LINE_SIZE-1)
+            p->line[p->lineLength ++] = data[i];
+    }
+
+    return 0;
+}
+
+
+// Finish parsing
+int lb_parser_finish(LB_PARSER* p) {
+
+    // The last line may have no line break
+    if(!p->failed && p->lineLength > 0 && parse_line(p) == 1)
+        p->failed = true;
+
+    if(p->failed) return LB_PARSE_INVALID;
+
+    if(strcmp(p->first, "false") == 0) {
+
+        p->lb->count = 0;
+        error_throw("The server refused\nthe request!", NULL);
+        return LB_PARSE_REFUSED;
+    }
+
+    if(strcmp(p->first, "true") != 0) {
+
+        p->lb->count = 0;
+        error_throw("Expected true, got ", p->first);
+        return LB_PARSE_INVALID;
+    }
+
+    return LB_PARSE_OK;
+}
@@ -0,0 +1,51 @@
+// GOAT
+// Leaderboard response parser (header)
+// (c) 2018 Jani Nykänen
+
+#ifndef __LB_PARSER__
+#define __LB_PARSER__
+
+#include "leaderboard.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Line buffer size. Longer lines are cut, no
+// name or score needs more
+#define LB_LINE_SIZE 64
+
+// Results of a response
+enum {
+
+    LB_PARSE_OK = 0,
+    LB_PARSE_REFUSED = 1, // "false", the server said no
+    LB_PARSE_INVALID = 2, // Not a response of the server
+};
+
+// Parser. Reads the response ("true", then name
+// and score lines) a chunk at a time, as it arrives
+typedef struct {
+
+    LEADERBOARD* lb; // Rows are added here
+    char line[LB_LINE_SIZE]; // Current line
+    int lineLength;
+    char first[LB_LINE_SIZE]; // First line
+    int lines; // Non-empty lines so far
+    LB_NAME name; // Name of the current row
+    bool failed;
+}
+LB_PARSER;
+
+// Start parsing a response. The leaderboard is emptied
+void lb_parser_start(LB_PARSER* p, LEADERBOARD* lb);
+
+// Parse a chunk. Returns 1 on error
+int lb_parser_feed(LB_PARSER* p, const char* data, size_t len);
+
+// Finish parsing. Returns LB_PARSE_REFUSED only if
+// the server answered "false". Anything else than
+// "true" (a proxy or a login page) is LB_PARSE_INVALID.
+// The reason is in the error
+int lb_parser_finish(LB_PARSER* p);
+
+#endif // __LB_PARSER__
@@ -0,0 +1,233 @@
+// GOAT
+// Score queue (source)
+// (c) 2018 Jani Nykänen
+
+#include "queue.h"
+
+#include "journal.h"
+#include "leaderboard.h"
+
+#include "../engine/error.h"
+#include "../engine/rng.h"
+
+#include "../include/std.h"
+
+// Retry delays (in milliseconds)
+static const Uint32 BACKOFF_MIN = 2000;
+static const Uint32 BACKOFF_MAX = 5 * 60 * 1000;
+
+// Journal
+static JOURNAL journal;
+// Is initialized
+static bool initialized;
+
+// Held score, not uploaded in the background (0 if none)
+static Uint32 held;
+
+// Scores being uploaded
+static Uint32 inFlight[LB_BATCH_MAX];
+static int inFlightCount;
+static bool uploading;
+static bool usedBatch;
+// Does the server know batches
+static bool batchSupported;
+// Leaderboard returned by the uploads (not shown)
+static LEADERBOARD response;
+
+// Retry timing
+static Uint32 backoff;
+static Uint32 nextTry;
+static RNG rng;
+
+
+// Schedule the next try after a failure. The delay
+// doubles on each failure, with some jitter so that
+// the cabinets of a venue do not retry together
+static void schedule_retry(Uint32 now) {
+
+    nextTry = now + backoff * 3/4 + (Uint32)rng_range(&rng, (int)(backoff/2) +1);
+    backoff = backoff*2 > BACKOFF_MAX ? BACKOFF_MAX : backoff*2;
+}
+
+
+// Acknowledge the scores in flight
+static void ack_in_flight() {
+
+    if(journal_ack(&journal, inFlight, inFlightCount) == 1)
+        printf("Warning: %s\n", error_get_message());
+}
+
+
+// Start uploading pending scores
+static void start_upload() {
+
+    LB_ENTRY entries[LB_BATCH_MAX];
+    int max = batchSupported ? LB_BATCH_MAX : 1;
+    int i = 0;
+
+    inFlightCount = 0;
+    for(; i < journal.pendingCount && inFlightCount < max; ++ i) {
+
+        if(journal.pending[i].seq == held) continue;
+
+        inFlight[inFlightCount] = journal.pending[i].seq;
+        entries[inFlightCount] = journal.pending[i].entry;
+        ++ inFlightCount;
+    }
+    if(inFlightCount == 0) return;
+
+    usedBatch = batchSupported;
+    int ret = usedBatch
+        ? lb_add_scores_async(&response, entries, inFlightCount)
+        : lb_add_score_async(&response, entries[0].name, entries[0].score);
+
+    if(ret == 1) {
+
+        schedule_retry(SDL_GetTicks());
+        return;
+    }
+    uploading = true;
+}
+
+
+// Initialize the score queue
+int lb_queue_init(const char* path) {
+
+    // Keep going without the file, the scores are
+    // still queued for this session
+    if(journal_open(&journal, path) == 1)
+        printf("Warning: %s\n", error_get_message());
+
+    if(journal.pendingCount > 0)
+        printf("%d score(s) waiting to be sent.\n", journal.pendingCount);
+
+    held = 0;
+    uploading = false;
+    batchSupported = true;
+    backoff = BACKOFF_MIN;
+    nextTry = SDL_GetTicks();
+    rng_seed(&rng, (Uint64)time(NULL), 0);
+
+    initialized = true;
+
+    return 0;
+}
+
+
+// Add a score
+int lb_queue_add(const char* name, int score, Uint32* seq) {
+
+    if(!initialized) {
+
+        error_throw("The score queue is\nnot initialized!", NULL);
+        return 1;
+    }
+
+    Uint32 s;
+    if(journal_append(&journal, name, score, &s) == 1)
+        return 1;
+
+    // The caller sends this one itself
+    held = s;
+    if(seq != NULL)
+        *seq = s;
+
+    return 0;
+}
+
+
+// Remove a score
+void lb_queue_remove(Uint32 seq) {
+
+    if(!initialized) return;
+
+    if(held == seq)
+        held = 0;
+
+    if(journal_ack(&journal, &seq, 1) == 1)
+        printf("Warning: %s\n", error_get_message());
+}
+
+
+// Release a held score
+void lb_queue_release(Uint32 seq) {
+
+    if(held == seq)
+        held = 0;
+}
+
+
+// Upload the pending scores
+void lb_queue_update() {
+
+    if(!initialized) return;
+
+    Uint32 now = SDL_GetTicks();
+
+    if(uploading) {
+
+        switch(lb_poll()) {
+
+        case LB_REQUEST_PENDING:
+            return;
+
+        case LB_REQUEST_DONE:
+            ack_in_flight();
+            backoff = BACKOFF_MIN;
+            nextTry = now;
+            break;
+
+        case LB_REQUEST_REJECTED:
+
+            // Old servers answer "false" to a batch
+            if(usedBatch) {
+
+                printf("Batches refused, sending scores one by one.\n");
+                batchSupported = false;
+            }
+            // Retrying a refused score does not help
+            else {
+
+                printf("Dropping a refused score: %s\n", error_get_message());
+                ack_in_flight();
+            }
+            nextTry = now;
+            break;
+
+        default:
+            schedule_retry(now);
+            break;
+        }
+
+        uploading = false;
+        return;
+    }
+
+    if(journal.pendingCount == 0 || lb_is_busy()
+     || (Sint32)(now - nextTry) < 0)
+        return;
+
+    start_upload();
+}
+
+
+// Get the number of pending scores
+int lb_queue_pending() {
+
+    return journal.pendingCount;
+}
+
+
+// Destroy the score queue
+void lb_queue_destroy() {
+
+    if(!initialized) return;
+
+    if(uploading)
+        lb_cancel();
+    uploading = false;
+
+    journal_close(&journal);
+    lb_free(&response);
+    initialized = false;
+}
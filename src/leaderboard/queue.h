@@ -0,0 +1,39 @@
+// GOAT
+// Score queue (header)
+// (c) 2018 Jani Nykänen
+
+#ifndef __LB_QUEUE__
+#define __LB_QUEUE__
+
+#include <SDL2/SDL.h>
+
+#include <stdbool.h>
+
+// Initialize the score queue. Pending scores are
+// read from the journal file
+int lb_queue_init(const char* path);
+
+// Add a score. It is in the journal before anything
+// is sent. The score is held, so that the caller can
+// send it first. Returns 1 on error
+int lb_queue_add(const char* name, int score, Uint32* seq);
+
+// Release a held score to the background upload
+void lb_queue_release(Uint32 seq);
+
+// Remove a score that got to the server (or that the
+// server refused) some other way
+void lb_queue_remove(Uint32 seq);
+
+// Upload the pending scores in the background, call
+// once per frame. Only starts a request when the
+// leaderboard client is idle
+void lb_queue_update();
+
+// Get the number of pending scores
+int lb_queue_pending();
+
+// Destroy the score queue
+void lb_queue_destroy();
+
+#endif // __LB_QUEUE__
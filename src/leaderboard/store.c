@@ -0,0 +1,486 @@
+// GOAT
+// Offline score store (source)
+// (c) 2018 Jani Nykänen
+
+#include "store.h"
+
+#include "../engine/error.h"
+
+#include "../include/std.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <stddef.h>
+
+// Record magic ("GLBS")
+#define RECORD_MAGIC 0x53424C47
+// Index magic ("GLBI") & version
+#define INDEX_MAGIC 0x49424C47
+#define INDEX_VERSION 1
+// Records read at once on replay
+#define REPLAY_BLOCK 1024
+
+// Replaying more than this on open saves the index
+static const Uint32 REPLAY_SAVE = 4096;
+
+// Log record
+typedef struct {
+
+    Uint32 magic;
+    Sint32 score;
+    Sint64 time;
+    LB_NAME name;
+    Uint32 checksum;
+}
+RECORD;
+
+// Index file header, followed by the views
+typedef struct {
+
+    Uint32 magic;
+    Uint32 version;
+    Uint32 records;
+    Uint32 checksum;
+}
+HEADER;
+
+// Replay buffer
+static RECORD block[REPLAY_BLOCK];
+
+
+// Continue a checksum (FNV-1a)
+static Uint32 checksum(Uint32 h, const void* p, size_t size) {
+
+    const Uint8* data = (const Uint8*)p;
+    size_t i = 0;
+    for(; i < size; ++ i) {
+
+        h ^= data[i];
+        h *= 16777619u;
+    }
+
+    return h;
+}
+
+
+// Compute the checksum of a record
+static Uint32 record_checksum(const RECORD* r) {
+
+    return checksum(2166136261u, r, offsetof(RECORD, checksum));
+}
+
+
+// Flush a file to the disk
+static int sync_file(FILE* f) {
+
+    if(fflush(f) != 0) return 1;
+
+#ifdef _WIN32
+    return _commit(_fileno(f)) == 0 ? 0 : 1;
+#else
+    return fsync(fileno(f)) == 0 ? 0 : 1;
+#endif
+}
+
+
+// Cut a file to a length
+static int truncate_file(FILE* f, long length) {
+
+    if(fflush(f) != 0) return 1;
+
+#ifdef _WIN32
+    return _chsize_s(_fileno(f), length) == 0 ? 0 : 1;
+#else
+    return ftruncate(fileno(f), length) == 0 ? 0 : 1;
+#endif
+}
+
+
+// Get the number of a date (days since 1970-01-01)
+static Sint32 date_number(int y, int m, int d) {
+
+    y -= m <= 2;
+    int era = (y >= 0 ? y : y-399) / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d-1;
+    int doe = yoe * 365 + yoe/4 - yoe/100 + doy;
+
+    return era * 146097 + doe - 719468;
+}
+
+
+// Get the local day of a time. The last day is kept,
+// since the times mostly come in order
+static Sint32 day_of(LB_STORE* s, Sint64 t) {
+
+    if(t >= s->dayStart && t < s->dayEnd)
+        return s->day;
+
+    time_t tt = (time_t)t;
+    struct tm* lt = localtime(&tt);
+    if(lt == NULL) return 0;
+
+    struct tm tm = *lt;
+    s->day = date_number(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+
+    tm.tm_hour = 0;
+    tm.tm_min = 0;
+    tm.tm_sec = 0;
+    tm.tm_isdst = -1;
+    s->dayStart = (Sint64)mktime(&tm);
+
+    ++ tm.tm_mday;
+    tm.tm_isdst = -1;
+    s->dayEnd = (Sint64)mktime(&tm);
+
+    return s->day;
+}
+
+
+// Get the period of a view at a time. Weeks start
+// on Monday (1970-01-01 was a Thursday)
+static Sint32 period_of(LB_STORE* s, int view, Sint64 t) {
+
+    switch(view) {
+
+    case LB_VIEW_DAY:
+        return day_of(s, t);
+
+    case LB_VIEW_WEEK:
+        return (day_of(s, t) + 3) / 7;
+
+    default:
+        return 0;
+    }
+}
+
+
+// Insert an entry to a view, if it is good enough
+static void insert(LB_TOP* v, Sint32 period, const LB_ENTRY* e) {
+
+    // A new period starts empty, and an older one
+    // (the clock was set back) is ignored
+    if(period != v->period) {
+
+        if(period < v->period) return;
+
+        v->period = period;
+        v->count = 0;
+    }
+
+    if(v->count == LB_STORE_TOP && e->score <= v->entries[LB_STORE_TOP-1].score)
+        return;
+
+    // After the equal scores, so the older one stays first
+    int lo = 0;
+    int hi = v->count;
+    int mid;
+    while(lo < hi) {
+
+        mid = (lo + hi) / 2;
+        if(v->entries[mid].score >= e->score)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    // The last one drops out of a full view
+    int n = v->count < LB_STORE_TOP ? v->count : LB_STORE_TOP-1;
+    memmove(&v->entries[lo+1], &v->entries[lo], sizeof(LB_ENTRY) * (n - lo));
+    v->entries[lo] = *e;
+
+    if(v->count < LB_STORE_TOP)
+        ++ v->count;
+}
+
+
+// Add a record to the views
+static void index_record(LB_STORE* s, const RECORD* r) {
+
+    LB_ENTRY e;
+    memset(&e, 0, sizeof(LB_ENTRY));
+    snprintf(e.name, _NAME_LENGTH, "%s", r->name);
+    e.score = r->score;
+
+    int i = 0;
+    for(; i < LB_VIEW_COUNT; ++ i) {
+
+        insert(&s->views[i], period_of(s, i, r->time), &e);
+    }
+}
+
+
+// Empty the views
+static void clear_views(LB_STORE* s) {
+
+    memset(s->views, 0, sizeof(s->views));
+    s->records = 0;
+}
+
+
+// Read the index. The views are empty if this fails
+static void read_index(LB_STORE* s) {
+
+    char idxPath[LB_STORE_PATH_SIZE + 8];
+    snprintf(idxPath, sizeof(idxPath), "%s.idx", s->path);
+
+    FILE* f = fopen(idxPath, "rb");
+    if(f == NULL) return;
+
+    HEADER h;
+    bool ok = fread(&h, sizeof(HEADER), 1, f) == 1
+        && h.magic == INDEX_MAGIC
+        && h.version == INDEX_VERSION
+        && fread(s->views, sizeof(s->views), 1, f) == 1
+        && h.checksum == checksum(2166136261u, s->views, sizeof(s->views));
+    fclose(f);
+
+    int i = 0;
+    for(; i < LB_VIEW_COUNT && ok; ++ i) {
+
+        ok = s->views[i].count >= 0 && s->views[i].count <= LB_STORE_TOP;
+    }
+
+    if(!ok) {
+
+        clear_views(s);
+        return;
+    }
+    s->records = h.records;
+}
+
+
+// Write the index. The new file is synced before it
+// replaces the old one
+static int write_index(LB_STORE* s) {
+
+    char idxPath[LB_STORE_PATH_SIZE + 8];
+    char tmpPath[LB_STORE_PATH_SIZE + 12];
+    snprintf(idxPath, sizeof(idxPath), "%s.idx", s->path);
+    snprintf(tmpPath, sizeof(tmpPath), "%s.idx.tmp", s->path);
+
+    // The index must not get ahead of the log
+    if(sync_file(s->log) != 0) {
+
+        error_throw("Failed to write the score log to ", s->path);
+        return 1;
+    }
+
+    FILE* f = fopen(tmpPath, "wb");
+    if(f == NULL) {
+
+        error_throw("Failed to create a file in ", tmpPath);
+        return 1;
+    }
+
+    HEADER h;
+    h.magic = INDEX_MAGIC;
+    h.version = INDEX_VERSION;
+    h.records = s->records;
+    h.checksum = checksum(2166136261u, s->views, sizeof(s->views));
+
+    bool ok = fwrite(&h, sizeof(HEADER), 1, f) == 1
+        && fwrite(s->views, sizeof(s->views), 1, f) == 1
+        && sync_file(f) == 0;
+
+    if(fclose(f) != 0 || !ok) {
+
+        error_throw("Failed to write the index to ", tmpPath);
+        return 1;
+    }
+
+#ifdef _WIN32
+    remove(idxPath);
+#endif
+    if(rename(tmpPath, idxPath) != 0) {
+
+        error_throw("Failed to replace the index in ", idxPath);
+        return 1;
+    }
+
+    return 0;
+}
+
+
+// Replay the log after the indexed records. Returns
+// the number of records replayed
+static Uint32 replay(LB_STORE* s) {
+
+    fseek(s->log, 0, SEEK_END);
+    long size = ftell(s->log);
+
+    // The log is shorter than the index says (lost on
+    // a power cut, or replaced), start over
+    if(size < 0 || (Uint64)size < (Uint64)s->records * sizeof(RECORD))
+        clear_views(s);
+
+    fseek(s->log, (long)(s->records * sizeof(RECORD)), SEEK_SET);
+
+    Uint32 start = s->records;
+    size_t n, i;
+    bool ok = true;
+    while(ok && (n = fread(block, sizeof(RECORD), REPLAY_BLOCK, s->log)) > 0) {
+
+        for(i = 0; i < n; ++ i) {
+
+            // Anything after a broken record is unreliable
+            if(block[i].magic != RECORD_MAGIC
+             || block[i].checksum != record_checksum(&block[i])) {
+
+                ok = false;
+                break;
+            }
+            block[i].name[_NAME_LENGTH-1] = '\0';
+
+            index_record(s, &block[i]);
+            ++ s->records;
+        }
+    }
+
+    // Drop a torn or broken tail
+    long valid = (long)(s->records * sizeof(RECORD));
+    if(size > valid && truncate_file(s->log, valid) != 0)
+        printf("Warning: failed to repair the score log %s\n", s->path);
+
+    fseek(s->log, 0, SEEK_END);
+
+    return s->records - start;
+}
+
+
+// Open a store
+int lb_store_open(LB_STORE* s, const char* path) {
+
+    snprintf(s->path, LB_STORE_PATH_SIZE, "%s", path);
+    clear_views(s);
+    s->dayStart = 0;
+    s->dayEnd = 0;
+    s->day = 0;
+
+    s->log = fopen(path, "ab+");
+    if(s->log == NULL) {
+
+        error_throw("Failed to open a file in ", path);
+        return 1;
+    }
+
+    read_index(s);
+    if(replay(s) >= REPLAY_SAVE && write_index(s) == 1)
+        printf("Warning: %s\n", error_get_message());
+
+    return 0;
+}
+
+
+// Add scores. The records are written together, and
+// cut off again if any of them fails, so a failed batch
+// leaves nothing behind to duplicate on a retry
+int lb_store_add(LB_STORE* s, const LB_ENTRY* entries, int count) {
+
+    Sint64 now = (Sint64)time(NULL);
+    bool ok = true;
+
+    int i = 0;
+    int n;
+    int j;
+    RECORD* r;
+    for(; i < count; i += n) {
+
+        n = count - i < REPLAY_BLOCK ? count - i : REPLAY_BLOCK;
+        for(j = 0; j < n; ++ j) {
+
+            r = &block[j];
+            memset(r, 0, sizeof(RECORD));
+            r->magic = RECORD_MAGIC;
+            r->score = entries[i+j].score;
+            r->time = now;
+            snprintf(r->name, _NAME_LENGTH, "%s", entries[i+j].name);
+            r->checksum = record_checksum(r);
+        }
+
+        if(s->log != NULL && fwrite(block, sizeof(RECORD), n, s->log) != (size_t)n) {
+
+            ok = false;
+            break;
+        }
+    }
+
+    // Flushed but not synced, that would take longer
+    // than the rest. The index is synced on close
+    if(s->log != NULL && (!ok || fflush(s->log) != 0)) {
+
+        if(truncate_file(s->log, (long)(s->records * sizeof(RECORD))) != 0)
+            printf("Warning: failed to repair the score log %s\n", s->path);
+        clearerr(s->log);
+        fseek(s->log, 0, SEEK_END);
+
+        error_throw("Failed to write the score log to ", s->path);
+        return 1;
+    }
+
+    // Index only once everything is in the log. The
+    // records are built again, the buffer only holds
+    // the last block
+    for(i = 0; i < count; ++ i) {
+
+        RECORD rec;
+        memset(&rec, 0, sizeof(RECORD));
+        rec.score = entries[i].score;
+        rec.time = now;
+        snprintf(rec.name, _NAME_LENGTH, "%s", entries[i].name);
+
+        index_record(s, &rec);
+        ++ s->records;
+    }
+
+    return 0;
+}
+
+
+// Get the best scores of a view
+int lb_store_get(LB_STORE* s, int view, LEADERBOARD* lb) {
+
+    if(view < 0 || view >= LB_VIEW_COUNT)
+        view = LB_VIEW_ALL;
+
+    lb->count = 0;
+
+    // Nothing yet in this period
+    LB_TOP* v = &s->views[view];
+    if(v->period != period_of(s, view, (Sint64)time(NULL)))
+        return 0;
+
+    int i = 0;
+    for(; i < v->count; ++ i) {
+
+        if(lb_add_entry(lb, v->entries[i].name, v->entries[i].score) == 1)
+            return 1;
+    }
+
+    return 0;
+}
+
+
+// Get a tag that changes whenever the view does
+void lb_store_get_tag(LB_STORE* s, int view, char* tag, int size) {
+
+    snprintf(tag, size, "\"%u-%d-%d\"", (unsigned int)s->records,
+        view, (int)period_of(s, view, (Sint64)time(NULL)));
+}
+
+
+// Close a store
+void lb_store_close(LB_STORE* s) {
+
+    if(s->log == NULL) return;
+
+    if(write_index(s) == 1)
+        printf("Warning: %s\n", error_get_message());
+
+    fclose(s->log);
+    s->log = NULL;
+}
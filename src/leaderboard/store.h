@@ -0,0 +1,67 @@
+// GOAT
+// Offline score store (header)
+// (c) 2018 Jani Nykänen
+
+#ifndef __LB_STORE__
+#define __LB_STORE__
+
+#include <SDL2/SDL.h>
+
+#include "leaderboard.h"
+
+#include <stdio.h>
+#include <stdbool.h>
+
+// Best scores kept per view
+#define LB_STORE_TOP 1000
+// Path buffer size
+#define LB_STORE_PATH_SIZE 128
+
+// Best scores of a view, best first
+typedef struct {
+
+    LB_ENTRY entries[LB_STORE_TOP];
+    int count;
+    Sint32 period; // Day or week number (0 for all time)
+}
+LB_TOP;
+
+// Score store. Every score is appended to a log file,
+// and the best ones of each view are kept sorted in
+// memory. The views are saved to an index file on
+// close, so only the newer part of the log is read
+// on open
+typedef struct {
+
+    FILE* log;
+    char path[LB_STORE_PATH_SIZE];
+
+    LB_TOP views[LB_VIEW_COUNT];
+    Uint32 records; // In the log
+
+    // Last day looked up (local time)
+    Sint64 dayStart;
+    Sint64 dayEnd;
+    Sint32 day;
+}
+LB_STORE;
+
+// Open a store, and create the files if needed. If
+// the log cannot be used, the store works in memory
+// only and 1 is returned
+int lb_store_open(LB_STORE* s, const char* path);
+
+// Add scores. Either all of them are added or none
+// is. Returns 1 on error
+int lb_store_add(LB_STORE* s, const LB_ENTRY* entries, int count);
+
+// Get the best scores of a view. Returns 1 on error
+int lb_store_get(LB_STORE* s, int view, LEADERBOARD* lb);
+
+// Get a tag that changes whenever the view does
+void lb_store_get_tag(LB_STORE* s, int view, char* tag, int size);
+
+// Close a store, and save the index
+void lb_store_close(LB_STORE* s);
+
+#endif // __LB_STORE__
@@ -13,9 +13,27 @@
 #include "title/intro.h"
 #include "global.h"
 
+#include "game/sim.h"
+#include "leaderboard/bench.h"
+#include "engine/mixbench.h"
+
+#include <string.h>
+
 
 // Main
 int main(int argc, char** argv) {
+
+    // Headless batch runs, no window
+    if(argc > 1 && strcmp(argv[1], "--batch") == 0)
+        return sim_main(argc, argv);
+
+    // Leaderboard client bench, no window
+    if(argc > 1 && strcmp(argv[1], "--lb-bench") == 0)
+        return lb_bench_main(argc, argv);
+
+    // Software mixer bench, no audio device
+    if(argc > 1 && strcmp(argv[1], "--mix-bench") == 0)
+        return mix_bench_main(argc, argv);
     
     // Add scenes
     core_add_scene(global_get_scene());
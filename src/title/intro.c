@@ -86,7 +86,7 @@ static void intro_draw() {
         128 - 72, 96-48, 0);
 
     if(dvalue > 0)
-        darken(dvalue);
+        set_palette_darkness(dvalue);
 }
 
 
@@ -91,7 +91,7 @@ static void draw_menu_text(int x, int y, int yoff) {
         if(i == 3 && !audioState)
             text = AUDIO_TEXT_OFF;
 
-        draw_text( (cursor.moving || (cursor.pos != i)) ? bmpFont : bmpFont2, 
+        draw_text_cached( (cursor.moving || (cursor.pos != i)) ? bmpFont : bmpFont2, 
             text,x,y +yoff*i,-7,0,false);
     }
 }
@@ -276,7 +276,7 @@ static void ts_draw() {
     translate(0, 0);
 
     // Draw stage background
-    stage_draw();
+    stage_draw(&game_get_state()->stage);
 
     // Darken
     int dark = 4;
@@ -322,14 +322,14 @@ static void ts_draw() {
     }
 
     // Draw copyright
-    draw_text(bmpFont, "# 2018 Jani Nyk~nen",128,192-14, -7,0, true);
+    draw_text_cached(bmpFont, "# 2018 Jani Nyk~nen",128,192-14, -7,0, true);
 }
 
 
 // Swap
 static void ts_on_change() {
 
-    stage_reset();
+    stage_reset(&game_get_state()->stage);
     goingAway = false;
     goAway = 0.0f;
 
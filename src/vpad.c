@@ -29,12 +29,30 @@ static VEC2 delta;
 // Buttons
 static BUTTON buttons[BUTTON_MAX];
 
+// Driver
+static VPAD_DRIVER driver;
+// Button states set by the driver, -1 if not set
+static int driven[VPAD_DRIVEN_MAX];
+
+
+// Clear the driven button states
+static void clear_driven() {
+
+    int i = 0;
+    for(; i < VPAD_DRIVEN_MAX; ++ i) {
+
+        driven[i] = -1;
+    }
+}
+
 
 // Initialize virtual gamepad
 void vpad_init()
 {
     stick.x = 0.0f;
     stick.y = 0.0f;
+
+    clear_driven();
 }
 
 
@@ -73,6 +91,13 @@ void vpad_update()
         stick.y = jstick.y;   
     }
 
+    // Let the driver override the devices
+    if(driver != NULL) {
+
+        clear_driven();
+        driver(&stick, driven);
+    }
+
     // Calculate delta
     delta.x = stick.x - oldStick.x;
     delta.y = stick.y - oldStick.y;
@@ -103,6 +128,9 @@ void vpad_add_button(unsigned char index, int scancode, int joybutton) {
 // Get virtual pad button state
 int vpad_get_button(unsigned char index) {
 
+    if(index < VPAD_DRIVEN_MAX && driven[index] != -1)
+        return driven[index];
+
     int ret = input_get_key(buttons[index].scancode);
     if(ret == STATE_UP) {
     
@@ -120,6 +148,14 @@ void vpad_flush_stick() {
     stick.y = 0.0f;
 }
 
+// Set the driver
+void vpad_set_driver(VPAD_DRIVER drv) {
+
+    clear_driven();
+    driver = drv;
+}
+
+
 // Read configuration file
 void vpad_read_config(const char* path) {
 
@@ -8,6 +8,14 @@
 #include "engine/input.h"
 #include "engine/vector.h"
 
+// Max buttons a driver can set
+#define VPAD_DRIVEN_MAX 8
+
+// Virtual gamepad driver. Called at the end of the
+// update, it may overwrite the stick and set button
+// states (-1 leaves a button to the real devices)
+typedef void (*VPAD_DRIVER) (VEC2* stick, int* buttons);
+
 // Initialize virtual gamepad
 void vpad_init();
 
@@ -29,6 +37,9 @@ int vpad_get_button(unsigned char index);
 // Set stick position to zero
 void vpad_flush_stick();
 
+// Set the driver, NULL for none
+void vpad_set_driver(VPAD_DRIVER drv);
+
 // Read configuration file
 void vpad_read_config(const char* path);
 
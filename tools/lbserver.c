@@ -0,0 +1,520 @@
+// GOAT
+// Leaderboard stand-in server (source)
+// (c) 2018 Jani Nykänen
+
+// A local stand-in for the leaderboard server, for
+// testing the client. Speaks the same protocol:
+//
+//   /?&mode=get
+//   /?&mode=set&name=N&score=S&check=C
+//   /?&mode=setmany&count=K&name0=..&score0=..&check0=..
+//
+// answered with "true" (or "false") and name/score
+// lines of the top scores. The path before "/?" picks
+// a fault mode:
+//
+//   /slow      answer after a delay
+//   /stall     never answer
+//   /truncate  close the connection mid-body
+//   /oversize  answer with more rows than fit in 1 KB
+//   /many      answer with more rows than MEMBER_MAX
+//   /large     answer with a top-1000 board
+//   /error     answer with HTTP 500
+//   /nobatch   refuse "setmany", like old servers
+//   /portal    answer with an HTML page, like a
+//              captive portal
+//
+// Build with "make lbserver", run with
+// "./lbserver [port] [slow delay in ms]". POSIX only
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+// Limits
+#define MAX_CONNECTIONS 256
+#define REQUEST_SIZE 4096
+#define RESPONSE_SIZE 65536
+#define MAX_SCORES 65536
+#define NAME_SIZE 32
+#define TOP_COUNT 10
+
+// Check value (same as the client)
+#define CHECK_MOD 1023
+#define CHECK_MUL 255
+
+// Row counts of the fault modes
+static const int OVERSIZE_ROWS = 200;
+static const int MANY_ROWS = 20;
+static const int LARGE_ROWS = 1000;
+
+// Fault modes
+enum {
+
+    FAULT_NONE = 0,
+    FAULT_SLOW,
+    FAULT_STALL,
+    FAULT_TRUNCATE,
+    FAULT_OVERSIZE,
+    FAULT_MANY,
+    FAULT_LARGE,
+    FAULT_ERROR,
+    FAULT_NOBATCH,
+    FAULT_PORTAL,
+};
+
+// Connection
+typedef struct {
+
+    int fd;
+    char request[REQUEST_SIZE];
+    int requestLength;
+
+    char response[RESPONSE_SIZE];
+    int responseLength;
+    int responseSent;
+    long long sendAt; // When the response may be sent (ms)
+    bool closeAfter;
+    bool stalled;
+}
+CONNECTION;
+
+// Score
+typedef struct {
+
+    char name[NAME_SIZE];
+    int score;
+}
+SCORE;
+
+// Connections
+static CONNECTION connections[MAX_CONNECTIONS];
+static int connectionCount;
+// Total connections & requests
+static long totalConnections;
+static long totalRequests;
+
+// Scores
+static SCORE scores[MAX_SCORES];
+static int scoreCount;
+// Bumped whenever the scores change, used as the ETag
+static int version;
+
+// Slow mode delay (ms)
+static int slowDelay = 1500;
+
+
+// Get the time in milliseconds
+static long long now_ms() {
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+
+// Get a query parameter. Returns false if not found
+static bool get_param(const char* query, const char* key, char* out, int size) {
+
+    size_t n = strlen(key);
+    const char* p = query;
+
+    while((p = strstr(p, key)) != NULL) {
+
+        // Must be a whole key
+        if((p == query || p[-1] == '&' || p[-1] == '?') && p[n] == '=') {
+
+            p += n+1;
+            int i = 0;
+            for(; i < size-1 && p[i] != '\0' && p[i] != '&' && p[i] != ' '; ++ i) {
+
+                out[i] = p[i];
+            }
+            out[i] = '\0';
+            return true;
+        }
+        p += n;
+    }
+
+    return false;
+}
+
+
+// Is a score valid
+static bool check_score(const char* name, int score, int check) {
+
+    return name[0] != '\0' && score >= 0 && (score * CHECK_MUL) % CHECK_MOD == check;
+}
+
+
+// Add a score, keeping the list sorted
+static void add_score(const char* name, int score) {
+
+    int i = scoreCount < MAX_SCORES ? scoreCount ++ : MAX_SCORES-1;
+    if(i == MAX_SCORES-1 && scores[i].score >= score) return;
+
+    for(; i > 0 && scores[i-1].score < score; -- i) {
+
+        scores[i] = scores[i-1];
+    }
+    snprintf(scores[i].name, NAME_SIZE, "%s", name);
+    scores[i].score = score;
+
+    ++ version;
+}
+
+
+// Write the rows of a body
+static int write_rows(char* out, int size, int fault) {
+
+    int len = 0;
+    int i = 0;
+
+    // Made up rows
+    if(fault == FAULT_OVERSIZE || fault == FAULT_MANY || fault == FAULT_LARGE) {
+
+        int rows = fault == FAULT_OVERSIZE ? OVERSIZE_ROWS
+            : (fault == FAULT_MANY ? MANY_ROWS : LARGE_ROWS);
+        for(; i < rows && len < size; ++ i) {
+
+            len += snprintf(out + len, size - len, "ROW%d\n%d\n", i, rows - i);
+        }
+        return len;
+    }
+
+    for(; i < TOP_COUNT && len < size; ++ i) {
+
+        if(i < scoreCount)
+            len += snprintf(out + len, size - len, "%s\n%d\n", scores[i].name, scores[i].score);
+        else
+            len += snprintf(out + len, size - len, "-\n0\n");
+    }
+
+    return len;
+}
+
+
+// Handle the query of a request. Returns true if the
+// request was accepted
+static bool handle_query(const char* query, int fault) {
+
+    char mode[32] = "";
+    char name[NAME_SIZE];
+    char value[32];
+    char key[32];
+    int score, check, count, i;
+
+    get_param(query, "mode", mode, sizeof(mode));
+
+    if(strcmp(mode, "get") == 0) {
+
+        return true;
+    }
+    else if(strcmp(mode, "set") == 0) {
+
+        if(!get_param(query, "name", name, NAME_SIZE)) return false;
+        score = get_param(query, "score", value, sizeof(value)) ? atoi(value) : -1;
+        check = get_param(query, "check", value, sizeof(value)) ? atoi(value) : -1;
+
+        if(!check_score(name, score, check)) return false;
+        add_score(name, score);
+        return true;
+    }
+    else if(strcmp(mode, "setmany") == 0 && fault != FAULT_NOBATCH) {
+
+        count = get_param(query, "count", value, sizeof(value)) ? atoi(value) : 0;
+        if(count <= 0) return false;
+
+        // All or nothing
+        for(i = 0; i < count; ++ i) {
+
+            snprintf(key, sizeof(key), "name%d", i);
+            if(!get_param(query, key, name, NAME_SIZE)) return false;
+            snprintf(key, sizeof(key), "score%d", i);
+            score = get_param(query, key, value, sizeof(value)) ? atoi(value) : -1;
+            snprintf(key, sizeof(key), "check%d", i);
+            check = get_param(query, key, value, sizeof(value)) ? atoi(value) : -1;
+
+            if(!check_score(name, score, check)) return false;
+        }
+        for(i = 0; i < count; ++ i) {
+
+            snprintf(key, sizeof(key), "name%d", i);
+            get_param(query, key, name, NAME_SIZE);
+            snprintf(key, sizeof(key), "score%d", i);
+            get_param(query, key, value, sizeof(value));
+            add_score(name, atoi(value));
+        }
+        return true;
+    }
+
+    return false;
+}
+
+
+// Build the response to a request
+static void handle_request(CONNECTION* c, char* req) {
+
+    char body[RESPONSE_SIZE / 2];
+    char etag[32];
+    char ifNoneMatch[32] = "";
+    int fault = FAULT_NONE;
+
+    ++ totalRequests;
+
+    // Request line: GET <path>?<query> HTTP/1.1
+    char* path = strchr(req, ' ');
+    if(path == NULL) {
+
+        c->closeAfter = true;
+        return;
+    }
+    ++ path;
+    char* end = strchr(path, ' ');
+    if(end != NULL) *end = '\0';
+
+    char* query = strchr(path, '?');
+    if(query == NULL) query = path + strlen(path);
+
+    // Fault mode
+    if(strncmp(path, "/slow", 5) == 0) fault = FAULT_SLOW;
+    else if(strncmp(path, "/stall", 6) == 0) fault = FAULT_STALL;
+    else if(strncmp(path, "/truncate", 9) == 0) fault = FAULT_TRUNCATE;
+    else if(strncmp(path, "/oversize", 9) == 0) fault = FAULT_OVERSIZE;
+    else if(strncmp(path, "/many", 5) == 0) fault = FAULT_MANY;
+    else if(strncmp(path, "/large", 6) == 0) fault = FAULT_LARGE;
+    else if(strncmp(path, "/error", 6) == 0) fault = FAULT_ERROR;
+    else if(strncmp(path, "/nobatch", 8) == 0) fault = FAULT_NOBATCH;
+    else if(strncmp(path, "/portal", 7) == 0) fault = FAULT_PORTAL;
+
+    // Headers (after the request line)
+    char* headers = end != NULL ? end+1 : query;
+    char* inm = strstr(headers, "If-None-Match: ");
+    if(inm != NULL)
+        sscanf(inm + 15, "%31s", ifNoneMatch);
+
+    if(fault == FAULT_STALL) {
+
+        c->stalled = true;
+        return;
+    }
+
+    int len = 0;
+    int status = 200;
+    if(fault == FAULT_ERROR) {
+
+        status = 500;
+        len = snprintf(body, sizeof(body), "Internal error\n");
+    }
+    // The request never gets to the server
+    else if(fault == FAULT_PORTAL) {
+
+        len = snprintf(body, sizeof(body),
+            "<html>\n<body>Log in to continue</body>\n</html>\n");
+    }
+    else {
+
+        bool ok = handle_query(query, fault);
+        len = snprintf(body, sizeof(body), "%s\n", ok ? "true" : "false");
+        len += write_rows(body + len, (int)sizeof(body) - len, fault);
+    }
+
+    snprintf(etag, sizeof(etag), "\"%d\"", version);
+    if(status == 200 && strcmp(ifNoneMatch, etag) == 0) {
+
+        status = 304;
+        len = 0;
+    }
+
+    // Claim the full length, but send half of it
+    int sent = len;
+    if(fault == FAULT_TRUNCATE) {
+
+        sent = len / 2;
+        c->closeAfter = true;
+    }
+
+    c->responseLength = snprintf(c->response, RESPONSE_SIZE,
+        "HTTP/1.1 %d %s\r\n"
+        "Content-Type: %s\r\n"
+        "Content-Length: %d\r\n"
+        "ETag: %s\r\n"
+        "\r\n",
+        status, status == 200 ? "OK" : (status == 304 ? "Not Modified" : "Error"),
+        fault == FAULT_PORTAL ? "text/html" : "text/plain", len, etag);
+    memcpy(c->response + c->responseLength, body, sent);
+    c->responseLength += sent;
+    c->responseSent = 0;
+    c->sendAt = fault == FAULT_SLOW ? now_ms() + slowDelay : 0;
+}
+
+
+// Close a connection
+static void close_connection(int i) {
+
+    close(connections[i].fd);
+    connections[i] = connections[-- connectionCount];
+}
+
+
+// Read from a connection. Returns false if closed
+static bool read_connection(CONNECTION* c) {
+
+    int n = (int)recv(c->fd, c->request + c->requestLength,
+        REQUEST_SIZE-1 - c->requestLength, 0);
+    if(n <= 0) return false;
+
+    c->requestLength += n;
+    c->request[c->requestLength] = '\0';
+
+    // Wait for the whole header, one request at a time
+    char* end = strstr(c->request, "\r\n\r\n");
+    if(end == NULL)
+        return c->requestLength < REQUEST_SIZE-1;
+
+    *end = '\0';
+    handle_request(c, c->request);
+
+    // Keep what came after it (pipelining is not
+    // supported, so it should be nothing)
+    int used = (int)(end + 4 - c->request);
+    memmove(c->request, c->request + used, c->requestLength - used);
+    c->requestLength -= used;
+
+    return true;
+}
+
+
+// Write to a connection. Returns false if closed
+static bool write_connection(CONNECTION* c) {
+
+    int n = (int)send(c->fd, c->response + c->responseSent,
+        c->responseLength - c->responseSent, MSG_NOSIGNAL);
+    if(n < 0) return false;
+
+    c->responseSent += n;
+    if(c->responseSent < c->responseLength) return true;
+
+    c->responseLength = 0;
+    c->responseSent = 0;
+    return !c->closeAfter;
+}
+
+
+// Main
+int main(int argc, char** argv) {
+
+    int port = argc > 1 ? atoi(argv[1]) : 8000;
+    if(argc > 2) slowDelay = atoi(argv[2]);
+
+    signal(SIGPIPE, SIG_IGN);
+
+    int server = socket(AF_INET, SOCK_STREAM, 0);
+    int yes = 1;
+    setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((unsigned short)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if(server < 0 || bind(server, (struct sockaddr*)&addr, sizeof(addr)) != 0
+     || listen(server, 64) != 0) {
+
+        perror("lbserver");
+        return 1;
+    }
+    printf("Leaderboard stand-in server on http://127.0.0.1:%d\n", port);
+    fflush(stdout);
+
+    struct pollfd fds[MAX_CONNECTIONS+1];
+    long long t;
+    int timeout, i, fd;
+    bool stalled;
+    CONNECTION* c;
+
+    while(true) {
+
+        // Wake up for the delayed responses
+        t = now_ms();
+        timeout = -1;
+        fds[0].fd = server;
+        fds[0].events = POLLIN;
+        for(i = 0; i < connectionCount; ++ i) {
+
+            c = &connections[i];
+            fds[i+1].fd = c->fd;
+            fds[i+1].events = POLLIN;
+
+            if(c->responseLength > 0) {
+
+                if(c->sendAt <= t)
+                    fds[i+1].events |= POLLOUT;
+                else if(timeout < 0 || c->sendAt - t < timeout)
+                    timeout = (int)(c->sendAt - t);
+            }
+        }
+
+        if(poll(fds, connectionCount+1, timeout) < 0)
+            continue;
+
+        // Serve the connections (backwards, since
+        // closing moves the last one)
+        for(i = connectionCount-1; i >= 0; -- i) {
+
+            // Reading may stall the connection, so
+            // look at the old state
+            c = &connections[i];
+            stalled = c->stalled;
+            if(((fds[i+1].revents & (POLLIN | POLLHUP | POLLERR))
+             && c->responseLength == 0 && !stalled && !read_connection(c))
+             || ((fds[i+1].revents & POLLOUT) && !write_connection(c))
+             || (stalled && (fds[i+1].revents & (POLLHUP | POLLERR)))) {
+
+                close_connection(i);
+            }
+            // The peer of a stalled connection gives up
+            else if(stalled && (fds[i+1].revents & POLLIN)) {
+
+                char tmp[256];
+                if(recv(c->fd, tmp, sizeof(tmp), 0) <= 0)
+                    close_connection(i);
+            }
+        }
+
+        // New connections
+        if(fds[0].revents & POLLIN) {
+
+            fd = accept(server, NULL, NULL);
+            if(fd < 0) continue;
+
+            if(connectionCount >= MAX_CONNECTIONS) {
+
+                close(fd);
+                continue;
+            }
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+            c = &connections[connectionCount ++];
+            memset(c, 0, sizeof(CONNECTION));
+            c->fd = fd;
+
+            ++ totalConnections;
+            printf("Connections: %ld, requests: %ld\n", totalConnections, totalRequests);
+            fflush(stdout);
+        }
+    }
+
+    return 0;
+}